@@ -0,0 +1,13 @@
+#version 460 core
+// Vertex pulling variant of debug_vs.glsl, CGFetchAttribute is prepended by the OpenGL backend
+
+out VS_OUT
+{
+	vec4 color;
+} vs_out;
+
+void main()
+{
+	gl_Position = vec4(CGFetchAttribute(0u).xyz, 1.0);
+	vs_out.color = CGFetchAttribute(1u);
+}
\ No newline at end of file
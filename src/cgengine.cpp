@@ -7,22 +7,49 @@ using namespace cg::renderer;
 // cgengine.cpp
 namespace cg
 {
-	static bool InitGraphicsAPI(const CGRendererType rendererType, const bool debug, CGRenderFunctions& function);
+	static bool InitGraphicsAPI(const CGRendererType rendererType, const bool debug, const bool headless, CGRenderFunctions& function);
 	static bool CreateWindow(const int32_t width, const int32_t height, core::CGWindow& window);
 	static bool SetupGraphicsAPI(const CGEngineCreateInfo& info, const core::CGWindow& window, CGRenderer& renderer);
 
+	static_assert(io::CG_MAX_IMAGE_MIPS <= CG_MAX_TEXTURE_MIPS, "Decoded mip chains must fit a texture");
+
+	static constexpr uint32_t CG_ATLAS_IMAGE_TAG = 0x80000000u; // Set in the tag of jobs packed into an atlas, next to the image
+
 	CGEngine::CGEngine(const CGEngineCreateInfo& info)
 	{
+#if defined(CG_RENDERER_STATIC)
+		// The backend is fixed at build time, the requested one is only a hint
+		if (info.rendererType != CG_STATIC_RENDERER_TYPE)
+		{
+			printf("Renderer type overridden by the static backend");
+		}
+
+		m_renderer.type = CG_STATIC_RENDERER_TYPE;
+#else
 		m_renderer.type = info.rendererType;
+#endif
+
+		m_useRenderThread = info.renderThread;
+		m_framesInFlight = info.framesInFlight < 1u ? 1u : (info.framesInFlight > CG_MAX_FRAMES_IN_FLIGHT ? CG_MAX_FRAMES_IN_FLIGHT : info.framesInFlight);
 
 		m_renderer.device.debug = info.debug;
+		m_renderer.resourcePool.texturePool.uploadBudget = info.textureUploadBudget;
 
-		if (!InitGraphicsAPI(info.rendererType, info.debug, m_renderer.functions))
+		if (!InitGraphicsAPI(GetRendererType(m_renderer), info.debug, info.headless, m_renderer.functions))
 		{
 			printf("Init Graphics API failed");
 		}
 
-		if (!CreateWindow(static_cast<int32_t>(info.resolution.width), static_cast<int32_t>(info.resolution.height), m_window))
+		// Headless backends only need the dimensions for their framebuffer and viewports
+		const CGRendererType rendererType = GetRendererType(m_renderer);
+
+		// Headless Vulkan renders offscreen without a surface, so it needs no window either
+		if (rendererType == CGRendererType::Null || rendererType == CGRendererType::Software || (rendererType == CGRendererType::Vulkan && info.headless))
+		{
+			m_window.width = static_cast<int32_t>(info.resolution.width);
+			m_window.height = static_cast<int32_t>(info.resolution.height);
+		}
+		else if (!CreateWindow(static_cast<int32_t>(info.resolution.width), static_cast<int32_t>(info.resolution.height), m_window))
 		{
 			printf("Create Window failed");
 		}
@@ -31,9 +58,14 @@ namespace cg
 		{
 			printf("Setup Graphics API failed");
 		}
+
+		if (info.shaderHotReload)
+		{
+			m_shaderHotReload = io::StartFileWatcher(m_shaderWatcher);
+		}
 	}
 
-	bool InitGraphicsAPI(const CGRendererType rendererType, const bool debug, CGRenderFunctions& functions)
+	bool InitGraphicsAPI(const CGRendererType rendererType, const bool debug, const bool headless, CGRenderFunctions& functions)
 	{
 		switch (rendererType)
 		{
@@ -43,7 +75,12 @@ namespace cg
 			}
 			case CGRendererType::Direct3D11:
 			{
+#if defined(CG_HAS_D3D11)
 				return D3D11::Init(functions);
+#else
+				printf("Built without Direct3D 11\n");
+				return false;
+#endif
 			}
 			case CGRendererType::Direct3D12:
 			{
@@ -51,11 +88,24 @@ namespace cg
 			}
 			case CGRendererType::OpenGL:
 			{
-				return OpenGL::Init(debug, functions);
+				return OpenGL::Init(debug, headless, functions);
 			}
 			case CGRendererType::Vulkan:
 			{
-				break;
+#if defined(CG_HAS_VULKAN)
+				return Vulkan::Init(debug, headless, functions);
+#else
+				printf("Built without the Vulkan SDK\n");
+				return false;
+#endif
+			}
+			case CGRendererType::Null:
+			{
+				return Null::Init(functions);
+			}
+			case CGRendererType::Software:
+			{
+				return Software::Init(functions);
 			}
 		}
 
@@ -69,7 +119,7 @@ namespace cg
 
 	bool SetupGraphicsAPI(const CGEngineCreateInfo& info, const core::CGWindow& window, CGRenderer& renderer)
 	{
-		switch (info.rendererType)
+		switch (GetRendererType(renderer))
 		{
 			case CGRendererType::None:
 			{
@@ -77,6 +127,7 @@ namespace cg
 			}
 			case CGRendererType::Direct3D11:
 			{
+#if defined(CG_HAS_D3D11)
 				if (!D3D11::CreateDeviceAndContext(info.debug, renderer.device, renderer.context))
 				{
 					return false;
@@ -111,6 +162,9 @@ namespace cg
 				}
 
 				break;
+#else
+				return false;
+#endif
 			}
 			case CGRendererType::Direct3D12:
 			{
@@ -118,7 +172,7 @@ namespace cg
 			}
 			case CGRendererType::OpenGL:
 			{
-				if (!OpenGL::CreateDeviceAndContext(info.debug, window, renderer.device, renderer.context))
+				if (!OpenGL::CreateDeviceAndContext(info.debug, info.headless, info.vertexPulling, info.programCache, window, renderer.device, renderer.context))
 				{
 					return false;
 				}
@@ -127,6 +181,33 @@ namespace cg
 			}
 			case CGRendererType::Vulkan:
 			{
+#if defined(CG_HAS_VULKAN)
+				if (!Vulkan::CreateDeviceAndContext(info.debug, info.headless, window, renderer.device, renderer.context))
+				{
+					return false;
+				}
+
+				break;
+#else
+				return false;
+#endif
+			}
+			case CGRendererType::Null:
+			{
+				if (!Null::CreateDeviceAndContext(renderer.device, renderer.context))
+				{
+					return false;
+				}
+
+				break;
+			}
+			case CGRendererType::Software:
+			{
+				if (!Software::CreateDeviceAndContext(window, renderer.device, renderer.context))
+				{
+					return false;
+				}
+
 				break;
 			}
 		}
@@ -134,16 +215,373 @@ namespace cg
 		return true;
 	}
 
+	void CGEngine::RenderFrame(const uint8_t pool)
+	{
+		// Runs on the thread that owns the context, before any command of the frame uses a program
+		if (m_shaderHotReload)
+		{
+			FrameOps::ReloadShaderPrograms(io::TakeChangedFiles(m_shaderWatcher), m_renderer);
+		}
+
+		StreamTextures();
+
+#if defined(CG_RENDERER_STATIC)
+		ExecuteRenderCommands<CG_STATIC_RENDERER_TYPE>(pool, m_renderer);
+
+		FrameOps::EndFrame<CG_STATIC_RENDERER_TYPE>(m_renderer);
+
+		FrameOps::Present<CG_STATIC_RENDERER_TYPE>(m_renderer);
+#else
+		ExecuteRenderCommands(pool, m_renderer);
+
+		FrameOps::EndFrame(m_renderer);
+
+		FrameOps::Present(m_renderer);
+#endif
+	}
+
+	bool CGEngine::WatchShaderProgram(const uint32_t program, const uint8_t count, const CGShaderDesc descs[])
+	{
+		if (!m_shaderHotReload || count < 1 || count > CG_MAX_PROGRAM_SHADERS || descs == nullptr)
+		{
+			return false;
+		}
+
+		CGShaderDesc watched[CG_MAX_PROGRAM_SHADERS] = {};
+		uint64_t files = 0ull;
+
+		// Recompiles read the watcher's copy of each path, the caller's strings may be gone by then
+		for (uint8_t i = 0u; i < count; ++i)
+		{
+			uint32_t file = 0u;
+
+			if (!io::WatchFile(descs[i].filename, m_shaderWatcher, file))
+			{
+				return false;
+			}
+
+			watched[i] = descs[i];
+			watched[i].filename = m_shaderWatcher.paths[file];
+			files |= 1ull << file;
+		}
+
+		return DeviceOps::WatchShaderProgram(program, count, watched, files, m_renderer);
+	}
+
+	bool CGEngine::StartImageLoader()
+	{
+		if (m_imageLoader.workerCount > 0u)
+		{
+			return true;
+		}
+
+		// Decoding competes with the main and render threads, leave them a core
+		const uint32_t cores = std::thread::hardware_concurrency();
+		const uint32_t workers = cores > 2u ? cores - 2u : 1u;
+
+		return io::StartImageLoader(static_cast<uint8_t>(workers < io::CG_MAX_IMAGE_WORKERS ? workers : io::CG_MAX_IMAGE_WORKERS), m_imageLoader);
+	}
+
+	bool CGEngine::LoadTexture(const char* filename, uint32_t& texture)
+	{
+		if (filename == nullptr || !StartImageLoader())
+		{
+			return false;
+		}
+
+		uint32_t reserved = 0u;
+		uint32_t job = 0u;
+
+		if (!DeviceOps::ReserveTexture(m_renderer, reserved))
+		{
+			return false;
+		}
+
+		if (!io::QueueImage(filename, reserved, m_imageLoader, job))
+		{
+			m_renderer.resourcePool.texturePool.textures[reserved].state.store(CGTextureState::Failed, std::memory_order_release);
+			return false;
+		}
+
+		texture = reserved;
+
+		return true;
+	}
+
+	bool CGEngine::LoadTexture(const char* filename, const uint32_t atlas, uint32_t& image)
+	{
+		if (filename == nullptr || atlas >= m_renderer.resourcePool.atlasPool.count || m_atlasImageCount + 1u > CG_MAX_ATLAS_IMAGES || !StartImageLoader())
+		{
+			return false;
+		}
+
+		// Set up before the job is queued, the context thread may finish it right away
+		CGAtlasImage& atlasImage = m_atlasImages[m_atlasImageCount];
+		atlasImage.atlas = atlas;
+		atlasImage.state.store(CGTextureState::Loading, std::memory_order_relaxed);
+
+		uint32_t job = 0u;
+
+		if (!io::QueueImage(filename, CG_ATLAS_IMAGE_TAG | m_atlasImageCount, m_imageLoader, job))
+		{
+			atlasImage.state.store(CGTextureState::None, std::memory_order_relaxed);
+			return false;
+		}
+
+		image = m_atlasImageCount;
+		m_atlasImageCount++;
+
+		return true;
+	}
+
+	bool CGEngine::GetAtlasRegion(const uint32_t image, CGAtlasRegion& region) const
+	{
+		if (image >= m_atlasImageCount || m_atlasImages[image].state.load(std::memory_order_acquire) != CGTextureState::Resident)
+		{
+			return false;
+		}
+
+		region = m_atlasImages[image].region;
+
+		return true;
+	}
+
+	// Runs on the thread that owns the context, decoded images get their storage before the frame's commands execute
+	void CGEngine::StreamTextures()
+	{
+		const uint32_t count = m_imageLoader.count.load(std::memory_order_acquire);
+
+		for (uint32_t job = m_imageLoader.first.load(std::memory_order_relaxed); job != count; ++job)
+		{
+			const io::CGImageJob& entry = m_imageLoader.jobs[job % io::CG_MAX_IMAGE_JOBS];
+			const uint32_t tag = entry.tag;
+
+			io::CGImage image = {};
+
+			if ((tag & CG_ATLAS_IMAGE_TAG) != 0u)
+			{
+				CGAtlasImage& atlasImage = m_atlasImages[tag & ~CG_ATLAS_IMAGE_TAG];
+
+				switch (io::TakeImage(job, m_imageLoader, image))
+				{
+					case io::CGImageStatus::Ready:
+					{
+						CGAtlasRegion region = {};
+
+						if (!DeviceOps::AllocateAtlasRegion(atlasImage.atlas, image.width, image.height, m_renderer, region) ||
+							!DeviceOps::UploadAtlasRegion(region, image.mipCount, std::move(image.pixels), m_renderer))
+						{
+							printf("Failed to pack image %s\n", entry.path);
+							atlasImage.state.store(CGTextureState::Failed, std::memory_order_release);
+							break;
+						}
+
+						atlasImage.region = region;
+						atlasImage.state.store(CGTextureState::Resident, std::memory_order_release);
+						break;
+					}
+					case io::CGImageStatus::Failed:
+					{
+						atlasImage.state.store(CGTextureState::Failed, std::memory_order_release);
+						break;
+					}
+					default:
+					{
+						break;
+					}
+				}
+
+				continue;
+			}
+
+			const uint32_t texture = tag;
+
+			switch (io::TakeImage(job, m_imageLoader, image))
+			{
+				case io::CGImageStatus::Ready:
+				{
+					CGTextureDesc desc = {};
+					desc.width = image.width;
+					desc.height = image.height;
+					desc.mipCount = image.mipCount;
+
+					if (!DeviceOps::CreateTexture(texture, desc, std::move(image.pixels), m_renderer))
+					{
+						printf("Failed to create texture %s\n", entry.path);
+					}
+
+					break;
+				}
+				case io::CGImageStatus::Failed:
+				{
+					m_renderer.resourcePool.texturePool.textures[texture].state.store(CGTextureState::Failed, std::memory_order_release);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+		}
+
+		// Done with the paths and tags of every job taken above
+		io::ReleaseImages(m_imageLoader);
+
+		FrameOps::StreamTextures(m_renderer);
+	}
+
 	bool CGEngine::IsRunning() const
 	{
+		// Headless engines run until the application stops submitting frames
+		if (!m_window.winptr)
+		{
+			return true;
+		}
+
 		return !ShouldCloseCGWindow(m_window.winptr);
 	}
 
+	void CGEngine::BeginFrame()
+	{
+		if (!m_useRenderThread)
+		{
+			// Rotate through the pools so a frame never records into one the GPU may still be reading
+			const uint8_t pool = static_cast<uint8_t>((m_renderer.resourcePool.recordPool + 1u) % (m_framesInFlight + 1u));
+
+			FrameOps::WaitForFrame(pool, m_renderer, UINT64_MAX);
+
+			m_renderer.resourcePool.recordPool = pool;
+			ResetRenderCommands(pool, m_renderer);
+
+			return;
+		}
+
+		if (!m_renderThreadRunning.load(std::memory_order_acquire))
+		{
+			StartRenderThread();
+		}
+
+		// Wait for the render thread to retire a frame once the in-flight limit is reached
+		uint8_t frame = 0u;
+		while (!FrameOps::PopFrame(m_freeQueue, frame))
+		{
+			std::this_thread::yield();
+		}
+
+		m_renderer.resourcePool.recordPool = frame;
+		ResetRenderCommands(frame, m_renderer);
+	}
+
+	void CGEngine::SubmitFrame()
+	{
+		// Buffers that did not fit stay published and are merged into a later frame
+		if (!MergeCommandBuffers(m_renderer))
+		{
+			printf("Failed to merge every command buffer into the frame\n");
+		}
+
+		SortRenderCommands(m_renderer);
+
+		if (!m_useRenderThread)
+		{
+			RenderFrame(m_renderer.resourcePool.recordPool);
+			return;
+		}
+
+		// Never fails: there are never more frames than queue slots
+		FrameOps::PushFrame(m_renderer.resourcePool.recordPool, m_submitQueue);
+	}
+
+	void CGEngine::StartRenderThread()
+	{
+		// One pool per frame in flight plus the one being recorded
+		for (uint8_t i = 0u; i < m_framesInFlight + 1u; ++i)
+		{
+			FrameOps::PushFrame(i, m_freeQueue);
+		}
+
+		// Hand the graphics context over to the render thread
+		ContextOps::MakeCurrent(false, m_renderer);
+
+		m_renderThreadRunning.store(true, std::memory_order_release);
+		m_renderThread = std::thread(&CGEngine::RenderThreadMain, this);
+	}
+
+	void CGEngine::StopRenderThread()
+	{
+		if (!m_renderThread.joinable())
+		{
+			return;
+		}
+
+		m_renderThreadRunning.store(false, std::memory_order_release);
+		m_renderThread.join();
+
+		ContextOps::MakeCurrent(true, m_renderer);
+	}
+
+	void CGEngine::RenderThreadMain()
+	{
+		ContextOps::MakeCurrent(true, m_renderer);
+
+		// Executed frames go back to the main thread once the GPU is done with them, oldest first
+		uint8_t retiring[CG_MAX_FRAME_POOLS] = {};
+		uint8_t retiringCount = 0u;
+
+		const auto RetireFrames = [this, &retiring, &retiringCount](const uint64_t timeout)
+		{
+			uint8_t retired = 0u;
+
+			while (retired < retiringCount && FrameOps::WaitForFrame(retiring[retired], m_renderer, timeout))
+			{
+				FrameOps::PushFrame(retiring[retired], m_freeQueue);
+				retired++;
+			}
+
+			for (uint8_t i = retired; i < retiringCount; ++i)
+			{
+				retiring[i - retired] = retiring[i];
+			}
+
+			retiringCount = static_cast<uint8_t>(retiringCount - retired);
+		};
+
+		while (true)
+		{
+			RetireFrames(0ull);
+
+			uint8_t frame = 0u;
+
+			if (!FrameOps::PopFrame(m_submitQueue, frame))
+			{
+				// Drain every submitted frame before shutting down
+				if (!m_renderThreadRunning.load(std::memory_order_acquire))
+				{
+					break;
+				}
+
+				std::this_thread::yield();
+				continue;
+			}
+
+			RenderFrame(frame);
+
+			retiring[retiringCount] = frame;
+			retiringCount++;
+		}
+
+		RetireFrames(UINT64_MAX);
+
+		ContextOps::MakeCurrent(false, m_renderer);
+	}
+
 	CGEngine::~CGEngine()
 	{
-		m_renderer.functions.shutdown();
+		StopRenderThread();
+		io::StopFileWatcher(m_shaderWatcher);
+		io::StopImageLoader(m_imageLoader);
 
-		switch (m_renderer.type)
+		switch (GetRendererType(m_renderer))
 		{
 			case CGRendererType::None:
 			{
@@ -151,6 +589,7 @@ namespace cg
 			}
 			case CGRendererType::Direct3D11:
 			{
+#if defined(CG_HAS_D3D11)
 				D3D11::DeviceOps::DestroyResources(m_renderer.resourcePool);
 
 				D3D11::ContextOps::DestroyContext(m_renderer.context);
@@ -161,7 +600,7 @@ namespace cg
 				{
 					D3D11::DebugOps::ReportLiveObjects(m_renderer.device);
 				}
-
+#endif
 				break;
 			}
 			case CGRendererType::Direct3D12:
@@ -170,13 +609,35 @@ namespace cg
 			}
 			case CGRendererType::OpenGL:
 			{
-				//renderer::ContextOps::DestroyOpenGLContext(m_renderContext);
+				OpenGL::ContextOps::DestroyContext(m_renderer.context);
 				break; 
 			}
 			case CGRendererType::Vulkan:
 			{
+#if defined(CG_HAS_VULKAN)
+				Vulkan::DeviceOps::DestroyResources(m_renderer.device, m_renderer.resourcePool);
+
+				Vulkan::ContextOps::DestroyContext(m_renderer.context);
+
+				Vulkan::DestroyDevice(m_renderer.device);
+#endif
+				break;
+			}
+			case CGRendererType::Null:
+			{
+				break;
+			}
+			case CGRendererType::Software:
+			{
+				Software::DeviceOps::DestroyResources(m_renderer.resourcePool);
+
+				Software::ContextOps::DestroyContext(m_renderer.context);
+
 				break;
 			}
 		}
+
+		// Backend resources are released first, they may still need the context
+		m_renderer.functions.shutdown();
 	}
 }
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
+
+#include "io/filewatch.h"
+#include "io/image.h"
 #include "platform/window.h"
 #include "renderer/renderer.h"
 
@@ -16,9 +21,26 @@ namespace cg
 	{
 		CGRendererType rendererType = CGRendererType::None;
 		CGResolution resolution;
+		uint8_t framesInFlight = 2u; // Frames the main thread may run ahead of the render thread
+		bool renderThread = false;	 // Execute and present frames on a dedicated render thread
+		bool headless = false;		 // Render offscreen without showing a window (OpenGL; Null and Software always are)
+		bool vertexPulling = false;	 // Vertex shaders fetch from storage buffers, no vertex array switches (OpenGL)
+		const char* programCache = nullptr; // Directory for program binaries, nullptr disables the cache (OpenGL)
+		bool shaderHotReload = false; // Recompile watched shader programs when their sources change (OpenGL)
+		uint32_t textureUploadBudget = renderer::CG_TEXTURE_UPLOAD_BUDGET; // Texel bytes streamed to the GPU per frame
 		bool debug = false;
 	};
 
+	constexpr uint32_t CG_MAX_ATLAS_IMAGES = 1024u;
+
+	// Image loaded into an atlas, its region is only written before the state is published
+	struct CGAtlasImage
+	{
+		renderer::CGAtlasRegion region = {};
+		uint32_t atlas = 0u;
+		std::atomic<renderer::CGTextureState> state = renderer::CGTextureState::None;
+	};
+
 	class CGEngine
 	{
 	public:
@@ -27,13 +49,51 @@ namespace cg
 
 		bool IsRunning() const;
 
+		// Selects the command pool that the next frame records into. Blocks while the maximum number
+		// of frames are in flight, until the GPU is done with the frame that last used the pool.
+		void BeginFrame();
+		// Sorts and submits the recorded frame, either inline or by handing it to the render thread
+		void SubmitFrame();
+
+		// Recompiles the program in the background whenever one of its shader sources changes and swaps
+		// it in between frames. The handle stays the same, a failed recompile keeps the previous program.
+		// Only the files themselves are watched, not the files they include. Defines have to outlive the engine.
+		bool WatchShaderProgram(const uint32_t program, const uint8_t count, const renderer::CGShaderDesc descs[]);
+		// Decodes the image (binary PPM or TGA) and builds its mips on worker threads, the handle can be bound
+		// right away. Its levels are streamed in coarsest first between frames, within the upload budget.
+		bool LoadTexture(const char* filename, uint32_t& texture);
+		// Decodes the image like above and packs it into an atlas made with DeviceOps::CreateTextureAtlas, so
+		// it shares the atlas's binding with every other image in it. Poll GetAtlasRegion for where it ended up.
+		bool LoadTexture(const char* filename, const uint32_t atlas, uint32_t& image);
+		// False until the image is packed, its texels follow within the upload budget
+		bool GetAtlasRegion(const uint32_t image, renderer::CGAtlasRegion& region) const;
+
 		const renderer::CGRenderer& GetRenderer() const { return m_renderer; }
 		renderer::CGRenderer& GetRenderer() { return m_renderer; }
 
 		const core::CGWindow& GetWindow() const { return m_window; }
 		core::CGWindow& GetWindow() { return m_window; }
 	private:
+		void StartRenderThread();
+		void StopRenderThread();
+		void RenderThreadMain();
+		void RenderFrame(const uint8_t pool);
+		bool StartImageLoader();
+		void StreamTextures();
+
 		renderer::CGRenderer m_renderer;
 		core::CGWindow m_window;
+
+		renderer::CGFrameQueue m_submitQueue; // Main -> render thread, recorded frames
+		renderer::CGFrameQueue m_freeQueue;	  // Render -> main thread, executed frames
+		io::CGFileWatcher m_shaderWatcher;	  // Shader sources of watched programs
+		io::CGImageLoader m_imageLoader;	  // Texture images, started with the first LoadTexture
+		CGAtlasImage m_atlasImages[CG_MAX_ATLAS_IMAGES]; // Handed out by LoadTexture, never reused
+		uint32_t m_atlasImageCount = 0u;
+		std::thread m_renderThread;
+		std::atomic<bool> m_renderThreadRunning = false;
+		uint8_t m_framesInFlight = 1u;
+		bool m_useRenderThread = false;
+		bool m_shaderHotReload = false;
 	};
 }
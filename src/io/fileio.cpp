@@ -1,13 +1,33 @@
+#include <cerrno>
 #include <cstdio>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #include "fileio.h"
 
 // fileio.cpp
 namespace cg::io
 {
+	static FILE* OpenFile(const char* path, const char* mode)
+	{
+		FILE* file = nullptr;
+
+#ifdef _WIN32
+		fopen_s(&file, path, mode);
+#else
+		file = fopen(path, mode);
+#endif
+
+		return file;
+	}
+
 	CGFile ReadFile(const char* path)
 	{
-		FILE* file;
-		fopen_s(&file, path, "rb");
+		FILE* file = OpenFile(path, "rb");
 
 		if (!file)
 		{
@@ -33,4 +53,30 @@ namespace cg::io
 
 		return { std::move(buffer), size };
 	}
+
+	bool WriteFile(const char* path, const void* data, const size_t size)
+	{
+		FILE* file = OpenFile(path, "wb");
+
+		if (!file)
+		{
+			return false;
+		}
+
+		const size_t written = fwrite(data, 1, size, file);
+		fclose(file);
+
+		return written == size;
+	}
+
+	bool MakeDirectory(const char* path)
+	{
+#ifdef _WIN32
+		const int result = _mkdir(path);
+#else
+		const int result = mkdir(path, 0755);
+#endif
+
+		return result == 0 || errno == EEXIST;
+	}
 }
@@ -12,4 +12,7 @@ namespace cg::io
 	};
 
 	CGFile ReadFile(const char* path);
+	bool WriteFile(const char* path, const void* data, const size_t size);
+	// Succeeds if the directory exists afterwards, parent directories are not created
+	bool MakeDirectory(const char* path);
 }
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "filewatch.h"
+
+// filewatch.cpp
+namespace cg::io
+{
+	static constexpr int CG_WATCH_INTERVAL_MS = 100;
+
+	static int64_t GetModificationTime(const char* path)
+	{
+		struct stat info = {};
+
+		if (stat(path, &info) != 0)
+		{
+			return 0;
+		}
+
+		return static_cast<int64_t>(info.st_mtime);
+	}
+
+	static const char* GetFileName(const char* path)
+	{
+		const char* slash = strrchr(path, '/');
+		const char* backslash = strrchr(path, '\\');
+
+		if (backslash > slash)
+		{
+			slash = backslash;
+		}
+
+		return slash ? slash + 1 : path;
+	}
+
+#ifdef __linux__
+	// Editors often save to a temporary file and rename it over the original, which replaces the inode.
+	// Watching the directories instead of the files sees those saves as well.
+	static void WatchThreadMain(CGFileWatcher& watcher)
+	{
+		alignas(inotify_event) char events[4096];
+
+		while (watcher.running.load(std::memory_order_acquire))
+		{
+			pollfd fd = { watcher.handle, POLLIN, 0 };
+
+			if (poll(&fd, 1, CG_WATCH_INTERVAL_MS) < 1)
+			{
+				continue;
+			}
+
+			const ssize_t size = read(watcher.handle, events, sizeof(events));
+			const uint32_t count = watcher.count.load(std::memory_order_acquire);
+
+			uint64_t changed = 0ull;
+
+			for (ssize_t offset = 0; offset < size;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(events + offset);
+				offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+				for (uint32_t i = 0u; event->len > 0u && i < count; ++i)
+				{
+					if (watcher.watches[i] == event->wd && strcmp(event->name, GetFileName(watcher.paths[i])) == 0)
+					{
+						changed |= 1ull << i;
+					}
+				}
+			}
+
+			watcher.changed.fetch_or(changed, std::memory_order_release);
+		}
+	}
+#else
+	static void WatchThreadMain(CGFileWatcher& watcher)
+	{
+		while (watcher.running.load(std::memory_order_acquire))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(CG_WATCH_INTERVAL_MS));
+
+			const uint32_t count = watcher.count.load(std::memory_order_acquire);
+
+			uint64_t changed = 0ull;
+
+			for (uint32_t i = 0u; i < count; ++i)
+			{
+				const int64_t stamp = GetModificationTime(watcher.paths[i]);
+
+				if (stamp != 0 && stamp != watcher.stamps[i])
+				{
+					watcher.stamps[i] = stamp;
+					changed |= 1ull << i;
+				}
+			}
+
+			watcher.changed.fetch_or(changed, std::memory_order_release);
+		}
+	}
+#endif
+
+	bool StartFileWatcher(CGFileWatcher& watcher)
+	{
+		if (watcher.running.load(std::memory_order_acquire))
+		{
+			return true;
+		}
+
+#ifdef __linux__
+		watcher.handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		if (watcher.handle < 0)
+		{
+			printf("Failed to create an inotify instance\n");
+			return false;
+		}
+#endif
+
+		watcher.running.store(true, std::memory_order_release);
+		watcher.thread = std::thread(WatchThreadMain, std::ref(watcher));
+
+		return true;
+	}
+
+	void StopFileWatcher(CGFileWatcher& watcher)
+	{
+		if (!watcher.thread.joinable())
+		{
+			return;
+		}
+
+		watcher.running.store(false, std::memory_order_release);
+		watcher.thread.join();
+
+#ifdef __linux__
+		close(watcher.handle);
+		watcher.handle = -1;
+#endif
+	}
+
+	bool WatchFile(const char* path, CGFileWatcher& watcher, uint32_t& index)
+	{
+		const uint32_t count = watcher.count.load(std::memory_order_relaxed);
+
+		for (uint32_t i = 0u; i < count; ++i)
+		{
+			if (strcmp(watcher.paths[i], path) == 0)
+			{
+				index = i;
+				return true;
+			}
+		}
+
+		const size_t length = strlen(path);
+
+		if (count >= CG_MAX_WATCHED_FILES || length >= CG_MAX_WATCH_PATH)
+		{
+			printf("Cannot watch %s\n", path);
+			return false;
+		}
+
+		memcpy(watcher.paths[count], path, length + 1u);
+		watcher.stamps[count] = GetModificationTime(path);
+
+#ifdef __linux__
+		char directory[CG_MAX_WATCH_PATH] = ".";
+		const size_t directoryLength = static_cast<size_t>(GetFileName(path) - path);
+
+		if (directoryLength > 0u)
+		{
+			memcpy(directory, path, directoryLength);
+			directory[directoryLength] = '\0';
+		}
+
+		// A directory watched twice keeps its watch descriptor
+		watcher.watches[count] = inotify_add_watch(watcher.handle, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+		if (watcher.watches[count] < 0)
+		{
+			printf("Failed to watch directory %s\n", directory);
+			return false;
+		}
+#endif
+
+		index = count;
+		watcher.count.store(count + 1u, std::memory_order_release);
+
+		return true;
+	}
+
+	uint64_t TakeChangedFiles(CGFileWatcher& watcher)
+	{
+		return watcher.changed.exchange(0ull, std::memory_order_acquire);
+	}
+}
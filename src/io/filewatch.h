@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// filewatch.h
+namespace cg::io
+{
+	constexpr uint32_t CG_MAX_WATCHED_FILES = 64u; // One bit each in CGFileWatcher::changed
+	constexpr uint32_t CG_MAX_WATCH_PATH = 256u;
+
+	// Watches files from a thread of its own, inotify on Linux and modification times elsewhere.
+	// Files are only ever added by one thread, the watcher thread sees them once count is published.
+	struct CGFileWatcher
+	{
+		char paths[CG_MAX_WATCHED_FILES][CG_MAX_WATCH_PATH] = {};
+		int64_t stamps[CG_MAX_WATCHED_FILES] = {}; // Last modification time, polling watchers only
+		int watches[CG_MAX_WATCHED_FILES] = {};	   // inotify watch of the directory holding each file
+		std::thread thread;
+		std::atomic<uint64_t> changed = 0ull; // Bit per file, set by the watcher thread
+		std::atomic<uint32_t> count = 0u;
+		std::atomic<bool> running = false;
+		int handle = -1; // inotify instance
+	};
+
+	bool StartFileWatcher(CGFileWatcher& watcher);
+	void StopFileWatcher(CGFileWatcher& watcher);
+	// Files that are already watched hand out their existing index
+	bool WatchFile(const char* path, CGFileWatcher& watcher, uint32_t& index);
+	// Clears the changed bits it returns
+	uint64_t TakeChangedFiles(CGFileWatcher& watcher);
+}
@@ -0,0 +1,486 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "image.h"
+
+// image.cpp
+namespace cg::io
+{
+	static constexpr uint32_t CG_MAX_IMAGE_SIZE = 1u << (CG_MAX_IMAGE_MIPS - 1u);
+	static constexpr size_t CG_TGA_HEADER_SIZE = 18u;
+
+	static uint8_t GetMipCount(const uint32_t width, const uint32_t height)
+	{
+		uint32_t size = width > height ? width : height;
+		uint8_t count = 1u;
+
+		while (size > 1u)
+		{
+			size >>= 1u;
+			++count;
+		}
+
+		return count;
+	}
+
+	size_t GetMipChainSize(const uint32_t width, const uint32_t height, const uint8_t mipCount)
+	{
+		size_t size = 0u;
+
+		for (uint8_t level = 0u; level < mipCount; ++level)
+		{
+			const size_t w = width >> level ? width >> level : 1u;
+			const size_t h = height >> level ? height >> level : 1u;
+			size += w * h * 4u;
+		}
+
+		return size;
+	}
+
+	// Room for the whole mip chain is allocated up front so GenerateMips works in place
+	static bool AllocateImage(const uint32_t width, const uint32_t height, CGImage& image)
+	{
+		if (width == 0u || height == 0u || width > CG_MAX_IMAGE_SIZE || height > CG_MAX_IMAGE_SIZE)
+		{
+			printf("Unsupported image size %ux%u\n", width, height);
+			return false;
+		}
+
+		image.pixels = std::make_unique<uint8_t[]>(GetMipChainSize(width, height, GetMipCount(width, height)));
+		image.width = width;
+		image.height = height;
+		image.mipCount = 1u;
+
+		return true;
+	}
+
+	static bool ReadPPMValue(const CGFile& file, size_t& offset, uint32_t& value)
+	{
+		while (offset < file.size)
+		{
+			const char c = file.data[offset];
+
+			if (c == '#')
+			{
+				while (offset < file.size && file.data[offset] != '\n')
+				{
+					++offset;
+				}
+			}
+			else if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+			{
+				++offset;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (offset >= file.size || file.data[offset] < '0' || file.data[offset] > '9')
+		{
+			return false;
+		}
+
+		value = 0u;
+
+		while (offset < file.size && file.data[offset] >= '0' && file.data[offset] <= '9' && value <= CG_MAX_IMAGE_SIZE)
+		{
+			value = value * 10u + static_cast<uint32_t>(file.data[offset] - '0');
+			++offset;
+		}
+
+		return true;
+	}
+
+	static bool DecodePPM(const CGFile& file, CGImage& image)
+	{
+		size_t offset = 2u;
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		uint32_t maxValue = 0u;
+
+		if (!ReadPPMValue(file, offset, width) || !ReadPPMValue(file, offset, height) || !ReadPPMValue(file, offset, maxValue))
+		{
+			printf("Malformed PPM header\n");
+			return false;
+		}
+
+		if (maxValue != 255u)
+		{
+			printf("Only 8 bit PPM images are supported\n");
+			return false;
+		}
+
+		// A single whitespace character separates the header from the pixels
+		++offset;
+
+		if (!AllocateImage(width, height, image))
+		{
+			return false;
+		}
+
+		const size_t count = static_cast<size_t>(width) * height;
+
+		if (offset > file.size || file.size - offset < count * 3u)
+		{
+			printf("Truncated PPM image\n");
+			return false;
+		}
+
+		const uint8_t* source = reinterpret_cast<const uint8_t*>(file.data.get() + offset);
+		uint8_t* target = image.pixels.get();
+
+		for (size_t i = 0u; i < count; ++i)
+		{
+			target[i * 4u + 0u] = source[i * 3u + 0u];
+			target[i * 4u + 1u] = source[i * 3u + 1u];
+			target[i * 4u + 2u] = source[i * 3u + 2u];
+			target[i * 4u + 3u] = 255u;
+		}
+
+		return true;
+	}
+
+	// TGA has no magic number, so only true colour headers whose pixels can fit the file are taken as one
+	static bool IsTGA(const CGFile& file)
+	{
+		if (file.size < CG_TGA_HEADER_SIZE)
+		{
+			return false;
+		}
+
+		const uint8_t* header = reinterpret_cast<const uint8_t*>(file.data.get());
+		const uint8_t type = header[2];
+		const uint8_t depth = header[16];
+		const uint32_t width = static_cast<uint32_t>(header[12] | (header[13] << 8u));
+		const uint32_t height = static_cast<uint32_t>(header[14] | (header[15] << 8u));
+
+		if (header[1] != 0u || (type != 2u && type != 10u) || (depth != 24u && depth != 32u) || (header[17] & 0xC0u) != 0u ||
+			width == 0u || height == 0u)
+		{
+			return false;
+		}
+
+		// Run-length packets hold at most 128 pixels behind a one byte count
+		const size_t stride = depth / 8u;
+		const size_t count = static_cast<size_t>(width) * height;
+		const size_t pixels = type == 2u ? count * stride : (count + 127u) / 128u * (stride + 1u);
+		const size_t offset = CG_TGA_HEADER_SIZE + header[0];
+
+		return file.size >= offset && file.size - offset >= pixels;
+	}
+
+	static bool DecodeTGA(const CGFile& file, CGImage& image)
+	{
+		const uint8_t* header = reinterpret_cast<const uint8_t*>(file.data.get());
+		const uint8_t type = header[2];
+		const uint8_t depth = header[16];
+		const uint32_t width = static_cast<uint32_t>(header[12] | (header[13] << 8u));
+		const uint32_t height = static_cast<uint32_t>(header[14] | (header[15] << 8u));
+		const bool topDown = (header[17] & 0x20u) != 0u;
+
+		if (!AllocateImage(width, height, image))
+		{
+			return false;
+		}
+
+		const size_t stride = depth / 8u;
+		const size_t count = static_cast<size_t>(width) * height;
+		const uint8_t* source = header + CG_TGA_HEADER_SIZE + header[0];
+		const uint8_t* end = header + file.size;
+
+		if (source > end)
+		{
+			printf("Truncated TGA image\n");
+			return false;
+		}
+
+		uint8_t* target = image.pixels.get();
+
+		for (size_t i = 0u; i < count;)
+		{
+			size_t run = 1u;
+			bool repeat = false;
+
+			if (type == 10u)
+			{
+				if (source >= end)
+				{
+					printf("Truncated TGA image\n");
+					return false;
+				}
+
+				run = (*source & 0x7Fu) + 1u;
+				repeat = (*source & 0x80u) != 0u;
+				++source;
+			}
+
+			if (run > count - i || end - source < static_cast<ptrdiff_t>((repeat ? 1u : run) * stride))
+			{
+				printf("Truncated TGA image\n");
+				return false;
+			}
+
+			for (size_t j = 0u; j < run; ++j, ++i)
+			{
+				// Bottom-up images are flipped so row 0 is always the top
+				const size_t x = i % width;
+				const size_t y = topDown ? i / width : height - 1u - i / width;
+				uint8_t* texel = target + (y * width + x) * 4u;
+
+				texel[0] = source[2];
+				texel[1] = source[1];
+				texel[2] = source[0];
+				texel[3] = stride == 4u ? source[3] : 255u;
+
+				if (!repeat)
+				{
+					source += stride;
+				}
+			}
+
+			if (repeat)
+			{
+				source += stride;
+			}
+		}
+
+		return true;
+	}
+
+	bool DecodeImage(const CGFile& file, CGImage& image)
+	{
+		if (!file.data || file.size < 2u)
+		{
+			return false;
+		}
+
+		if (file.data[0] == 'P' && file.data[1] == '6')
+		{
+			return DecodePPM(file, image);
+		}
+
+		if (IsTGA(file))
+		{
+			return DecodeTGA(file, image);
+		}
+
+		printf("Unknown image format\n");
+		return false;
+	}
+
+	bool GenerateMips(CGImage& image)
+	{
+		if (!image.pixels || image.mipCount != 1u)
+		{
+			return false;
+		}
+
+		const uint8_t mipCount = GetMipCount(image.width, image.height);
+		uint8_t* source = image.pixels.get();
+
+		uint32_t width = image.width;
+		uint32_t height = image.height;
+
+		for (uint8_t level = 1u; level < mipCount; ++level)
+		{
+			const uint32_t w = width > 1u ? width / 2u : 1u;
+			const uint32_t h = height > 1u ? height / 2u : 1u;
+			uint8_t* target = source + static_cast<size_t>(width) * height * 4u;
+
+			// Odd sizes clamp the second texel of a pair to the last row or column
+			for (uint32_t y = 0u; y < h; ++y)
+			{
+				const uint32_t y0 = y * 2u < height ? y * 2u : height - 1u;
+				const uint32_t y1 = y0 + 1u < height ? y0 + 1u : y0;
+
+				for (uint32_t x = 0u; x < w; ++x)
+				{
+					const uint32_t x0 = x * 2u < width ? x * 2u : width - 1u;
+					const uint32_t x1 = x0 + 1u < width ? x0 + 1u : x0;
+
+					for (uint32_t c = 0u; c < 4u; ++c)
+					{
+						const uint32_t sum = static_cast<uint32_t>(source[(y0 * width + x0) * 4u + c]) + source[(y0 * width + x1) * 4u + c] +
+							source[(y1 * width + x0) * 4u + c] + source[(y1 * width + x1) * 4u + c];
+
+						target[(y * w + x) * 4u + c] = static_cast<uint8_t>((sum + 2u) / 4u);
+					}
+				}
+			}
+
+			source = target;
+			width = w;
+			height = h;
+		}
+
+		image.mipCount = mipCount;
+
+		return true;
+	}
+
+	static void DecodeJob(CGImageJob& job)
+	{
+		const CGFile file = ReadFile(job.path);
+
+		if (!file.data)
+		{
+			printf("Failed to read image %s\n", job.path);
+			job.status.store(CGImageStatus::Failed, std::memory_order_release);
+			return;
+		}
+
+		if (!DecodeImage(file, job.image) || !GenerateMips(job.image))
+		{
+			printf("Failed to decode image %s\n", job.path);
+			job.image = CGImage{};
+			job.status.store(CGImageStatus::Failed, std::memory_order_release);
+			return;
+		}
+
+		job.status.store(CGImageStatus::Ready, std::memory_order_release);
+	}
+
+	static void LoaderThreadMain(CGImageLoader& loader)
+	{
+		for (;;)
+		{
+			uint32_t job = 0u;
+
+			{
+				std::unique_lock<std::mutex> lock(loader.mutex);
+				loader.wake.wait(lock, [&loader]
+				{
+					return !loader.running.load(std::memory_order_acquire) || loader.next != loader.count.load(std::memory_order_acquire);
+				});
+
+				if (!loader.running.load(std::memory_order_acquire))
+				{
+					return;
+				}
+
+				job = loader.next % CG_MAX_IMAGE_JOBS;
+				loader.next++;
+			}
+
+			loader.jobs[job].status.store(CGImageStatus::Decoding, std::memory_order_release);
+			DecodeJob(loader.jobs[job]);
+		}
+	}
+
+	bool StartImageLoader(const uint8_t workers, CGImageLoader& loader)
+	{
+		if (loader.running.load(std::memory_order_acquire))
+		{
+			return true;
+		}
+
+		if (workers == 0u || workers > CG_MAX_IMAGE_WORKERS)
+		{
+			printf("Cannot start %u image workers\n", workers);
+			return false;
+		}
+
+		loader.running.store(true, std::memory_order_release);
+
+		for (uint8_t i = 0u; i < workers; ++i)
+		{
+			loader.workers[i] = std::thread(LoaderThreadMain, std::ref(loader));
+		}
+
+		loader.workerCount = workers;
+
+		return true;
+	}
+
+	void StopImageLoader(CGImageLoader& loader)
+	{
+		if (loader.workerCount == 0u)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(loader.mutex);
+			loader.running.store(false, std::memory_order_release);
+		}
+
+		loader.wake.notify_all();
+
+		for (uint8_t i = 0u; i < loader.workerCount; ++i)
+		{
+			loader.workers[i].join();
+		}
+
+		loader.workerCount = 0u;
+	}
+
+	bool QueueImage(const char* path, const uint32_t tag, CGImageLoader& loader, uint32_t& job)
+	{
+		const uint32_t count = loader.count.load(std::memory_order_relaxed);
+		const size_t length = strlen(path);
+
+		// Ids wrap around together, so the difference is the number of jobs still holding a slot
+		if (count - loader.first.load(std::memory_order_acquire) >= CG_MAX_IMAGE_JOBS || length >= CG_MAX_IMAGE_PATH)
+		{
+			printf("Cannot queue image %s\n", path);
+			return false;
+		}
+
+		CGImageJob& entry = loader.jobs[count % CG_MAX_IMAGE_JOBS];
+		memcpy(entry.path, path, length + 1u);
+		entry.tag = tag;
+		entry.status.store(CGImageStatus::Queued, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock(loader.mutex);
+			loader.count.store(count + 1u, std::memory_order_release);
+		}
+
+		loader.wake.notify_one();
+		job = count;
+
+		return true;
+	}
+
+	CGImageStatus TakeImage(const uint32_t job, CGImageLoader& loader, CGImage& image)
+	{
+		const uint32_t first = loader.first.load(std::memory_order_relaxed);
+
+		if (job - first >= loader.count.load(std::memory_order_acquire) - first)
+		{
+			return CGImageStatus::None;
+		}
+
+		CGImageJob& entry = loader.jobs[job % CG_MAX_IMAGE_JOBS];
+		const CGImageStatus status = entry.status.load(std::memory_order_acquire);
+
+		if (status == CGImageStatus::Ready)
+		{
+			image = std::move(entry.image);
+		}
+
+		if (status == CGImageStatus::Ready || status == CGImageStatus::Failed)
+		{
+			entry.status.store(CGImageStatus::None, std::memory_order_relaxed);
+		}
+
+		return status;
+	}
+
+	void ReleaseImages(CGImageLoader& loader)
+	{
+		const uint32_t count = loader.count.load(std::memory_order_acquire);
+		uint32_t first = loader.first.load(std::memory_order_relaxed);
+
+		// Jobs are taken in any order, a slot is only reused once every older job was taken as well
+		while (first != count && loader.jobs[first % CG_MAX_IMAGE_JOBS].status.load(std::memory_order_relaxed) == CGImageStatus::None)
+		{
+			first++;
+		}
+
+		loader.first.store(first, std::memory_order_release);
+	}
+}
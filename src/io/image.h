@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "fileio.h"
+
+// image.h
+namespace cg::io
+{
+	constexpr uint32_t CG_MAX_IMAGE_JOBS = 128u;
+	constexpr uint32_t CG_MAX_IMAGE_PATH = 256u;
+	constexpr uint32_t CG_MAX_IMAGE_WORKERS = 4u;
+	constexpr uint8_t CG_MAX_IMAGE_MIPS = 15u; // Up to 16384 texels on a side
+
+	enum class CGImageStatus : uint8_t
+	{
+		None = 0u, // Handed out by TakeImage already
+		Queued = 1u,
+		Decoding = 2u,
+		Ready = 3u,
+		Failed = 4u
+	};
+
+	// RGBA8 mip chain, level 0 first and every level tightly packed. Row 0 is the top of the image.
+	struct CGImage
+	{
+		std::unique_ptr<uint8_t[]> pixels = nullptr;
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		uint8_t mipCount = 0u;
+	};
+
+	struct CGImageJob
+	{
+		char path[CG_MAX_IMAGE_PATH] = {};
+		CGImage image = {};
+		uint32_t tag = 0u; // Caller's handle for the image
+		std::atomic<CGImageStatus> status = CGImageStatus::None;
+	};
+
+	// Decodes images on worker threads of its own. Jobs are only ever queued by one thread and taken by one
+	// thread. Job ids keep counting up, a job lives in jobs[job % CG_MAX_IMAGE_JOBS] until it is released.
+	struct CGImageLoader
+	{
+		CGImageJob jobs[CG_MAX_IMAGE_JOBS] = {};
+		std::thread workers[CG_MAX_IMAGE_WORKERS];
+		std::mutex mutex;
+		std::condition_variable wake;
+		uint32_t next = 0u; // Next job a worker picks up, guarded by mutex
+		std::atomic<uint32_t> count = 0u; // Jobs queued so far
+		std::atomic<uint32_t> first = 0u; // Oldest job that is not released, every slot before it can be reused
+		std::atomic<bool> running = false;
+		uint8_t workerCount = 0u;
+	};
+
+	bool StartImageLoader(const uint8_t workers, CGImageLoader& loader);
+	void StopImageLoader(CGImageLoader& loader);
+	bool QueueImage(const char* path, const uint32_t tag, CGImageLoader& loader, uint32_t& job);
+	// Moves the image out once it is ready, Ready and Failed are returned only once per job
+	CGImageStatus TakeImage(const uint32_t job, CGImageLoader& loader, CGImage& image);
+	// Hands the slots of the oldest taken jobs back to QueueImage, their paths and tags are gone afterwards
+	void ReleaseImages(CGImageLoader& loader);
+
+	// Binary PPM (P6) and true colour TGA, plain or run-length encoded
+	bool DecodeImage(const CGFile& file, CGImage& image);
+	// Fills in the mips of an image decoded with a single level with a box filter
+	bool GenerateMips(CGImage& image);
+	size_t GetMipChainSize(const uint32_t width, const uint32_t height, const uint8_t mipCount);
+}
@@ -29,12 +29,25 @@ constexpr float vertices[21] =
 using namespace cg;
 using namespace cg::renderer;
 
+// Direct3D 11 where it is built, OpenGL everywhere else
+#if defined(CG_HAS_D3D11)
+constexpr CGRendererType RENDERER_TYPE = CGRendererType::Direct3D11;
+constexpr const char* VERTEX_SHADER = "assets/debug_vs.hlsl";
+constexpr const char* FRAGMENT_SHADER = "assets/debug_ps.hlsl";
+#else
+constexpr CGRendererType RENDERER_TYPE = CGRendererType::OpenGL;
+constexpr const char* VERTEX_SHADER = "assets/debug_vs.glsl";
+constexpr const char* FRAGMENT_SHADER = "assets/debug_fs.glsl";
+#endif
+
 static void CreateViewport(const core::CGWindow& window, CGRenderer& renderer);
 static void CreateVertexShader(CGRenderer& renderer, CGShader& vShader);
 static void CreateVertexBuffer(CGRenderer& renderer, CGShader& vShader, CGVertexLayout& vLayout, CGBuffer& vBuffer);
 static void CreateIndexBuffer(CGRenderer& renderer, CGBuffer& iBuffer);
 static void CreateFragmentShader(CGRenderer& renderer, CGShader& fShader);
 static void CreateShaderProgram(const uint8_t shaderCount, const CGShader shaders[], CGRenderer& renderer, uint32_t& program);
+static void CreatePipelineState(const uint32_t program, CGRenderer& renderer, uint32_t& pipeline);
+static bool RecordTriangle(const uint32_t pipeline, const uint32_t vertexCount, CGCommandStream& stream);
 
 void CreateViewport(const core::CGWindow& window, CGRenderer& renderer)
 {
@@ -92,7 +105,7 @@ void CreateVertexShader(CGRenderer& renderer, CGShader& vShader)
 {
 	CGShaderDesc vsDesc = {};
 	vsDesc.shaderType = CGShaderType::Vertex;
-	vsDesc.filename = "assets/debug_vs.hlsl";
+	vsDesc.filename = VERTEX_SHADER;
 	vsDesc.entryPoint = "VSMain";
 
 	if (!DeviceOps::CreateShader(vsDesc, renderer, vShader))
@@ -105,7 +118,7 @@ void CreateFragmentShader(CGRenderer& renderer, CGShader& fShader)
 {
 	CGShaderDesc fsDesc = {};
 	fsDesc.shaderType = CGShaderType::Fragment;
-	fsDesc.filename = "assets/debug_ps.hlsl";
+	fsDesc.filename = FRAGMENT_SHADER;
 	fsDesc.entryPoint = "PSMain";
 
 	if (!DeviceOps::CreateShader(fsDesc, renderer, fShader))
@@ -122,13 +135,66 @@ void CreateShaderProgram(const uint8_t shaderCount, const CGShader shaders[], CG
 	}
 }
 
+void CreatePipelineState(const uint32_t program, CGRenderer& renderer, uint32_t& pipeline)
+{
+	CGPipelineDesc desc = {};
+	desc.program = program;
+	desc.vertexLayout = 0u;
+	desc.vertexShader = 0u;
+	desc.fragmentShader = 0u;
+	desc.topology = CGPrimitiveTopology::TriangleList;
+
+	if (!DeviceOps::CreatePipelineState(desc, renderer, pipeline))
+	{
+		printf("\nPipeline state failed\n");
+	}
+}
+
+bool RecordTriangle(const uint32_t pipeline, const uint32_t vertexCount, CGCommandStream& stream)
+{
+	if (!BeginRenderPacket(0ull, stream))
+	{
+		return false;
+	}
+
+	CGSetPipelineStateCommand* setPipeline = Emplace<CGSetPipelineStateCommand>(stream);
+	if (!setPipeline)
+	{
+		return false;
+	}
+
+	setPipeline->pipeline = pipeline;
+
+	CGSetVertexBufferCommand* setVertexBuffer = Emplace<CGSetVertexBufferCommand>(stream);
+	if (!setVertexBuffer)
+	{
+		return false;
+	}
+
+	setVertexBuffer->buffer = 0u;
+
+	CGDrawCommand* draw = Emplace<CGDrawCommand>(stream);
+	if (!draw)
+	{
+		return false;
+	}
+
+	draw->vertexBuffer = 0u;
+	draw->count = vertexCount;
+	draw->start = 0u;
+
+	return true;
+}
+
 // main.cpp
 int main()
 {
 	CGEngineCreateInfo info = {};
-	info.rendererType = CGRendererType::Direct3D11;
+	info.rendererType = RENDERER_TYPE;
 	info.resolution.width = WINDOW_WIDTH;
 	info.resolution.height = WINDOW_HEIGHT;
+	info.framesInFlight = 2u;
+	info.renderThread = false;
 	info.debug = true;
 
 	CGEngine engine(info);
@@ -139,6 +205,7 @@ int main()
 	CGBuffer vBuffer, iBuffer;
 	CGShader vShader, fShader;
 	uint32_t program = 0u;
+	uint32_t pipeline = 0u;
 
 	CreateViewport(window, renderer);
 	CreateVertexShader(renderer, vShader);
@@ -150,33 +217,43 @@ int main()
 	const uint8_t shaderCount = sizeof(shaders) / sizeof(shaders[0]);
 
 	CreateShaderProgram(shaderCount, shaders, renderer, program);
+	CreatePipelineState(program, renderer, pipeline);
 
 	const uint8_t vertexCount = 3u;
 
-	const CGRenderCommand commands[] = 
-	{ 
-		{ ContextOps::SetViewClear(0u, 0u, CG_CLEAR_COLOR, CG_DARK_GRAY) },
-		{ ContextOps::SetPipelineState(program) },
-		{ ContextOps::SetVertexBuffer(0u) },
-		{ ContextOps::SetIndexBuffer(0u) },
-		{ ContextOps::SetVertexShader(0u) },
-		{ ContextOps::SetFragmentShader(0u) },
-		{ RenderOps::Draw(0u, vertexCount, 0u) }
-	};
-
-	const uint8_t cmdCount = sizeof(commands) / sizeof(commands[0]);
+	// The triangle never changes, so it is translated once into a bundle and replayed every frame
+	CGCommandStream staticStream = {};
+	uint32_t bundle = 0u;
 
-	AddRenderCommands(cmdCount, commands, renderer);
+	if (!RecordTriangle(pipeline, vertexCount, staticStream) || !DeviceOps::CreateRenderBundle(staticStream, renderer, bundle))
+	{
+		printf("\nRender bundle failed\n");
+	}
 
 	while (engine.IsRunning())
 	{
 		PollEvents();
 
-		ExecuteRenderCommands(renderer);
+		engine.BeginFrame();
+
+		CGCommandStream& stream = GetCommandStream(renderer);
+
+		BeginRenderPacket(MakeSortKey(0u, 0u, 0u, 0u, 0u), stream);
+		if (CGSetViewClearCommand* clear = Emplace<CGSetViewClearCommand>(stream))
+		{
+			clear->view = 0u;
+			clear->viewport = 0u;
+			clear->clearFlags = CG_CLEAR_COLOR;
+			clear->color = CG_DARK_GRAY;
+		}
 
-		FrameOps::EndFrame(renderer);
+		BeginRenderPacket(MakeSortKey(0u, 1u, pipeline, 0u, 0u), stream);
+		if (CGExecuteBundleCommand* execute = Emplace<CGExecuteBundleCommand>(stream))
+		{
+			execute->bundle = bundle;
+		}
 
-		FrameOps::Present(renderer);
+		engine.SubmitFrame();
 	}
 
 	return 0;
@@ -29,8 +29,9 @@ namespace cg
 
 #ifdef _WIN32
 		window.nwh = glfwGetWin32Window(static_cast<GLFWwindow*>(window.winptr));
-#endif
 
+		// Only D3D needs the native handle, and only Win32 provides one. Hidden and null platform
+		// windows on other systems have none, which is fine for OpenGL.
 		if (!window.nwh)
 		{
 			const char* error = nullptr;
@@ -40,6 +41,7 @@ namespace cg
 
 			return false;
 		}
+#endif
 
 		return true;
 	}
@@ -1,102 +1,725 @@
+#include <cstdio>
+#include <cstring>
+
 #include "renderer.h"
 #include "platform/window.h"
 
 // renderer.cpp
 namespace cg::renderer
 {
-	bool AddRenderCommands(const uint8_t count, const CGRenderCommand commands[], CGRenderer& renderer)
+	namespace ArenaOps
 	{
-		CGCommandPool& cmdPool = renderer.resourcePool.commandPool;
+		bool Reserve(const size_t capacity, CGLinearArena& arena)
+		{
+			if (capacity <= arena.capacity)
+			{
+				return true;
+			}
+
+			// Grow geometrically so appends stay amortised O(1)
+			size_t newCapacity = arena.capacity > 0ull ? arena.capacity : CG_MIN_ARENA_SIZE;
+			while (newCapacity < capacity)
+			{
+				newCapacity *= 2ull;
+			}
+
+			// make_unique would throw instead, callers handle running out of memory themselves
+			std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[newCapacity]());
+
+			if (!data)
+			{
+				return false;
+			}
+
+			if (arena.size > 0ull)
+			{
+				memcpy(data.get(), arena.data.get(), arena.size);
+			}
 
-		if (count < 1 || commands == nullptr || cmdPool.count + count >= CG_MAX_RENDER_COMMANDS)
+			arena.data = std::move(data);
+			arena.capacity = newCapacity;
+
+			return true;
+		}
+
+		void* Allocate(const size_t size, CGLinearArena& arena)
 		{
-			return false;
+			if (!Reserve(arena.size + size, arena))
+			{
+				return nullptr;
+			}
+
+			void* ptr = arena.data.get() + arena.size;
+			arena.size += size;
+
+			return ptr;
 		}
 
-		uint8_t startIndex = cmdPool.count;
-		for (uint8_t i = 0u; i < count; ++i)
+		void Reset(CGLinearArena& arena)
+		{
+			arena.size = 0ull;
+		}
+	}
+
+	static void ResetCommandStream(CGCommandStream& stream)
+	{
+		ArenaOps::Reset(stream.commands);
+		ArenaOps::Reset(stream.packets);
+
+		stream.count = 0u;
+		stream.packetCount = 0u;
+	}
+
+	uint8_t GetPipelineChanges(const CGPipelineDesc& current, const CGPipelineDesc& next)
+	{
+		uint8_t changes = 0u;
+
+		if (current.program != next.program || current.vertexShader != next.vertexShader || current.fragmentShader != next.fragmentShader)
+		{
+			changes |= CG_PIPELINE_SHADERS;
+		}
+
+		if (current.vertexLayout != next.vertexLayout)
+		{
+			changes |= CG_PIPELINE_LAYOUT;
+		}
+
+		if (current.topology != next.topology)
+		{
+			changes |= CG_PIPELINE_TOPOLOGY;
+		}
+
+		if (std::memcmp(&current.blend, &next.blend, sizeof(CGBlendState)) != 0)
+		{
+			changes |= CG_PIPELINE_BLEND;
+		}
+
+		if (std::memcmp(&current.depth, &next.depth, sizeof(CGDepthState)) != 0)
 		{
-			cmdPool.commands[startIndex + i] = commands[i];
+			changes |= CG_PIPELINE_DEPTH;
 		}
 
-		cmdPool.count += count;
+		if (std::memcmp(&current.raster, &next.raster, sizeof(CGRasterState)) != 0)
+		{
+			changes |= CG_PIPELINE_RASTER;
+		}
+
+		return changes;
+	}
+
+	bool BeginRenderPacket(const uint64_t sortKey, CGCommandStream& stream)
+	{
+		void* memory = ArenaOps::Allocate(sizeof(CGRenderPacket), stream.packets);
+
+		if (!memory)
+		{
+			return false;
+		}
+
+		CGRenderPacket* packet = new (memory) CGRenderPacket();
+		packet->sortKey = sortKey;
+		packet->offset = static_cast<uint32_t>(stream.commands.size);
+		packet->size = 0u;
+
+		stream.packetCount++;
 
 		return true;
 	}
 
-	void ExecuteRenderCommands(const CGRenderer& renderer)
+	CGCommandStream& GetCommandStream(CGRenderer& renderer)
 	{
-		switch (renderer.type)
+		return renderer.resourcePool.commandPools[renderer.resourcePool.recordPool].stream;
+	}
+
+	bool AddRenderCommands(const uint8_t count, const CGRenderCommand commands[], CGRenderer& renderer)
+	{
+		return AddRenderCommands(0ull, count, commands, renderer);
+	}
+
+	bool AddRenderCommands(const uint64_t sortKey, const uint8_t count, const CGRenderCommand commands[], CGRenderer& renderer)
+	{
+		return AddRenderCommands(sortKey, count, commands, GetCommandStream(renderer));
+	}
+
+	// Translates the fixed-size commands into their packed form, into the packet that is open for recording
+	static bool PackRenderCommands(const uint8_t count, const CGRenderCommand commands[], CGCommandStream& stream)
+	{
+		for (uint8_t i = 0u; i < count; ++i)
 		{
-			case CGRendererType::None:
+			const CGRenderCommand& cmd = commands[i];
+
+			switch (cmd.type)
 			{
-				break;
+				case CGRenderCommandType::None:
+				{
+					break;
+				}
+				case CGRenderCommandType::SetViewClear:
+				{
+					CGSetViewClearCommand* packed = Emplace<CGSetViewClearCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->color = cmd.params.setViewClear.color;
+					packed->clearFlags = cmd.params.setViewClear.clearFlags;
+					packed->view = cmd.params.setViewClear.view;
+					packed->viewport = cmd.params.setViewClear.viewport;
+					break;
+				}
+				case CGRenderCommandType::SetPipelineState:
+				{
+					CGSetPipelineStateCommand* packed = Emplace<CGSetPipelineStateCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->pipeline = cmd.params.setPipelineState.pipeline;
+					break;
+				}
+				case CGRenderCommandType::SetVertexShader:
+				{
+					CGSetVertexShaderCommand* packed = Emplace<CGSetVertexShaderCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->shader = cmd.params.setShader.shader;
+					break;
+				}
+				case CGRenderCommandType::SetFragmentShader:
+				{
+					CGSetFragmentShaderCommand* packed = Emplace<CGSetFragmentShaderCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->shader = cmd.params.setShader.shader;
+					break;
+				}
+				case CGRenderCommandType::SetVertexBuffer:
+				{
+					CGSetVertexBufferCommand* packed = Emplace<CGSetVertexBufferCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->buffer = cmd.params.setVertexBuffer.buffer;
+					packed->offset = cmd.params.setVertexBuffer.offset;
+					packed->layout = cmd.params.setVertexBuffer.layout;
+					break;
+				}
+				case CGRenderCommandType::SetIndexBuffer:
+				{
+					CGSetIndexBufferCommand* packed = Emplace<CGSetIndexBufferCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->buffer = cmd.params.setIndexBuffer.buffer;
+					packed->offset = cmd.params.setIndexBuffer.offset;
+					break;
+				}
+				case CGRenderCommandType::Draw:
+				{
+					CGDrawCommand* packed = Emplace<CGDrawCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->count = cmd.params.draw.count;
+					packed->start = cmd.params.draw.start;
+					packed->vertexBuffer = cmd.params.draw.vertexBuffer;
+					break;
+				}
+				case CGRenderCommandType::DrawIndexed:
+				{
+					CGDrawIndexedCommand* packed = Emplace<CGDrawIndexedCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->count = cmd.params.drawIndexed.count;
+					packed->start = cmd.params.drawIndexed.start;
+					packed->baseVertex = cmd.params.drawIndexed.baseVertex;
+					break;
+				}
+				case CGRenderCommandType::ExecuteBundle:
+				{
+					CGExecuteBundleCommand* packed = Emplace<CGExecuteBundleCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->bundle = cmd.params.executeBundle.bundle;
+					break;
+				}
+				case CGRenderCommandType::SetConstantBuffer:
+				{
+					CGSetConstantBufferCommand* packed = Emplace<CGSetConstantBufferCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->buffer = cmd.params.setConstantBuffer.buffer;
+					packed->offset = cmd.params.setConstantBuffer.offset;
+					packed->size = cmd.params.setConstantBuffer.size;
+					packed->slot = cmd.params.setConstantBuffer.slot;
+					break;
+				}
+				case CGRenderCommandType::SetTexture:
+				{
+					CGSetTextureCommand* packed = Emplace<CGSetTextureCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->texture = cmd.params.setTexture.texture;
+					packed->slot = cmd.params.setTexture.slot;
+					break;
+				}
+				case CGRenderCommandType::SetSampler:
+				{
+					CGSetSamplerCommand* packed = Emplace<CGSetSamplerCommand>(stream);
+					if (!packed)
+					{
+						return false;
+					}
+
+					packed->sampler = cmd.params.setSampler.sampler;
+					packed->slot = cmd.params.setSampler.slot;
+					break;
+				}
 			}
-			case CGRendererType::Direct3D11:
+		}
+
+		return true;
+	}
+
+	bool AddRenderCommands(const uint64_t sortKey, const uint8_t count, const CGRenderCommand commands[], CGCommandStream& stream)
+	{
+		if (count < 1 || commands == nullptr)
+		{
+			return false;
+		}
+
+		const size_t commandsSize = stream.commands.size;
+		const size_t packetsSize = stream.packets.size;
+		const uint32_t commandCount = stream.count;
+		const uint32_t packetCount = stream.packetCount;
+
+		// A packet that runs out of memory halfway is dropped as a whole, part of it would still be sorted and executed
+		if (!BeginRenderPacket(sortKey, stream) || !PackRenderCommands(count, commands, stream))
+		{
+			stream.commands.size = commandsSize;
+			stream.packets.size = packetsSize;
+			stream.count = commandCount;
+			stream.packetCount = packetCount;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	void SortRenderCommands(CGRenderer& renderer)
+	{
+		CGCommandPool& cmdPool = renderer.resourcePool.commandPools[renderer.resourcePool.recordPool];
+
+		const uint32_t count = cmdPool.stream.packetCount;
+		const size_t orderSize = count * sizeof(uint32_t);
+
+		ArenaOps::Reset(cmdPool.order);
+		ArenaOps::Reset(cmdPool.scratch);
+
+		if (!ArenaOps::Allocate(orderSize, cmdPool.order) || !ArenaOps::Allocate(orderSize, cmdPool.scratch))
+		{
+			return;
+		}
+
+		const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(cmdPool.stream.packets);
+
+		uint32_t* src = ArenaOps::GetData<uint32_t>(cmdPool.order);
+		uint32_t* dst = ArenaOps::GetData<uint32_t>(cmdPool.scratch);
+
+		for (uint32_t i = 0u; i < count; ++i)
+		{
+			src[i] = i;
+		}
+
+		if (count < 2u)
+		{
+			return;
+		}
+
+		// LSD radix sort over the packet keys, one byte per pass. Each pass is stable,
+		// so packets with equal keys keep their submission order.
+		for (uint32_t shift = 0u; shift < 64u; shift += 8u)
+		{
+			uint32_t histogram[256] = {};
+
+			for (uint32_t i = 0u; i < count; ++i)
 			{
-				D3D11::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool);
-				break;
+				histogram[(packets[src[i]].sortKey >> shift) & 0xFFu]++;
 			}
-			case CGRendererType::Direct3D12:
+
+			// Every key shares this byte, nothing to reorder
+			if (histogram[(packets[src[0]].sortKey >> shift) & 0xFFu] == count)
 			{
-				break;
+				continue;
 			}
-			case CGRendererType::OpenGL:
+
+			uint32_t offset = 0u;
+			for (uint32_t& bucket : histogram)
 			{
-				OpenGL::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool);
-				break;
+				const uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
 			}
-			case CGRendererType::Vulkan:
+
+			for (uint32_t i = 0u; i < count; ++i)
 			{
-				break;
+				const uint32_t packet = src[i];
+				dst[histogram[(packets[packet].sortKey >> shift) & 0xFFu]++] = packet;
 			}
+
+			uint32_t* temp = src;
+			src = dst;
+			dst = temp;
+		}
+
+		uint32_t* order = ArenaOps::GetData<uint32_t>(cmdPool.order);
+
+		if (src != order)
+		{
+			memcpy(order, src, orderSize);
 		}
 	}
 
-	namespace DeviceOps
+	CGCommandBuffer& GetCommandBuffer(const uint8_t thread, CGRenderer& renderer)
 	{
-		constexpr static uint32_t GetAttributeSize(const CGVertexFormat format)
+		return renderer.resourcePool.commandBuffers[thread % CG_MAX_COMMAND_BUFFERS];
+	}
+
+	void PublishCommandBuffer(CGCommandBuffer& cmdBuffer, CGRenderer& renderer)
+	{
+		// Release pairs with the acquire in MergeCommandBuffers, making the recorded commands visible. A buffer
+		// that could not be merged is still published and is only counted once.
+		if (!cmdBuffer.published.exchange(true, std::memory_order_acq_rel))
 		{
-			switch (format)
-			{
-				case CGVertexFormat::None:	 break;
-				case CGVertexFormat::UInt:	 return sizeof(uint32_t);
-				case CGVertexFormat::UInt2:	 return sizeof(uint32_t) * 2u;
-				case CGVertexFormat::UInt3:	 return sizeof(uint32_t) * 3u;
-				case CGVertexFormat::UInt4:	 return sizeof(uint32_t) * 4u;
-				case CGVertexFormat::Float:  return sizeof(float);
-				case CGVertexFormat::Float2: return sizeof(float) * 2u;
-				case CGVertexFormat::Float3: return sizeof(float) * 3u;
-				case CGVertexFormat::Float4: return sizeof(float) * 4u;
-			}
+			renderer.resourcePool.publishedCount.fetch_add(1u, std::memory_order_release);
+		}
+	}
 
-			return 0u;
-		};
+	bool MergeCommandBuffers(CGRenderer& renderer)
+	{
+		CGResourcePool& resourcePool = renderer.resourcePool;
+		CGCommandStream& dstStream = GetCommandStream(renderer);
 
-		bool CreateShader(const CGShaderDesc& desc, CGRenderer& renderer, CGShader& shader)
+		if (resourcePool.publishedCount.load(std::memory_order_acquire) == 0u)
 		{
-			CGShaderPool& shaderPool = renderer.resourcePool.shaderPool;
+			return true;
+		}
 
-			if (desc.shaderType == CGShaderType::None || 
-				shaderPool.vsCount + 1u >= CG_MAX_VERTEX_SHADERS || shaderPool.fsCount + 1u >= CG_MAX_FRAGMENT_SHADERS)
+		bool merged = true;
+
+		// Walk the buffers in index order rather than publish order, so the merged
+		// list (and therefore the sorted one) does not depend on thread timing
+		for (CGCommandBuffer& cmdBuffer : resourcePool.commandBuffers)
+		{
+			if (!cmdBuffer.published.load(std::memory_order_acquire))
 			{
-				return false;
+				continue;
 			}
 
-			shader.type = desc.shaderType;
+			CGCommandStream& srcStream = cmdBuffer.stream;
 
-			switch (renderer.type)
+			if (srcStream.packetCount > 0u)
 			{
-				case CGRendererType::None:
+				// Both arenas grow before either is written, a failed merge leaves the destination as it was
+				// and the buffer stays published, so the next merge picks it up again
+				if (!ArenaOps::Reserve(dstStream.commands.size + srcStream.commands.size, dstStream.commands) ||
+					!ArenaOps::Reserve(dstStream.packets.size + srcStream.packets.size, dstStream.packets))
 				{
-					return false;
+					merged = false;
+					continue;
 				}
-				case CGRendererType::Direct3D11:
-				{
-					if (!D3D11::DeviceOps::CreateShader(renderer.context, desc, shader))
-					{
-						return false;
-					}
+
+				const uint32_t base = static_cast<uint32_t>(dstStream.commands.size);
+
+				void* commands = ArenaOps::Allocate(srcStream.commands.size, dstStream.commands);
+				void* packets = ArenaOps::Allocate(srcStream.packets.size, dstStream.packets);
+
+				// Streams are position independent apart from the packet offsets, which are rebased
+				memcpy(commands, srcStream.commands.data.get(), srcStream.commands.size);
+				memcpy(packets, srcStream.packets.data.get(), srcStream.packets.size);
+
+				CGRenderPacket* dstPackets = static_cast<CGRenderPacket*>(packets);
+				for (uint32_t i = 0u; i < srcStream.packetCount; ++i)
+				{
+					dstPackets[i].offset += base;
+				}
+
+				dstStream.count += srcStream.count;
+				dstStream.packetCount += srcStream.packetCount;
+			}
+
+			ResetCommandStream(srcStream);
+			cmdBuffer.published.store(false, std::memory_order_relaxed);
+			resourcePool.publishedCount.fetch_sub(1u, std::memory_order_relaxed);
+		}
+
+		return merged;
+	}
+
+	void ResetRenderCommands(const uint8_t pool, CGRenderer& renderer)
+	{
+		CGCommandPool& cmdPool = renderer.resourcePool.commandPools[pool];
+
+		ResetCommandStream(cmdPool.stream);
+		ArenaOps::Reset(cmdPool.order);
+		ArenaOps::Reset(cmdPool.scratch);
+		ArenaOps::Reset(cmdPool.uploads);
+
+		cmdPool.mappedUpload = CG_NO_UPLOAD;
+		cmdPool.transientSize = 0u;
+	}
+
+	void ExecuteRenderCommands(CGRenderer& renderer)
+	{
+		ExecuteRenderCommands(renderer.resourcePool.recordPool, renderer);
+	}
+
+	void ExecuteRenderCommands(const uint8_t pool, CGRenderer& renderer)
+	{
+#if defined(CG_RENDERER_STATIC)
+		ExecuteRenderCommands<CG_STATIC_RENDERER_TYPE>(pool, renderer);
+#else
+		switch (renderer.type)
+		{
+			case CGRendererType::None:
+			{
+				ExecuteRenderCommands<CGRendererType::None>(pool, renderer);
+				break;
+			}
+			case CGRendererType::Direct3D11:
+			{
+				ExecuteRenderCommands<CGRendererType::Direct3D11>(pool, renderer);
+				break;
+			}
+			case CGRendererType::Direct3D12:
+			{
+				ExecuteRenderCommands<CGRendererType::Direct3D12>(pool, renderer);
+				break;
+			}
+			case CGRendererType::OpenGL:
+			{
+				ExecuteRenderCommands<CGRendererType::OpenGL>(pool, renderer);
+				break;
+			}
+			case CGRendererType::Vulkan:
+			{
+				ExecuteRenderCommands<CGRendererType::Vulkan>(pool, renderer);
+				break;
+			}
+			case CGRendererType::Null:
+			{
+				ExecuteRenderCommands<CGRendererType::Null>(pool, renderer);
+				break;
+			}
+			case CGRendererType::Software:
+			{
+				ExecuteRenderCommands<CGRendererType::Software>(pool, renderer);
+				break;
+			}
+		}
+#endif
+	}
+
+	namespace DeviceOps
+	{
+		constexpr static uint32_t GetAttributeSize(const CGVertexFormat format)
+		{
+			switch (format)
+			{
+				case CGVertexFormat::None:	 break;
+				case CGVertexFormat::UInt:	 return sizeof(uint32_t);
+				case CGVertexFormat::UInt2:	 return sizeof(uint32_t) * 2u;
+				case CGVertexFormat::UInt3:	 return sizeof(uint32_t) * 3u;
+				case CGVertexFormat::UInt4:	 return sizeof(uint32_t) * 4u;
+				case CGVertexFormat::Float:  return sizeof(float);
+				case CGVertexFormat::Float2: return sizeof(float) * 2u;
+				case CGVertexFormat::Float3: return sizeof(float) * 3u;
+				case CGVertexFormat::Float4: return sizeof(float) * 4u;
+			}
+
+			return 0u;
+		};
+
+		bool CreateShader(const CGShaderDesc& desc, CGRenderer& renderer, CGShader& shader)
+		{
+			CGShaderPool& shaderPool = renderer.resourcePool.shaderPool;
+
+			if (desc.shaderType == CGShaderType::None || 
+				shaderPool.vsCount + 1u >= CG_MAX_VERTEX_SHADERS || shaderPool.fsCount + 1u >= CG_MAX_FRAGMENT_SHADERS)
+			{
+				return false;
+			}
+
+			shader.type = desc.shaderType;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::DeviceOps::CreateShader(renderer.context, desc, shader))
+					{
+						return false;
+					}
+
+					switch (desc.shaderType)
+					{
+						case CGShaderType::None:
+						{
+							return false;
+						}
+						case CGShaderType::Vertex:
+						{
+							shaderPool.vertexShaders[shaderPool.vsCount] = shader;
+							shaderPool.vsCount++;
+							break;
+						}
+						case CGShaderType::Fragment:
+						{
+							shaderPool.fragmentShaders[shaderPool.fsCount] = shader;
+							shaderPool.fsCount++;
+							break;
+						}
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::CreateShader(renderer.context, shaderPool, desc, shader))
+					{
+						return false;
+					}
+
+					switch (desc.shaderType)
+					{
+						case CGShaderType::Vertex:
+						{
+							shaderPool.vertexShaders[shaderPool.vsCount] = shader;
+							shaderPool.vsCount++;
+							break;
+						}
+						case CGShaderType::Fragment:
+						{
+							shaderPool.fragmentShaders[shaderPool.fsCount] = shader;
+							shaderPool.fsCount++;
+							break;
+						}
+					}
+
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					if (!Vulkan::DeviceOps::CreateShader(renderer.device, desc, shader))
+					{
+						return false;
+					}
+
+					switch (desc.shaderType)
+					{
+						case CGShaderType::Vertex:
+						{
+							shaderPool.vertexShaders[shaderPool.vsCount] = shader;
+							shaderPool.vsCount++;
+							break;
+						}
+						case CGShaderType::Fragment:
+						{
+							shaderPool.fragmentShaders[shaderPool.fsCount] = shader;
+							shaderPool.fsCount++;
+							break;
+						}
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::DeviceOps::CreateShader(renderer.context, desc, shader))
+					{
+						return false;
+					}
+
+					switch (desc.shaderType)
+					{
+						case CGShaderType::None:
+						{
+							return false;
+						}
+						case CGShaderType::Vertex:
+						{
+							shaderPool.vertexShaders[shaderPool.vsCount] = shader;
+							shaderPool.vsCount++;
+							break;
+						}
+						case CGShaderType::Fragment:
+						{
+							shaderPool.fragmentShaders[shaderPool.fsCount] = shader;
+							shaderPool.fsCount++;
+							break;
+						}
+						case CGShaderType::TessellationControl:
+						case CGShaderType::TessellationEvaluation:
+						case CGShaderType::Geometry:
+						case CGShaderType::Compute:
+						case CGShaderType::Program:
+						{
+							// Only vertex and fragment shaders are pooled
+							break;
+						}
+					}
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					if (!Software::DeviceOps::CreateShader(desc, shader))
+					{
+						return false;
+					}
 
 					switch (desc.shaderType)
 					{
@@ -116,183 +739,1854 @@ namespace cg::renderer
 							shaderPool.fsCount++;
 							break;
 						}
+						case CGShaderType::TessellationControl:
+						case CGShaderType::TessellationEvaluation:
+						case CGShaderType::Geometry:
+						case CGShaderType::Compute:
+						case CGShaderType::Program:
+						{
+							// Only vertex and fragment shaders are pooled
+							break;
+						}
+					}
+
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool CreateShaderProgram(const uint8_t count, const CGShader shaders[], CGRenderer& renderer, uint32_t& program)
+		{
+			CGShaderPool& shaderPool = renderer.resourcePool.shaderPool;
+
+			if (count < 1 || shaders == nullptr || shaderPool.pCount + count >= CG_MAX_SHADER_PROGRAMS)
+			{
+				return false;
+			}
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+					break;
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::CreateShaderProgram(renderer.context, shaderPool, count, shaders, program))
+					{
+						return false;
 					}
 
+					shaderPool.programs[shaderPool.pCount] = program;
+					shaderPool.pCount++;
+
 					break;
 				}
-				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					if (!Vulkan::DeviceOps::CreateShaderProgram(renderer.context, count, shaders, program))
+					{
+						return false;
+					}
+
+					shaderPool.programs[shaderPool.pCount] = program;
+					shaderPool.pCount++;
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::DeviceOps::CreateShaderProgram(renderer.context, count, shaders, program))
+					{
+						return false;
+					}
+
+					shaderPool.programs[shaderPool.pCount] = program;
+					shaderPool.pCount++;
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					if (!Software::DeviceOps::CreateShaderProgram(renderer.context, count, shaders, program))
+					{
+						return false;
+					}
+
+					shaderPool.programs[shaderPool.pCount] = program;
+					shaderPool.pCount++;
+
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool CreateShaderProgramAsync(const uint8_t count, const CGShaderDesc descs[], CGRenderer& renderer, uint32_t& pending)
+		{
+			CGShaderPool& shaderPool = renderer.resourcePool.shaderPool;
+			CGPendingProgramPool& pendingPool = renderer.resourcePool.pendingPool;
+
+			if (count < 1 || count > CG_MAX_PROGRAM_SHADERS || descs == nullptr)
+			{
+				return false;
+			}
+
+			// Programs still compiling already own a slot of the shader pool
+			uint32_t slot = CG_MAX_PENDING_PROGRAMS;
+			uint32_t pendingCount = 0u;
+
+			for (uint32_t i = 0u; i < CG_MAX_PENDING_PROGRAMS; ++i)
+			{
+				if (pendingPool.programs[i].status == CGProgramStatus::None)
+				{
+					slot = slot == CG_MAX_PENDING_PROGRAMS ? i : slot;
+				}
+				else
+				{
+					pendingCount++;
+				}
+			}
+
+			if (slot == CG_MAX_PENDING_PROGRAMS || shaderPool.pCount + pendingCount + 1u >= CG_MAX_SHADER_PROGRAMS)
+			{
+				return false;
+			}
+
+			CGPendingProgram& program = pendingPool.programs[slot];
+			program = CGPendingProgram{};
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::SubmitShaderProgram(renderer.context, shaderPool, count, descs, program))
+					{
+						program = CGPendingProgram{};
+						return false;
+					}
+
+					break;
+				}
+				case CGRendererType::Direct3D11:
+				case CGRendererType::Vulkan:
+				case CGRendererType::Null:
+				case CGRendererType::Software:
+				{
+					// No async compiles, the program is created right away and already in the shader pool
+					for (uint8_t i = 0u; i < count; ++i)
+					{
+						if (!CreateShader(descs[i], renderer, program.shaders[i]))
+						{
+							program = CGPendingProgram{};
+							return false;
+						}
+					}
+
+					if (!CreateShaderProgram(count, program.shaders, renderer, program.program))
+					{
+						program = CGPendingProgram{};
+						return false;
+					}
+
+					program.shaderCount = count;
+					program.status = CGProgramStatus::Ready;
+
+					break;
+				}
+			}
+
+			pending = slot;
+
+			return true;
+		}
+
+		CGProgramStatus PollShaderProgram(const uint32_t pending, CGRenderer& renderer, uint32_t& program)
+		{
+			CGShaderPool& shaderPool = renderer.resourcePool.shaderPool;
+
+			if (pending >= CG_MAX_PENDING_PROGRAMS)
+			{
+				return CGProgramStatus::None;
+			}
+
+			CGPendingProgram& pendingProgram = renderer.resourcePool.pendingPool.programs[pending];
+			CGProgramStatus status = pendingProgram.status;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::OpenGL:
+				{
+					status = OpenGL::DeviceOps::PollShaderProgram(renderer.context, pendingProgram);
+
+					if (status == CGProgramStatus::Ready)
+					{
+						shaderPool.programs[shaderPool.pCount] = pendingProgram.program;
+						shaderPool.pCount++;
+					}
+
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+
+			if (status == CGProgramStatus::Ready)
+			{
+				program = pendingProgram.program;
+			}
+
+			if (status == CGProgramStatus::Ready || status == CGProgramStatus::Failed)
+			{
+				pendingProgram = CGPendingProgram{};
+			}
+
+			return status;
+		}
+
+		bool WatchShaderProgram(const uint32_t program, const uint8_t count, const CGShaderDesc descs[], const uint64_t files, CGRenderer& renderer)
+		{
+			CGReloadPool& reloadPool = renderer.resourcePool.reloadPool;
+
+			if (count < 1 || count > CG_MAX_PROGRAM_SHADERS || descs == nullptr || reloadPool.count >= CG_MAX_SHADER_PROGRAMS)
+			{
+				return false;
+			}
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::OpenGL:
+				{
+					break;
+				}
+				default:
+				{
+					printf("Shader hot reload is only supported by the OpenGL renderer\n");
+					return false;
+				}
+			}
+
+			CGReloadProgram& reload = reloadPool.programs[reloadPool.count];
+			reload = CGReloadProgram{};
+
+			for (uint8_t i = 0u; i < count; ++i)
+			{
+				reload.descs[i] = descs[i];
+			}
+
+			reload.files = files;
+			reload.program = program;
+			reload.shaderCount = count;
+
+			reloadPool.count++;
+
+			return true;
+		}
+
+		bool SetupVertexLayout(const uint8_t count, CGVertexElement elements[], CGRenderer& renderer, CGVertexLayout& vLayout)
+		{
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+
+			if (count < 1 || elements == nullptr || bufferPool.vlCount + 1 >= CG_MAX_VERTEX_LAYOUTS)
+			{
+				return false;
+			}
+
+			uint32_t offset = 0u;
+			uint32_t size = 0u;
+
+			for (uint8_t i = 0; i < count; ++i)
+			{
+				elements[i].size = GetAttributeSize(elements[i].format);
+				size += elements[i].size;
+
+				if (i > 0)
+				{
+					offset += elements[i - 1].size;
+					elements[i].offset = offset;
+				}
+
+				vLayout.elements[i] = elements[i];
+			}
+
+			vLayout.count = count;
+			vLayout.size = size;
+
+			return true;
+		}
+
+		// Over the elements, the backends use it to find layouts they already created
+		static uint64_t HashVertexLayout(const CGVertexLayout& vLayout)
+		{
+			uint64_t hash = CG_HASH_SEED;
+
+			const auto Mix = [&hash](const uint32_t value)
+			{
+				hash = HashBytes(&value, sizeof(value), hash);
+			};
+
+			Mix(vLayout.count);
+
+			for (uint32_t i = 0u; i < vLayout.count; ++i)
+			{
+				Mix(static_cast<uint32_t>(vLayout.elements[i].attribute));
+				Mix(static_cast<uint32_t>(vLayout.elements[i].format));
+				Mix(vLayout.elements[i].offset);
+			}
+
+			return hash;
+		}
+
+		bool CreateVertexLayout(const CGBuffer& vBuffer, CGRenderer& renderer, CGShader& vShader, CGVertexLayout& vLayout)
+		{
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+
+			if (bufferPool.vlCount + 1u > CG_MAX_VERTEX_LAYOUTS || vLayout.count > CG_MAX_VERTEX_ELEMENTS)
+			{
+				return false;
+			}
+
+			vLayout.hash = HashVertexLayout(vLayout);
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::DeviceOps::CreateVertexLayout(renderer.device, vShader, vLayout))
+					{
+						return false;
+					}
+
+					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
+					bufferPool.vlCount++;
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::CreateVertexArray(renderer.context, bufferPool, vBuffer, bufferPool.vlCount, vLayout))
+					{
+						return false;
+					}
+
+					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
+					bufferPool.vlCount++;
+
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+					// Layouts are baked into pipelines by CreatePipelineState
+					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
+					bufferPool.vlCount++;
+
+					break;
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::DeviceOps::CreateVertexLayout(renderer.context, vLayout))
+					{
+						return false;
+					}
+
+					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
+					bufferPool.vlCount++;
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					// Vertices are fetched straight through the layout, there is nothing to create
+					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
+					bufferPool.vlCount++;
+
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGRenderer& renderer, CGBuffer& vBuffer, const void* vbData)
+		{
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+
+			if (bufferPool.vbCount + 1u > CG_MAX_VERTEX_BUFFERS)
+			{
+				return false;
+			}
+
+			vBuffer.desc = vbDesc;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::DeviceOps::CreateVertexBuffer(renderer.device, vbDesc, vBuffer, vbData))
+					{
+						return false;
+					}
+
+					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
+					bufferPool.vbCount++;
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::CreateVertexBuffer(vbDesc, vBuffer, vbData))
+					{
+						return false;
+					}
+
+					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
+					bufferPool.vbCount++;
+
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					if (!Vulkan::DeviceOps::CreateVertexBuffer(renderer.device, vbDesc, vBuffer, vbData))
+					{
+						return false;
+					}
+
+					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
+					bufferPool.vbCount++;
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::DeviceOps::CreateVertexBuffer(renderer.context, vbDesc, vBuffer, vbData))
+					{
+						return false;
+					}
+
+					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
+					bufferPool.vbCount++;
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					if (!Software::DeviceOps::CreateVertexBuffer(vbDesc, vBuffer, vbData))
+					{
+						return false;
+					}
+
+					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
+					bufferPool.vbCount++;
+
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGRenderer& renderer, CGBuffer& iBuffer, const void* ibData)
+		{
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+
+			if (bufferPool.ibCount + 1u > CG_MAX_INDEX_BUFFERS)
+			{
+				return false;
+			}
+
+			iBuffer.desc = ibDesc;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+					//if (!D3D11::DeviceOps::CreateIndexBuffer(renderer.device, ibDesc, iBuffer, ibData))
+					//{
+					//	return false;
+					//}
+
+					//bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
+					//bufferPool.ibCount++;
+
+					break;
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::CreateIndexBuffer(ibDesc, iBuffer, ibData))
+					{
+						return false;
+					}
+
+					bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
+					bufferPool.ibCount++;
+
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					if (!Vulkan::DeviceOps::CreateIndexBuffer(renderer.device, ibDesc, iBuffer, ibData))
+					{
+						return false;
+					}
+
+					bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
+					bufferPool.ibCount++;
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::DeviceOps::CreateIndexBuffer(renderer.context, ibDesc, iBuffer, ibData))
+					{
+						return false;
+					}
+
+					bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
+					bufferPool.ibCount++;
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					if (!Software::DeviceOps::CreateIndexBuffer(ibDesc, iBuffer, ibData))
+					{
+						return false;
+					}
+
+					bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
+					bufferPool.ibCount++;
+
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool CreateConstantBuffer(const CGBufferDesc& cbDesc, CGRenderer& renderer, CGBuffer& cBuffer, const void* cbData)
+		{
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+
+			if (bufferPool.cbCount + 1u > CG_MAX_CONSTANT_BUFFERS || cbDesc.type != CGBufferType::Constant)
+			{
+				return false;
+			}
+
+			cBuffer.desc = cbDesc;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::DeviceOps::CreateConstantBuffer(renderer.device, cbDesc, cBuffer, cbData))
+					{
+						return false;
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::DeviceOps::CreateConstantBuffer(cbDesc, cBuffer, cbData))
+					{
+						return false;
+					}
+
+					break;
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::DeviceOps::CreateConstantBuffer(renderer.context, cbDesc, cBuffer, cbData))
+					{
+						return false;
+					}
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					if (!Software::DeviceOps::CreateConstantBuffer(cbDesc, cBuffer, cbData))
+					{
+						return false;
+					}
+
+					break;
+				}
+			}
+
+			bufferPool.constantBuffers[bufferPool.cbCount] = cBuffer;
+			bufferPool.cbCount++;
+
+			return true;
+		}
+
+		bool GetWritePointer(const CGBuffer& buffer, const CGRenderer& renderer, void*& data)
+		{
+			if (GetUploadStrategy(buffer.desc) != CGUploadStrategy::PersistentMap)
+			{
+				return false;
+			}
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				case CGRendererType::Direct3D11:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				case CGRendererType::Null:
+				case CGRendererType::Software:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					data = OpenGL::DeviceOps::GetWritePointer(buffer, renderer.resourcePool.recordPool);
+					break;
+				}
+			}
+
+			return data != nullptr;
+		}
+
+		// Appends an upload record for the frame being recorded, its data area follows the record
+		static CGBufferUpload* RecordUpload(const CGBufferType type, const uint32_t buffer, const CGBuffer& cgBuffer, const uint32_t offset, const uint32_t size, CGRenderer& renderer)
+		{
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				case CGRendererType::Direct3D11:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				{
+					return nullptr;
+				}
+				case CGRendererType::OpenGL:
+				case CGRendererType::Null:
+				case CGRendererType::Software:
+				{
+					break;
+				}
+			}
+
+			const CGUploadStrategy strategy = GetUploadStrategy(cgBuffer.desc);
+
+			// Orphaning throws away the whole store, an update that leaves part of it out would lose that part
+			if (strategy == CGUploadStrategy::Orphan && (offset != 0u || size != cgBuffer.desc.size))
+			{
+				printf("Orphaned buffers can only be updated as a whole\n");
+				return nullptr;
+			}
+
+			CGCommandPool& cmdPool = renderer.resourcePool.commandPools[renderer.resourcePool.recordPool];
+
+			// Growing the arena would move the data area handed out by MapBuffer
+			if (cmdPool.mappedUpload != CG_NO_UPLOAD)
+			{
+				printf("Buffer uploads are blocked until the mapped buffer is unmapped\n");
+				return nullptr;
+			}
+
+			CGLinearArena& uploads = cmdPool.uploads;
+			const uint32_t stride = AlignUp(static_cast<uint32_t>(sizeof(CGBufferUpload)) + size, 16u);
+			void* memory = ArenaOps::Allocate(stride, uploads);
+
+			if (!memory)
+			{
+				return nullptr;
+			}
+
+			CGBufferUpload* upload = new (memory) CGBufferUpload();
+			upload->buffer = buffer;
+			upload->offset = offset;
+			upload->size = size;
+			upload->stride = stride;
+			upload->type = type;
+			upload->strategy = strategy;
+
+			return upload;
+		}
+
+		bool UpdateBuffer(const CGBufferType type, const uint32_t buffer, const uint32_t offset, const uint32_t size, const void* data, CGRenderer& renderer)
+		{
+			const CGBuffer* cgBuffer = GetBuffer(type, buffer, renderer.resourcePool.bufferPool);
+
+			if (!cgBuffer || data == nullptr || size < 1u || offset > cgBuffer->desc.size || size > cgBuffer->desc.size - offset)
+			{
+				return false;
+			}
+
+			// Persistently mapped segments are written in place, nothing is left to do at execution
+			void* segment = nullptr;
+			if (GetWritePointer(*cgBuffer, renderer, segment))
+			{
+				memcpy(static_cast<uint8_t*>(segment) + offset, data, size);
+
+				CGUploadStats& stats = renderer.resourcePool.uploadStats[static_cast<uint8_t>(CGUploadStrategy::PersistentMap)];
+				stats.uploads++;
+				stats.bytes += size;
+
+				return true;
+			}
+
+			CGBufferUpload* upload = RecordUpload(type, buffer, *cgBuffer, offset, size, renderer);
+
+			if (!upload)
+			{
+				return false;
+			}
+
+			memcpy(upload + 1, data, size);
+			upload->committed = true;
+
+			return true;
+		}
+
+		bool MapBuffer(const CGBufferType type, const uint32_t buffer, const uint32_t offset, const uint32_t size, CGRenderer& renderer, void*& data)
+		{
+			CGCommandPool& cmdPool = renderer.resourcePool.commandPools[renderer.resourcePool.recordPool];
+			const CGBuffer* cgBuffer = GetBuffer(type, buffer, renderer.resourcePool.bufferPool);
+
+			if (!cgBuffer || size < 1u || offset > cgBuffer->desc.size || size > cgBuffer->desc.size - offset)
+			{
+				return false;
+			}
+
+			void* segment = nullptr;
+			if (GetWritePointer(*cgBuffer, renderer, segment))
+			{
+				data = static_cast<uint8_t*>(segment) + offset;
+
+				CGUploadStats& stats = renderer.resourcePool.uploadStats[static_cast<uint8_t>(CGUploadStrategy::PersistentMap)];
+				stats.uploads++;
+				stats.bytes += size;
+
+				return true;
+			}
+
+			CGBufferUpload* upload = RecordUpload(type, buffer, *cgBuffer, offset, size, renderer);
+
+			if (!upload)
+			{
+				return false;
+			}
+
+			cmdPool.mappedUpload = static_cast<uint32_t>(cmdPool.uploads.size - upload->stride);
+			data = upload + 1;
+
+			return true;
+		}
+
+		bool UnmapBuffer(const CGBufferType type, const uint32_t buffer, CGRenderer& renderer)
+		{
+			CGCommandPool& cmdPool = renderer.resourcePool.commandPools[renderer.resourcePool.recordPool];
+			const CGBuffer* cgBuffer = GetBuffer(type, buffer, renderer.resourcePool.bufferPool);
+
+			if (!cgBuffer)
+			{
+				return false;
+			}
+
+			// Mapped in place, nothing was recorded
+			if (GetUploadStrategy(cgBuffer->desc) == CGUploadStrategy::PersistentMap && GetRendererType(renderer) == CGRendererType::OpenGL)
+			{
+				return true;
+			}
+
+			if (cmdPool.mappedUpload == CG_NO_UPLOAD)
+			{
+				return false;
+			}
+
+			CGBufferUpload* upload = reinterpret_cast<CGBufferUpload*>(ArenaOps::GetData<uint8_t>(cmdPool.uploads) + cmdPool.mappedUpload);
+
+			if (upload->type != type || upload->buffer != buffer)
+			{
+				return false;
+			}
+
+			upload->committed = true;
+			cmdPool.mappedUpload = CG_NO_UPLOAD;
+
+			return true;
+		}
+
+		bool AllocateTransient(const uint32_t size, const uint32_t alignment, CGRenderer& renderer, CGTransientAllocation& allocation)
+		{
+			if (size < 1u || alignment == 0u || (alignment & (alignment - 1u)) != 0u)
+			{
+				return false;
+			}
+
+			const uint8_t pool = renderer.resourcePool.recordPool;
+			CGCommandPool& cmdPool = renderer.resourcePool.commandPools[pool];
+
+			const uint32_t offset = AlignUp(cmdPool.transientSize, alignment);
+
+			if (offset > CG_TRANSIENT_SIZE || size > CG_TRANSIENT_SIZE - offset)
+			{
+				printf("Transient memory exhausted, %u bytes requested\n", size);
+				return false;
+			}
+
+			uint8_t* memory = nullptr;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				case CGRendererType::Direct3D11:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					memory = static_cast<uint8_t*>(OpenGL::DeviceOps::GetTransientMemory(renderer.context, pool));
+					break;
+				}
+				case CGRendererType::Null:
+				case CGRendererType::Software:
+				{
+					// Reserved once and never grown, slices handed out earlier must not move
+					if (!ArenaOps::Reserve(CG_TRANSIENT_SIZE, cmdPool.transient))
+					{
+						return false;
+					}
+
+					memory = ArenaOps::GetData<uint8_t>(cmdPool.transient);
+					break;
+				}
+			}
+
+			if (!memory)
+			{
+				return false;
+			}
+
+			cmdPool.transientSize = offset + size;
+
+			allocation.buffer = CG_TRANSIENT_BUFFER;
+			allocation.offset = offset;
+			allocation.data = memory + offset;
+
+			return true;
+		}
+
+		bool AllocateConstants(const uint32_t size, CGRenderer& renderer, CGTransientAllocation& allocation)
+		{
+			return AllocateTransient(size, renderer.device.deviceInfo.constantAlignment, renderer, allocation);
+		}
+
+		// Transient memory only lives for one frame, bundles are replayed across many
+		static bool ReferencesTransient(const CGCommandStream& stream)
+		{
+			const uint8_t* cursor = ArenaOps::GetData<uint8_t>(stream.commands);
+			const uint8_t* end = cursor + stream.commands.size;
+
+			while (cursor < end)
+			{
+				const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+				cursor += header.size;
+
+				switch (static_cast<CGRenderCommandType>(header.type))
+				{
+					case CGRenderCommandType::SetVertexBuffer:
+					{
+						if (GetCommand<CGSetVertexBufferCommand>(header).buffer == CG_TRANSIENT_BUFFER)
+						{
+							return true;
+						}
+
+						break;
+					}
+					case CGRenderCommandType::SetIndexBuffer:
+					{
+						if (GetCommand<CGSetIndexBufferCommand>(header).buffer == CG_TRANSIENT_BUFFER)
+						{
+							return true;
+						}
+
+						break;
+					}
+					case CGRenderCommandType::SetConstantBuffer:
+					{
+						if (GetCommand<CGSetConstantBufferCommand>(header).buffer == CG_TRANSIENT_BUFFER)
+						{
+							return true;
+						}
+
+						break;
+					}
+					default:
+					{
+						break;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		bool CreateRenderBundle(const CGCommandStream& stream, CGRenderer& renderer, uint32_t& bundle)
+		{
+			CGBundlePool& bundlePool = renderer.resourcePool.bundlePool;
+
+			if (stream.packetCount < 1u || bundlePool.count + 1u > CG_MAX_RENDER_BUNDLES || ReferencesTransient(stream))
+			{
+				return false;
+			}
+
+			CGRenderBundle& renderBundle = bundlePool.bundles[bundlePool.count];
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::ContextOps::CompileBundle(renderer.context, renderer.resourcePool, stream, renderBundle))
+					{
+						return false;
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					if (!OpenGL::ContextOps::CompileBundle(renderer.context, renderer.resourcePool, stream, renderBundle))
+					{
+						return false;
+					}
+
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					if (!Vulkan::ContextOps::CompileBundle(renderer.context, renderer.resourcePool, stream, renderBundle))
+					{
+						return false;
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Null:
+				{
+					if (!Null::ContextOps::CompileBundle(stream, renderBundle))
+					{
+						return false;
+					}
+
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					if (!Software::ContextOps::CompileBundle(stream, renderBundle))
+					{
+						return false;
+					}
+
+					break;
+				}
+			}
+
+			bundle = bundlePool.count;
+			bundlePool.count++;
+
+			return true;
+		}
+
+		bool CreatePipelineState(const CGPipelineDesc& desc, CGRenderer& renderer, uint32_t& pipeline)
+		{
+			CGPipelinePool& pipelinePool = renderer.resourcePool.pipelinePool;
+
+			CGPipelineDesc key = desc;
+			key.padding = 0u;
+
+			const uint64_t hash = HashBytes(&key, sizeof(CGPipelineDesc), CG_HASH_SEED);
+
+			for (uint32_t i = 0u; i < pipelinePool.count; ++i)
+			{
+				const CGPipelineState& existing = pipelinePool.pipelines[i];
+
+				if (existing.hash == hash && std::memcmp(&existing.desc, &key, sizeof(CGPipelineDesc)) == 0)
+				{
+					pipeline = i;
+					return true;
+				}
+			}
+
+			if (pipelinePool.count + 1u > CG_MAX_PIPELINE_STATES)
+			{
+				return false;
+			}
+
+			CGPipelineState& state = pipelinePool.pipelines[pipelinePool.count];
+			state = CGPipelineState{};
+			state.desc = key;
+			state.hash = hash;
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				{
+					return false;
+				}
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::DeviceOps::CreatePipelineState(renderer.device, renderer.resourcePool.shaderPool, state))
+					{
+						return false;
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Direct3D12:
+				{
+					return false;
+				}
+				case CGRendererType::OpenGL:
+				{
+					// Applied state by state from the desc, there is no API object to create
+					if (key.program == 0u)
+					{
+						return false;
+					}
+
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					if (!Vulkan::DeviceOps::CreatePipelineState(renderer.context, renderer.resourcePool.bufferPool, state))
+					{
+						return false;
+					}
+
+					break;
+#else
+					return false;
+#endif
+				}
+				case CGRendererType::Null:
+				{
+					renderer.context.api.null.stats.pipelines++;
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					// Triangle lists are all the rasterizer draws
+					if (key.topology != CGPrimitiveTopology::TriangleList)
+					{
+						return false;
+					}
+
+					break;
+				}
+			}
+
+			pipeline = pipelinePool.count;
+			pipelinePool.count++;
+
+			return true;
+		}
+
+		// Only the buffer created last can be handed back, the pools hand out indices in order
+		static void DestroyLastBuffer(const CGBufferType type, CGRenderer& renderer)
+		{
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+			uint32_t& count = type == CGBufferType::Vertex ? bufferPool.vbCount : bufferPool.ibCount;
+			CGBuffer* buffers = type == CGBufferType::Vertex ? bufferPool.vertexBuffers : bufferPool.indexBuffers;
+
+			if (count < 1u)
+			{
+				return;
+			}
+
+			CGBuffer& buffer = buffers[count - 1u];
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::Direct3D11:
+				{
+#if defined(CG_HAS_D3D11)
+					D3D11::DeviceOps::DestroyBuffer(buffer);
+#endif
+					break;
+				}
+				case CGRendererType::OpenGL:
+				{
+					OpenGL::DeviceOps::DestroyBuffer(buffer);
+					break;
+				}
+				case CGRendererType::Vulkan:
+				{
+#if defined(CG_HAS_VULKAN)
+					Vulkan::DeviceOps::DestroyBuffer(renderer.device, buffer);
+#endif
+					break;
+				}
+				case CGRendererType::Null:
+				{
+					Null::DeviceOps::DestroyBuffer(renderer.context, buffer);
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					Software::DeviceOps::DestroyBuffer(buffer);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+
+			buffer = CGBuffer{};
+			count--;
+		}
+
+		bool CreateGeometryHeap(const CGGeometryHeapDesc& desc, CGRenderer& renderer, uint32_t& heap)
+		{
+			CGHeapPool& heapPool = renderer.resourcePool.heapPool;
+			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+
+			if (heapPool.count + 1u > CG_MAX_GEOMETRY_HEAPS || desc.vertexCapacity < 1u || desc.vertexStride < 1u)
+			{
+				return false;
+			}
+
+			// Meshes are written with deferred uploads, ordered after the frames still drawing freed ranges
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::OpenGL:
+				case CGRendererType::Null:
+				case CGRendererType::Software:
+				{
+					break;
+				}
+				default:
+				{
+					return false;
+				}
+			}
+
+			CGGeometryHeap& geometryHeap = heapPool.heaps[heapPool.count];
+
+			CGBufferDesc vbDesc = {};
+			vbDesc.count = desc.vertexCapacity;
+			vbDesc.stride = desc.vertexStride;
+			vbDesc.size = desc.vertexCapacity * desc.vertexStride;
+			vbDesc.type = CGBufferType::Vertex;
+			vbDesc.usage = CGBufferUsage::Static;
+			vbDesc.upload = CGUploadStrategy::Staging;
+
+			CGBuffer vBuffer = {};
+			if (!CreateVertexBuffer(vbDesc, renderer, vBuffer, nullptr))
+			{
+				return false;
+			}
+
+			geometryHeap.vertexBuffer = bufferPool.vbCount - 1u;
+
+			if (desc.indexCapacity > 0u)
+			{
+				CGBufferDesc ibDesc = {};
+				ibDesc.count = desc.indexCapacity;
+				ibDesc.stride = sizeof(uint16_t);
+				ibDesc.size = desc.indexCapacity * static_cast<uint32_t>(sizeof(uint16_t));
+				ibDesc.type = CGBufferType::Index;
+				ibDesc.usage = CGBufferUsage::Static;
+				ibDesc.upload = CGUploadStrategy::Staging;
+
+				CGBuffer iBuffer = {};
+				if (!CreateIndexBuffer(ibDesc, renderer, iBuffer, nullptr))
+				{
+					DestroyLastBuffer(CGBufferType::Vertex, renderer);
+					return false;
+				}
+
+				geometryHeap.indexBuffer = bufferPool.ibCount - 1u;
+			}
+
+			ArenaOps::Reset(geometryHeap.freeVertices);
+			ArenaOps::Reset(geometryHeap.freeIndices);
+
+			CGHeapRange* vertices = static_cast<CGHeapRange*>(ArenaOps::Allocate(sizeof(CGHeapRange), geometryHeap.freeVertices));
+			CGHeapRange* indices = desc.indexCapacity > 0u ? static_cast<CGHeapRange*>(ArenaOps::Allocate(sizeof(CGHeapRange), geometryHeap.freeIndices)) : nullptr;
+
+			if (!vertices || (desc.indexCapacity > 0u && !indices))
+			{
+				if (desc.indexCapacity > 0u)
+				{
+					DestroyLastBuffer(CGBufferType::Index, renderer);
+				}
+
+				DestroyLastBuffer(CGBufferType::Vertex, renderer);
+				return false;
+			}
+
+			vertices->offset = 0u;
+			vertices->count = desc.vertexCapacity;
+
+			if (indices)
+			{
+				indices->offset = 0u;
+				indices->count = desc.indexCapacity;
+			}
+
+			geometryHeap.vertexCapacity = desc.vertexCapacity;
+			geometryHeap.indexCapacity = desc.indexCapacity;
+			geometryHeap.vertexStride = desc.vertexStride;
+			geometryHeap.meshCount = 0u;
+
+			heap = heapPool.count;
+			heapPool.count++;
+
+			return true;
+		}
+
+		// First fit over the free ranges, the remainder of the range stays in place so the list stays sorted
+		static bool AllocateRange(const uint32_t count, CGLinearArena& freeList, uint32_t& offset)
+		{
+			CGHeapRange* ranges = ArenaOps::GetData<CGHeapRange>(freeList);
+			const size_t rangeCount = freeList.size / sizeof(CGHeapRange);
+
+			for (size_t i = 0ull; i < rangeCount; i++)
+			{
+				if (ranges[i].count < count)
+				{
+					continue;
+				}
+
+				offset = ranges[i].offset;
+				ranges[i].offset += count;
+				ranges[i].count -= count;
+
+				if (ranges[i].count == 0u)
+				{
+					memmove(&ranges[i], &ranges[i + 1u], (rangeCount - i - 1u) * sizeof(CGHeapRange));
+					freeList.size -= sizeof(CGHeapRange);
+				}
+
+				return true;
+			}
+
+			return false;
+		}
+
+		// Sorted insert, merged with its neighbours so freed meshes add up to larger holes again
+		static bool FreeRange(const CGHeapRange& range, CGLinearArena& freeList)
+		{
+			CGHeapRange* ranges = ArenaOps::GetData<CGHeapRange>(freeList);
+			size_t rangeCount = freeList.size / sizeof(CGHeapRange);
+
+			size_t i = 0ull;
+			while (i < rangeCount && ranges[i].offset < range.offset)
+			{
+				i++;
+			}
+
+			const bool mergePrevious = i > 0ull && ranges[i - 1u].offset + ranges[i - 1u].count == range.offset;
+			const bool mergeNext = i < rangeCount && range.offset + range.count == ranges[i].offset;
+
+			if (mergePrevious && mergeNext)
+			{
+				ranges[i - 1u].count += range.count + ranges[i].count;
+				memmove(&ranges[i], &ranges[i + 1u], (rangeCount - i - 1u) * sizeof(CGHeapRange));
+				freeList.size -= sizeof(CGHeapRange);
+
+				return true;
+			}
+
+			if (mergePrevious)
+			{
+				ranges[i - 1u].count += range.count;
+				return true;
+			}
+
+			if (mergeNext)
+			{
+				ranges[i].offset = range.offset;
+				ranges[i].count += range.count;
+				return true;
+			}
+
+			// Growing the arena may move it
+			if (!ArenaOps::Allocate(sizeof(CGHeapRange), freeList))
+			{
+				return false;
+			}
+
+			ranges = ArenaOps::GetData<CGHeapRange>(freeList);
+			memmove(&ranges[i + 1u], &ranges[i], (rangeCount - i) * sizeof(CGHeapRange));
+			ranges[i] = range;
+
+			return true;
+		}
+
+		bool AllocateGeometry(const uint32_t heap, const uint32_t vertexCount, const void* vertices, const uint32_t indexCount, const uint16_t* indices, CGRenderer& renderer, CGGeometryAllocation& allocation)
+		{
+			CGHeapPool& heapPool = renderer.resourcePool.heapPool;
+
+			if (heap >= heapPool.count || vertexCount < 1u || vertices == nullptr || (indexCount > 0u && indices == nullptr))
+			{
+				return false;
+			}
+
+			CGGeometryHeap& geometryHeap = heapPool.heaps[heap];
+
+			if (indexCount > geometryHeap.indexCapacity)
+			{
+				return false;
+			}
+
+			CGGeometryAllocation result = {};
+			result.heap = heap;
+			result.vertices.count = vertexCount;
+			result.indices.count = indexCount;
+
+			if (!AllocateRange(vertexCount, geometryHeap.freeVertices, result.vertices.offset))
+			{
+				printf("Geometry heap %u is out of vertex space\n", heap);
+				return false;
+			}
+
+			if (indexCount > 0u && !AllocateRange(indexCount, geometryHeap.freeIndices, result.indices.offset))
+			{
+				printf("Geometry heap %u is out of index space\n", heap);
+				FreeRange(result.vertices, geometryHeap.freeVertices);
+				return false;
+			}
+
+			const uint32_t stride = geometryHeap.vertexStride;
+			bool uploaded = UpdateBuffer(CGBufferType::Vertex, geometryHeap.vertexBuffer, result.vertices.offset * stride, vertexCount * stride, vertices, renderer);
+
+			if (uploaded && indexCount > 0u)
+			{
+				const uint32_t indexSize = static_cast<uint32_t>(sizeof(uint16_t));
+				uploaded = UpdateBuffer(CGBufferType::Index, geometryHeap.indexBuffer, result.indices.offset * indexSize, indexCount * indexSize, indices, renderer);
+			}
+
+			if (!uploaded)
+			{
+				FreeRange(result.vertices, geometryHeap.freeVertices);
+
+				if (indexCount > 0u)
+				{
+					FreeRange(result.indices, geometryHeap.freeIndices);
+				}
+
+				return false;
+			}
+
+			geometryHeap.meshCount++;
+			allocation = result;
+
+			return true;
+		}
+
+		// In range and not overlapping any free range, which catches double frees. A stale allocation whose
+		// range was handed out again since cannot be told apart from the new owner's.
+		static bool IsAllocatedRange(const CGHeapRange& range, const uint32_t capacity, const CGLinearArena& freeList)
+		{
+			if (range.count < 1u || range.offset > capacity || range.count > capacity - range.offset)
+			{
+				return false;
+			}
+
+			const CGHeapRange* ranges = ArenaOps::GetData<CGHeapRange>(freeList);
+			const size_t rangeCount = freeList.size / sizeof(CGHeapRange);
+
+			for (size_t i = 0ull; i < rangeCount; i++)
+			{
+				if (ranges[i].offset < range.offset + range.count && range.offset < ranges[i].offset + ranges[i].count)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool FreeGeometry(const CGGeometryAllocation& allocation, CGRenderer& renderer)
+		{
+			CGHeapPool& heapPool = renderer.resourcePool.heapPool;
+
+			if (allocation.heap >= heapPool.count)
+			{
+				return false;
+			}
+
+			CGGeometryHeap& geometryHeap = heapPool.heaps[allocation.heap];
+
+			if (geometryHeap.meshCount < 1u || !IsAllocatedRange(allocation.vertices, geometryHeap.vertexCapacity, geometryHeap.freeVertices) ||
+				(allocation.indices.count > 0u && !IsAllocatedRange(allocation.indices, geometryHeap.indexCapacity, geometryHeap.freeIndices)))
+			{
+				printf("Invalid geometry allocation in heap %u\n", allocation.heap);
+				return false;
+			}
+
+			FreeRange(allocation.vertices, geometryHeap.freeVertices);
+
+			if (allocation.indices.count > 0u)
+			{
+				FreeRange(allocation.indices, geometryHeap.freeIndices);
+			}
+
+			geometryHeap.meshCount--;
+
+			return true;
+		}
+
+		bool ReserveTexture(CGRenderer& renderer, uint32_t& texture)
+		{
+			CGTexturePool& texturePool = renderer.resourcePool.texturePool;
+			uint32_t count = texturePool.tCount.load(std::memory_order_relaxed);
+
+			// The engine reserves while the context thread creates textures, so the slot is claimed atomically
+			do
+			{
+				if (count + 1u > CG_MAX_TEXTURES)
+				{
+					return false;
+				}
+			} while (!texturePool.tCount.compare_exchange_weak(count, count + 1u, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+			// The context thread may already see the new count, so the slot reads as None until this store
+			texturePool.textures[count].state.store(CGTextureState::Loading, std::memory_order_release);
+			texture = count;
+
+			return true;
+		}
+
+		static bool CreateTextureStorage(CGRenderer& renderer, CGTexture& texture)
+		{
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				{
+					// Sampled images need descriptor sets, which the Vulkan backend does not have yet
+					return false;
+				}
+				case CGRendererType::Direct3D11:
 				{
+#if defined(CG_HAS_D3D11)
+					return D3D11::DeviceOps::CreateTexture(renderer.device, texture);
+#else
 					return false;
+#endif
 				}
 				case CGRendererType::OpenGL:
 				{
-					if (!OpenGL::DeviceOps::CreateShader(desc, shader))
-					{
-						return false;
-					}
-
-					switch (desc.shaderType)
-					{
-						case CGShaderType::Vertex:
-						{
-							shaderPool.vertexShaders[shaderPool.vsCount] = shader;
-							shaderPool.vsCount++;
-							break;
-						}
-						case CGShaderType::Fragment:
-						{
-							shaderPool.fragmentShaders[shaderPool.fsCount] = shader;
-							shaderPool.fsCount++;
-							break;
-						}
-					}
-
-					break;
+					return OpenGL::DeviceOps::CreateTexture(texture);
 				}
-				case CGRendererType::Vulkan:
+				case CGRendererType::Null:
 				{
-					return false;
+					renderer.context.api.null.stats.textures++;
+					return true;
+				}
+				case CGRendererType::Software:
+				{
+					// The built-in software shaders do not sample textures, only the levels are tracked
+					return true;
 				}
 			}
 
+			return false;
+		}
+
+		static bool IsValidTextureDesc(const CGTextureDesc& desc)
+		{
+			const uint32_t size = desc.width > desc.height ? desc.width : desc.height;
+
+			// The chain may stop early, but never goes past the 1x1 level
+			return desc.width > 0u && desc.height > 0u && desc.mipCount > 0u && desc.mipCount <= CG_MAX_TEXTURE_MIPS &&
+				(size >> (desc.mipCount - 1u)) > 0u && desc.format == CGTextureFormat::RGBA8 && desc.layers <= CG_MAX_TEXTURE_LAYERS;
+		}
+
+		bool CreateTexture(const uint32_t texture, const CGTextureDesc& desc, std::unique_ptr<uint8_t[]> mips, CGRenderer& renderer)
+		{
+			CGTexturePool& texturePool = renderer.resourcePool.texturePool;
+
+			if (texture >= texturePool.tCount.load(std::memory_order_acquire) || texturePool.textures[texture].state.load(std::memory_order_acquire) != CGTextureState::Loading || !mips)
+			{
+				return false;
+			}
+
+			// Array textures are filled region by region through atlases, never streamed
+			if (!IsValidTextureDesc(desc) || desc.layers != 0u)
+			{
+				return false;
+			}
+
+			CGTexture& target = texturePool.textures[texture];
+			target.desc = desc;
+			target.state.store(CGTextureState::Failed, std::memory_order_release);
+
+			if (!CreateTextureStorage(renderer, target))
+			{
+				return false;
+			}
+
+			target.mips = std::move(mips);
+			target.residentMip = desc.mipCount;
+			target.state.store(CGTextureState::Streaming, std::memory_order_release);
+
+			texturePool.streaming[texturePool.streamingCount] = texture;
+			texturePool.streamingCount++;
+
 			return true;
 		}
 
-		bool CreateShaderProgram(const uint8_t count, const CGShader shaders[], CGRenderer& renderer, uint32_t& program)
+		bool CreateSampler(const CGSamplerDesc& desc, CGRenderer& renderer, uint32_t& sampler)
 		{
-			CGShaderPool& shaderPool = renderer.resourcePool.shaderPool;
+			CGTexturePool& texturePool = renderer.resourcePool.texturePool;
 
-			if (count < 1 || shaders == nullptr || shaderPool.pCount + count >= CG_MAX_SHADER_PROGRAMS)
+			for (uint32_t i = 0u; i < texturePool.sCount; ++i)
+			{
+				if (std::memcmp(&texturePool.samplers[i].desc, &desc, sizeof(CGSamplerDesc)) == 0)
+				{
+					sampler = i;
+					return true;
+				}
+			}
+
+			if (texturePool.sCount + 1u > CG_MAX_SAMPLERS || desc.maxAnisotropy < 1u)
 			{
 				return false;
 			}
 
-			switch (renderer.type)
+			CGSampler& target = texturePool.samplers[texturePool.sCount];
+			target = CGSampler{};
+			target.desc = desc;
+
+			switch (GetRendererType(renderer))
 			{
 				case CGRendererType::None:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
 				{
 					return false;
 				}
 				case CGRendererType::Direct3D11:
 				{
+#if defined(CG_HAS_D3D11)
+					if (!D3D11::DeviceOps::CreateSampler(renderer.device, target))
+					{
+						return false;
+					}
+
 					break;
-				}
-				case CGRendererType::Direct3D12:
-				{
+#else
 					return false;
+#endif
 				}
 				case CGRendererType::OpenGL:
 				{
-					if (!OpenGL::DeviceOps::CreateShaderProgram(count, shaders, program))
+					if (!OpenGL::DeviceOps::CreateSampler(target))
 					{
 						return false;
 					}
 
-					shaderPool.programs[shaderPool.pCount] = program;
-					shaderPool.pCount++;
-
 					break;
 				}
-				case CGRendererType::Vulkan:
+				case CGRendererType::Null:
 				{
-					return false;
+					renderer.context.api.null.stats.samplers++;
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					break;
 				}
 			}
 
+			sampler = texturePool.sCount;
+			texturePool.sCount++;
+
 			return true;
 		}
 
-		bool SetupVertexLayout(const uint8_t count, CGVertexElement elements[], CGRenderer& renderer, CGVertexLayout& vLayout)
+		bool CreateTextureAtlas(const CGTextureDesc& desc, CGRenderer& renderer, uint32_t& atlas)
 		{
-			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+			CGAtlasPool& atlasPool = renderer.resourcePool.atlasPool;
+			CGTexturePool& texturePool = renderer.resourcePool.texturePool;
 
-			if (count < 1 || elements == nullptr || bufferPool.vlCount + 1 >= CG_MAX_VERTEX_LAYOUTS)
+			if (atlasPool.count + 1u > CG_MAX_TEXTURE_ATLASES || !IsValidTextureDesc(desc) || desc.layers < 1u)
 			{
 				return false;
 			}
 
-			uint32_t offset = 0u;
-			uint32_t size = 0u;
-
-			for (uint8_t i = 0; i < count; ++i)
+			uint32_t texture = 0u;
+			if (!ReserveTexture(renderer, texture))
 			{
-				elements[i].size = GetAttributeSize(elements[i].format);
-				size += elements[i].size;
+				return false;
+			}
 
-				if (i > 0)
-				{
-					offset += elements[i - 1].size;
-					elements[i].offset = offset;
-				}
+			CGTexture& target = texturePool.textures[texture];
+			target.desc = desc;
+			target.state.store(CGTextureState::Failed, std::memory_order_release);
 
-				vLayout.elements[i] = elements[i];
+			if (!CreateTextureStorage(renderer, target))
+			{
+				return false;
 			}
 
-			vLayout.count = count;
-			vLayout.size = size;
+			// Every level can be sampled right away, regions only show up once their texels are uploaded
+			target.residentMip = 0u;
+			target.state.store(CGTextureState::Resident, std::memory_order_release);
+
+			CGTextureAtlas& textureAtlas = atlasPool.atlases[atlasPool.count];
+			ArenaOps::Reset(textureAtlas.shelves);
+			textureAtlas.texture = texture;
+			textureAtlas.shelfCount = 0u;
+			textureAtlas.top = 0u;
+			textureAtlas.layer = 0u;
+
+			atlas = atlasPool.count;
+			atlasPool.count++;
 
 			return true;
 		}
 
-		bool CreateVertexLayout(const CGBuffer& vBuffer, CGRenderer& renderer, CGShader& vShader, CGVertexLayout& vLayout)
+		bool AllocateAtlasRegion(const uint32_t atlas, const uint32_t width, const uint32_t height, CGRenderer& renderer, CGAtlasRegion& region)
 		{
-			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+			CGAtlasPool& atlasPool = renderer.resourcePool.atlasPool;
 
-			switch (renderer.type)
+			if (atlas >= atlasPool.count || width < 1u || height < 1u)
 			{
-				case CGRendererType::None:
-				{
-					return false;
-				}
-				case CGRendererType::Direct3D11:
-				{
-					if (!D3D11::DeviceOps::CreateVertexLayout(renderer.device, vShader, vLayout))
-					{
-						return false;
-					}
+				return false;
+			}
 
-					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
-					bufferPool.vlCount++;
+			CGTextureAtlas& textureAtlas = atlasPool.atlases[atlas];
+			const CGTextureDesc& desc = renderer.resourcePool.texturePool.textures[textureAtlas.texture].desc;
 
-					break;
-				}
-				case CGRendererType::Direct3D12:
+			// Regions start and end on whole texels of the coarsest level, so filtering never reaches into a neighbour
+			const uint32_t alignment = 1u << (desc.mipCount - 1u);
+			const uint32_t alignedWidth = (width + alignment - 1u) & ~(alignment - 1u);
+			const uint32_t alignedHeight = (height + alignment - 1u) & ~(alignment - 1u);
+
+			if (alignedWidth > desc.width || alignedHeight > desc.height)
+			{
+				return false;
+			}
+
+			CGAtlasShelf* shelves = ArenaOps::GetData<CGAtlasShelf>(textureAtlas.shelves);
+			uint32_t best = textureAtlas.shelfCount;
+
+			// The lowest shelf the image fits on wastes the least height
+			for (uint32_t i = 0u; i < textureAtlas.shelfCount; ++i)
+			{
+				if (shelves[i].height >= alignedHeight && desc.width - shelves[i].x >= alignedWidth &&
+					(best == textureAtlas.shelfCount || shelves[i].height < shelves[best].height))
 				{
-					return false;
+					best = i;
 				}
-				case CGRendererType::OpenGL:
+			}
+
+			if (best == textureAtlas.shelfCount)
+			{
+				if (textureAtlas.top + alignedHeight > desc.height)
 				{
-					if (!OpenGL::DeviceOps::CreateVertexArray(vBuffer, vLayout))
+					if (textureAtlas.layer + 1u >= desc.layers)
 					{
+						printf("Texture atlas %u is full\n", atlas);
 						return false;
 					}
 
-					bufferPool.vertexLayouts[bufferPool.vlCount] = vLayout;
-					bufferPool.vlCount++;
-
-					break;
+					textureAtlas.layer++;
+					textureAtlas.top = 0u;
 				}
-				case CGRendererType::Vulkan:
+
+				CGAtlasShelf* shelf = static_cast<CGAtlasShelf*>(ArenaOps::Allocate(sizeof(CGAtlasShelf), textureAtlas.shelves));
+				if (!shelf)
 				{
 					return false;
 				}
+
+				*shelf = CGAtlasShelf{};
+				shelf->y = textureAtlas.top;
+				shelf->height = alignedHeight;
+				shelf->layer = textureAtlas.layer;
+
+				textureAtlas.top += alignedHeight;
+				textureAtlas.shelfCount++;
+
+				// Growing the arena may have moved the shelves
+				shelves = ArenaOps::GetData<CGAtlasShelf>(textureAtlas.shelves);
 			}
 
+			CGAtlasShelf& shelf = shelves[best];
+
+			region = CGAtlasRegion{};
+			region.uvOffset[0] = static_cast<float>(shelf.x) / static_cast<float>(desc.width);
+			region.uvOffset[1] = static_cast<float>(shelf.y) / static_cast<float>(desc.height);
+			region.uvScale[0] = static_cast<float>(width) / static_cast<float>(desc.width);
+			region.uvScale[1] = static_cast<float>(height) / static_cast<float>(desc.height);
+			region.texture = textureAtlas.texture;
+			region.x = shelf.x;
+			region.y = shelf.y;
+			region.width = width;
+			region.height = height;
+			region.layer = shelf.layer;
+
+			shelf.x += alignedWidth;
+
 			return true;
 		}
 
-		bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGRenderer& renderer, CGBuffer& vBuffer, const void* vbData)
+		static uint8_t GetMipCount(const uint32_t width, const uint32_t height)
 		{
-			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+			uint32_t size = width > height ? width : height;
+			uint8_t count = 1u;
 
-			if (bufferPool.vbCount + 1u > CG_MAX_VERTEX_BUFFERS)
+			while (size > 1u)
+			{
+				size >>= 1u;
+				++count;
+			}
+
+			return count;
+		}
+
+		bool UploadAtlasRegion(const CGAtlasRegion& region, const uint8_t mipCount, std::unique_ptr<uint8_t[]> mips, CGRenderer& renderer)
+		{
+			CGTexturePool& texturePool = renderer.resourcePool.texturePool;
+
+			if (region.texture >= texturePool.tCount.load(std::memory_order_acquire) || !mips || texturePool.uploadCount + 1u > CG_MAX_TEXTURE_UPLOADS)
 			{
 				return false;
 			}
 
-			vBuffer.desc = vbDesc;
+			const CGTexture& texture = texturePool.textures[region.texture];
 
-			switch (renderer.type)
+			// Levels past the end of a full chain repeat its 1x1 level, shorter chains would leave holes
+			if (texture.state.load(std::memory_order_acquire) != CGTextureState::Resident || texture.desc.layers == 0u || region.layer >= texture.desc.layers ||
+				region.width < 1u || region.height < 1u || region.x + region.width > texture.desc.width ||
+				region.y + region.height > texture.desc.height || mipCount != GetMipCount(region.width, region.height))
+			{
+				return false;
+			}
+
+			CGTextureUpload& upload = texturePool.uploads[texturePool.uploadCount];
+			upload.mips = std::move(mips);
+			upload.desc = CGTextureDesc{};
+			upload.desc.width = region.width;
+			upload.desc.height = region.height;
+			upload.desc.mipCount = mipCount;
+			upload.texture = region.texture;
+			upload.x = region.x;
+			upload.y = region.y;
+			upload.layer = region.layer;
+
+			texturePool.uploadCount++;
+
+			return true;
+		}
+	}
+
+	namespace ContextOps
+	{
+		bool CreateViewport(const core::CGWindow& window, CGRenderer& renderer)
+		{
+			CGRenderContext& context = renderer.context;
+
+			switch (GetRendererType(renderer))
 			{
 				case CGRendererType::None:
 				{
@@ -300,15 +2594,20 @@ namespace cg::renderer
 				}
 				case CGRendererType::Direct3D11:
 				{
-					if (!D3D11::DeviceOps::CreateVertexBuffer(renderer.device, vbDesc, vBuffer, vbData))
+#if defined(CG_HAS_D3D11)
+					CGViewport& viewport = context.api.d3d11.viewports[context.api.d3d11.viewportCount];
+
+					if (!D3D11::ContextOps::CreateViewport(window.width, window.height, viewport))
 					{
 						return false;
 					}
 
-					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
-					bufferPool.vbCount++;
+					context.api.d3d11.viewportCount++;
 
 					break;
+#else
+					return false;
+#endif
 				}
 				case CGRendererType::Direct3D12:
 				{
@@ -316,120 +2615,129 @@ namespace cg::renderer
 				}
 				case CGRendererType::OpenGL:
 				{
-					if (!OpenGL::DeviceOps::CreateVertexBuffer(vbDesc, vBuffer, vbData))
+					if (context.api.opengl.viewportCount + 1u > CG_MAX_VIEWPORTS)
 					{
 						return false;
 					}
 
-					bufferPool.vertexBuffers[bufferPool.vbCount] = vBuffer;
-					bufferPool.vbCount++;
+					CGViewport& viewport = context.api.opengl.viewports[context.api.opengl.viewportCount];
+
+					if (!OpenGL::ContextOps::CreateViewport(window.width, window.height, viewport))
+					{
+						return false;
+					}
+
+					context.api.opengl.viewportCount++;
 
 					break;
 				}
 				case CGRendererType::Vulkan:
 				{
-					return false;
-				}
-			}
-
-			return true;
-		}
+#if defined(CG_HAS_VULKAN)
+					if (context.api.vulkan.viewportCount + 1u > CG_MAX_VIEWPORTS)
+					{
+						return false;
+					}
 
-		bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGRenderer& renderer, CGBuffer& iBuffer, const void* ibData)
-		{
-			CGBufferPool& bufferPool = renderer.resourcePool.bufferPool;
+					CGViewport& viewport = context.api.vulkan.viewports[context.api.vulkan.viewportCount];
 
-			if (bufferPool.ibCount + 1u > CG_MAX_INDEX_BUFFERS)
-			{
-				return false;
-			}
+					if (!Vulkan::ContextOps::CreateViewport(window.width, window.height, viewport))
+					{
+						return false;
+					}
 
-			iBuffer.desc = ibDesc;
+					context.api.vulkan.viewportCount++;
 
-			switch (renderer.type)
-			{
-				case CGRendererType::None:
-				{
+					break;
+#else
 					return false;
+#endif
 				}
-				case CGRendererType::Direct3D11:
+				case CGRendererType::Null:
 				{
-					//if (!D3D11::DeviceOps::CreateIndexBuffer(renderer.device, ibDesc, iBuffer, ibData))
-					//{
-					//	return false;
-					//}
+					if (context.api.null.viewportCount + 1u > CG_MAX_VIEWPORTS)
+					{
+						return false;
+					}
 
-					//bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
-					//bufferPool.ibCount++;
+					CGViewport& viewport = context.api.null.viewports[context.api.null.viewportCount];
+
+					if (!Null::ContextOps::CreateViewport(window.width, window.height, viewport))
+					{
+						return false;
+					}
+
+					context.api.null.viewportCount++;
 
 					break;
 				}
-				case CGRendererType::Direct3D12:
-				{
-					return false;
-				}
-				case CGRendererType::OpenGL:
+				case CGRendererType::Software:
 				{
-					if (!OpenGL::DeviceOps::CreateIndexBuffer(ibDesc, iBuffer, ibData))
+					if (context.api.software.viewportCount + 1u > CG_MAX_VIEWPORTS)
 					{
 						return false;
 					}
 
-					bufferPool.indexBuffers[bufferPool.ibCount] = iBuffer;
-					bufferPool.ibCount++;
+					CGViewport& viewport = context.api.software.viewports[context.api.software.viewportCount];
+
+					if (!Software::ContextOps::CreateViewport(window.width, window.height, viewport))
+					{
+						return false;
+					}
+
+					context.api.software.viewportCount++;
 
 					break;
 				}
-				case CGRendererType::Vulkan:
-				{
-					return false;
-				}
 			}
 
 			return true;
 		}
-	}
 
-	namespace ContextOps
-	{
-		bool CreateViewport(const core::CGWindow& window, CGRenderer& renderer)
+		void MakeCurrent(const bool current, const CGRenderer& renderer)
 		{
-			CGRenderContext& context = renderer.context;
-
+#if defined(CG_RENDERER_STATIC)
+			MakeCurrent<CG_STATIC_RENDERER_TYPE>(current, renderer);
+#else
 			switch (renderer.type)
 			{
 				case CGRendererType::None:
 				{
-					return false;
+					MakeCurrent<CGRendererType::None>(current, renderer);
+					break;
 				}
 				case CGRendererType::Direct3D11:
 				{
-					CGViewport& viewport = context.api.d3d11.viewports[context.api.d3d11.viewportCount];
-
-					if (!D3D11::ContextOps::CreateViewport(window.width, window.height, viewport))
-					{
-						return false;
-					}
-
-					context.api.d3d11.viewportCount++;
-
+					MakeCurrent<CGRendererType::Direct3D11>(current, renderer);
 					break;
 				}
 				case CGRendererType::Direct3D12:
 				{
-					return false;
+					MakeCurrent<CGRendererType::Direct3D12>(current, renderer);
+					break;
 				}
 				case CGRendererType::OpenGL:
 				{
+					MakeCurrent<CGRendererType::OpenGL>(current, renderer);
 					break;
 				}
 				case CGRendererType::Vulkan:
 				{
-					return false;
+					MakeCurrent<CGRendererType::Vulkan>(current, renderer);
+					break;
+				}
+				case CGRendererType::Null:
+				{
+					MakeCurrent<CGRendererType::Null>(current, renderer);
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					MakeCurrent<CGRendererType::Software>(current, renderer);
+					break;
 				}
 			}
-
-			return true;
+#endif
 		}
 
 		CGRenderCommand SetViewClear(const uint8_t view, const uint8_t viewport, const CGClearFlags flags, const uint32_t color)
@@ -445,12 +2753,12 @@ namespace cg::renderer
 			return cmd;
 		}
 
-		CGRenderCommand SetPipelineState(const uint32_t program)
+		CGRenderCommand SetPipelineState(const uint32_t pipeline)
 		{
 			CGRenderCommand cmd = {};
 
 			cmd.type = CGRenderCommandType::SetPipelineState;
-			cmd.params.setPipelineState.program = program;
+			cmd.params.setPipelineState.pipeline = pipeline;
 
 			return cmd;
 		}
@@ -465,6 +2773,22 @@ namespace cg::renderer
 			return cmd;
 		}
 
+		CGRenderCommand SetVertexBuffer(const uint32_t vertexBuffer, const uint32_t offset)
+		{
+			CGRenderCommand cmd = SetVertexBuffer(vertexBuffer);
+			cmd.params.setVertexBuffer.offset = offset;
+
+			return cmd;
+		}
+
+		CGRenderCommand SetVertexBuffer(const CGTransientAllocation& vertices, const uint32_t vertexLayout)
+		{
+			CGRenderCommand cmd = SetVertexBuffer(vertices.buffer, vertices.offset);
+			cmd.params.setVertexBuffer.layout = vertexLayout;
+
+			return cmd;
+		}
+
 		CGRenderCommand SetIndexBuffer(const uint32_t indexBuffer)
 		{
 			CGRenderCommand cmd = {};
@@ -475,6 +2799,59 @@ namespace cg::renderer
 			return cmd;
 		}
 
+		CGRenderCommand SetIndexBuffer(const uint32_t indexBuffer, const uint32_t offset)
+		{
+			CGRenderCommand cmd = SetIndexBuffer(indexBuffer);
+			cmd.params.setIndexBuffer.offset = offset;
+
+			return cmd;
+		}
+
+		CGRenderCommand SetIndexBuffer(const CGTransientAllocation& indices)
+		{
+			return SetIndexBuffer(indices.buffer, indices.offset);
+		}
+
+		CGRenderCommand SetConstantBuffer(const uint8_t slot, const uint32_t constantBuffer, const uint32_t offset, const uint32_t size)
+		{
+			CGRenderCommand cmd = {};
+
+			cmd.type = CGRenderCommandType::SetConstantBuffer;
+			cmd.params.setConstantBuffer.buffer = constantBuffer;
+			cmd.params.setConstantBuffer.offset = offset;
+			cmd.params.setConstantBuffer.size = size;
+			cmd.params.setConstantBuffer.slot = slot;
+
+			return cmd;
+		}
+
+		CGRenderCommand SetConstantBuffer(const uint8_t slot, const CGTransientAllocation& constants, const uint32_t size)
+		{
+			return SetConstantBuffer(slot, constants.buffer, constants.offset, size);
+		}
+
+		CGRenderCommand SetTexture(const uint8_t slot, const uint32_t texture)
+		{
+			CGRenderCommand cmd = {};
+
+			cmd.type = CGRenderCommandType::SetTexture;
+			cmd.params.setTexture.texture = texture;
+			cmd.params.setTexture.slot = slot;
+
+			return cmd;
+		}
+
+		CGRenderCommand SetSampler(const uint8_t slot, const uint32_t sampler)
+		{
+			CGRenderCommand cmd = {};
+
+			cmd.type = CGRenderCommandType::SetSampler;
+			cmd.params.setSampler.sampler = sampler;
+			cmd.params.setSampler.slot = slot;
+
+			return cmd;
+		}
+
 		CGRenderCommand SetVertexShader(const uint8_t shader)
 		{
 			CGRenderCommand cmd = {};
@@ -519,64 +2896,405 @@ namespace cg::renderer
 
 			return cmd;
 		}
+
+		CGRenderCommand DrawIndexed(const uint32_t count, const uint32_t start, const int32_t baseVertex)
+		{
+			CGRenderCommand cmd = {};
+
+			cmd.type = CGRenderCommandType::DrawIndexed;
+			cmd.params.drawIndexed.count = count;
+			cmd.params.drawIndexed.start = start;
+			cmd.params.drawIndexed.baseVertex = baseVertex;
+
+			return cmd;
+		}
+
+		CGRenderCommand DrawGeometry(const CGGeometryAllocation& allocation)
+		{
+			if (allocation.indices.count > 0u)
+			{
+				return DrawIndexed(allocation.indices.count, allocation.indices.offset, static_cast<int32_t>(allocation.vertices.offset));
+			}
+
+			// The heap's vertex buffer is bound like any other, Draw only takes the range
+			return Draw(0u, allocation.vertices.count, allocation.vertices.offset);
+		}
+
+		CGRenderCommand ExecuteBundle(const uint32_t bundle)
+		{
+			CGRenderCommand cmd = {};
+
+			cmd.type = CGRenderCommandType::ExecuteBundle;
+			cmd.params.executeBundle.bundle = bundle;
+
+			return cmd;
+		}
 	}
 
 	namespace FrameOps
 	{
-		void EndFrame(const CGRenderer& renderer)
+		bool PushFrame(const uint8_t frame, CGFrameQueue& queue)
+		{
+			const uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+
+			if (tail - queue.head.load(std::memory_order_acquire) >= CG_MAX_FRAME_POOLS)
+			{
+				return false;
+			}
+
+			queue.frames[tail % CG_MAX_FRAME_POOLS] = frame;
+			queue.tail.store(tail + 1u, std::memory_order_release);
+
+			return true;
+		}
+
+		bool PopFrame(CGFrameQueue& queue, uint8_t& frame)
+		{
+			const uint32_t head = queue.head.load(std::memory_order_relaxed);
+
+			if (head == queue.tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+
+			frame = queue.frames[head % CG_MAX_FRAME_POOLS];
+			queue.head.store(head + 1u, std::memory_order_release);
+
+			return true;
+		}
+
+		bool WaitForFrame(const uint8_t pool, CGRenderer& renderer, const uint64_t timeout)
+		{
+			if (pool >= CG_MAX_FRAME_POOLS)
+			{
+				return false;
+			}
+
+			switch (GetRendererType(renderer))
+			{
+				case CGRendererType::None:
+				case CGRendererType::Direct3D11:
+				case CGRendererType::Direct3D12:
+				case CGRendererType::Vulkan:
+				case CGRendererType::Null:
+				case CGRendererType::Software:
+				{
+					// Nothing in the pool is read after the frame executed, or the backend syncs its own frames
+					return true;
+				}
+				case CGRendererType::OpenGL:
+				{
+					return OpenGL::FrameOps::WaitForFrame(renderer.context, pool, timeout);
+				}
+			}
+
+			return true;
+		}
+
+		void EndFrame(CGRenderer& renderer)
 		{
+#if defined(CG_RENDERER_STATIC)
+			EndFrame<CG_STATIC_RENDERER_TYPE>(renderer);
+#else
 			switch (renderer.type)
 			{
 				case CGRendererType::None:
 				{
+					EndFrame<CGRendererType::None>(renderer);
 					break;
 				}
 				case CGRendererType::Direct3D11:
 				{
+					EndFrame<CGRendererType::Direct3D11>(renderer);
 					break;
 				}
 				case CGRendererType::Direct3D12:
 				{
+					EndFrame<CGRendererType::Direct3D12>(renderer);
 					break;
 				}
 				case CGRendererType::OpenGL:
 				{
-					OpenGL::FrameOps::EndFrame(renderer.resourcePool);
+					EndFrame<CGRendererType::OpenGL>(renderer);
 					break;
 				}
 				case CGRendererType::Vulkan:
 				{
+					EndFrame<CGRendererType::Vulkan>(renderer);
+					break;
+				}
+				case CGRendererType::Null:
+				{
+					EndFrame<CGRendererType::Null>(renderer);
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					EndFrame<CGRendererType::Software>(renderer);
 					break;
 				}
 			}
+#endif
 		}
 
 		void Present(const CGRenderer& renderer)
 		{
+#if defined(CG_RENDERER_STATIC)
+			Present<CG_STATIC_RENDERER_TYPE>(renderer);
+#else
 			switch (renderer.type)
 			{
 				case CGRendererType::None:
 				{
+					Present<CGRendererType::None>(renderer);
 					break;
 				}
 				case CGRendererType::Direct3D11:
 				{
-					D3D11::FrameOps::Present(renderer.context.api.d3d11.swapchain);
+					Present<CGRendererType::Direct3D11>(renderer);
 					break;
 				}
 				case CGRendererType::Direct3D12:
 				{
+					Present<CGRendererType::Direct3D12>(renderer);
 					break;
 				}
 				case CGRendererType::OpenGL:
 				{
-					OpenGL::FrameOps::Present(renderer.context.api.opengl.window);
+					Present<CGRendererType::OpenGL>(renderer);
 					break;
 				}
 				case CGRendererType::Vulkan:
+				{
+					Present<CGRendererType::Vulkan>(renderer);
+					break;
+				}
+				case CGRendererType::Null:
+				{
+					Present<CGRendererType::Null>(renderer);
+					break;
+				}
+				case CGRendererType::Software:
+				{
+					Present<CGRendererType::Software>(renderer);
+					break;
+				}
+			}
+#endif
+		}
+
+		void ReloadShaderPrograms(const uint64_t changedFiles, CGRenderer& renderer)
+		{
+			CGReloadPool& reloadPool = renderer.resourcePool.reloadPool;
+
+			if (GetRendererType(renderer) != CGRendererType::OpenGL)
+			{
+				return;
+			}
+
+			for (uint32_t i = 0u; i < reloadPool.count; ++i)
+			{
+				CGReloadProgram& reload = reloadPool.programs[i];
+
+				reload.stale |= (reload.files & changedFiles) != 0ull;
+
+				if (reload.pending.status == CGProgramStatus::Pending)
+				{
+					switch (OpenGL::DeviceOps::PollShaderProgram(renderer.context, reload.pending))
+					{
+						case CGProgramStatus::Pending:
+						{
+							continue;
+						}
+						case CGProgramStatus::Ready:
+						{
+							OpenGL::DeviceOps::ReplaceShaderProgram(renderer.context, renderer.resourcePool.shaderPool, reload.program, reload.pending.program);
+							printf("Reloaded shader program %u\n", reload.program);
+							break;
+						}
+						default:
+						{
+							printf("Shader program %u failed to reload, it keeps its previous version\n", reload.program);
+							break;
+						}
+					}
+
+					reload.pending = CGPendingProgram{};
+				}
+
+				// Changes made while a recompile was in flight start another one once it is done
+				if (!reload.stale || reload.pending.status != CGProgramStatus::None)
+				{
+					continue;
+				}
+
+				reload.stale = false;
+
+				if (!OpenGL::DeviceOps::SubmitShaderProgram(renderer.context, renderer.resourcePool.shaderPool, reload.shaderCount, reload.descs, reload.pending))
+				{
+					printf("Shader program %u failed to reload, it keeps its previous version\n", reload.program);
+					reload.pending = CGPendingProgram{};
+				}
+			}
+		}
+
+		static uint32_t GetMipSize(const CGTextureDesc& desc, const uint8_t level)
+		{
+			const uint32_t width = desc.width >> level ? desc.width >> level : 1u;
+			const uint32_t height = desc.height >> level ? desc.height >> level : 1u;
+
+			return width * height * 4u;
+		}
+
+		static uint32_t GetMipOffset(const CGTextureDesc& desc, const uint8_t level)
+		{
+			uint32_t offset = 0u;
+
+			for (uint8_t i = 0u; i < level; ++i)
+			{
+				offset += GetMipSize(desc, i);
+			}
+
+			return offset;
+		}
+
+		void StreamTextures(CGRenderer& renderer)
+		{
+			CGTexturePool& texturePool = renderer.resourcePool.texturePool;
+
+			uint32_t uploaded = 0u;
+			uint32_t regions = 0u;
+
+			// Packed regions are sampled right away, so each one goes up whole with every level of its atlas
+			for (; regions < texturePool.uploadCount; ++regions)
+			{
+				CGTextureUpload& upload = texturePool.uploads[regions];
+				const CGTexture& texture = texturePool.textures[upload.texture];
+
+				uint32_t size = 0u;
+				for (uint8_t level = 0u; level < texture.desc.mipCount; ++level)
+				{
+					size += GetMipSize(upload.desc, level);
+				}
+
+				if (uploaded > 0u && uploaded + size > texturePool.uploadBudget)
 				{
 					break;
 				}
+
+				for (uint8_t level = 0u; level < texture.desc.mipCount; ++level)
+				{
+					const uint8_t mip = level < upload.desc.mipCount ? level : static_cast<uint8_t>(upload.desc.mipCount - 1u);
+					const uint8_t* data = upload.mips.get() + GetMipOffset(upload.desc, mip);
+
+					switch (GetRendererType(renderer))
+					{
+						case CGRendererType::Direct3D11:
+						{
+#if defined(CG_HAS_D3D11)
+							D3D11::ContextOps::UploadTextureRegion(renderer.context, upload, level, data, texture);
+#endif
+							break;
+						}
+						case CGRendererType::OpenGL:
+						{
+							OpenGL::DeviceOps::UploadTextureRegion(upload, level, data, texture);
+							break;
+						}
+						case CGRendererType::Null:
+						{
+							renderer.context.api.null.stats.bytesUploaded += GetMipSize(upload.desc, level);
+							break;
+						}
+						default:
+						{
+							break;
+						}
+					}
+				}
+
+				upload.mips.reset();
+				uploaded += size;
+			}
+
+			for (uint32_t i = regions; i < texturePool.uploadCount; ++i)
+			{
+				texturePool.uploads[i - regions] = std::move(texturePool.uploads[i]);
+			}
+
+			texturePool.uploadCount -= regions;
+
+			bool progress = true;
+
+			// One level per texture and pass, every streaming texture gets its coarse levels before any gets its fine ones
+			while (progress && uploaded < texturePool.uploadBudget && texturePool.streamingCount > 0u)
+			{
+				progress = false;
+
+				for (uint32_t i = 0u; i < texturePool.streamingCount; ++i)
+				{
+					CGTexture& texture = texturePool.textures[texturePool.streaming[i]];
+
+					const uint8_t level = static_cast<uint8_t>(texture.residentMip - 1u);
+					const uint32_t size = GetMipSize(texture.desc, level);
+
+					// A level larger than the whole budget still goes up, on its own
+					if (uploaded > 0u && uploaded + size > texturePool.uploadBudget)
+					{
+						continue;
+					}
+
+					const uint8_t* data = texture.mips.get() + GetMipOffset(texture.desc, level);
+
+					switch (GetRendererType(renderer))
+					{
+						case CGRendererType::Direct3D11:
+						{
+#if defined(CG_HAS_D3D11)
+							D3D11::ContextOps::UploadTextureMip(renderer.context, level, data, texture);
+#endif
+							break;
+						}
+						case CGRendererType::OpenGL:
+						{
+							OpenGL::DeviceOps::UploadTextureMip(level, data, texture);
+							break;
+						}
+						case CGRendererType::Null:
+						{
+							renderer.context.api.null.stats.bytesUploaded += size;
+							break;
+						}
+						default:
+						{
+							break;
+						}
+					}
+
+					texture.residentMip = level;
+					uploaded += size;
+					progress = true;
+				}
+
+				uint32_t streaming = 0u;
+
+				// Resident textures leave the list in order and drop their CPU copy
+				for (uint32_t i = 0u; i < texturePool.streamingCount; ++i)
+				{
+					CGTexture& texture = texturePool.textures[texturePool.streaming[i]];
+
+					if (texture.residentMip > 0u)
+					{
+						texturePool.streaming[streaming] = texturePool.streaming[i];
+						streaming++;
+						continue;
+					}
+
+					texture.mips.reset();
+					texture.state.store(CGTextureState::Resident, std::memory_order_release);
+				}
+
+				texturePool.streamingCount = streaming;
 			}
 		}
 	}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <new>
 
 namespace cg::core 
 { 
@@ -16,6 +19,8 @@ namespace cg
 		Direct3D12 = 2u,
 		OpenGL = 3u,
 		Vulkan = 4u,
+		Null = 5u,	   // Headless, accepts everything and only records statistics
+		Software = 6u, // Headless, rasterizes on the CPU into an in-memory framebuffer
 	};
 }
 
@@ -29,14 +34,58 @@ namespace cg::renderer
 	constexpr uint8_t CG_MAX_RENDER_TARGET_VIEWS = 8u;
 	constexpr uint8_t CG_MAX_VIEWPORTS = 8u;
 	constexpr uint8_t CG_MAX_VERTEX_ELEMENTS = 8u;
-	constexpr uint8_t CG_MAX_VERTEX_LAYOUTS = 32u;
+	constexpr uint8_t CG_MAX_VERTEX_LAYOUTS = 128u; // One per vertex buffer, OpenGL shares vertex arrays between equal layouts
 	constexpr uint8_t CG_MAX_VERTEX_BUFFERS = 128u;
 	constexpr uint8_t CG_MAX_INDEX_BUFFERS = 128u;
+	constexpr uint8_t CG_MAX_CONSTANT_BUFFERS = 32u;
+	constexpr uint8_t CG_MAX_CONSTANT_SLOTS = 8u; // Binding points, shared by all shader stages
+	constexpr uint8_t CG_MAX_GEOMETRY_HEAPS = 8u;
+	constexpr uint8_t CG_PULL_VERTEX_BINDING = 0u; // Storage buffer binding of the vertex data in vertex pulling mode
+	constexpr uint8_t CG_PULL_LAYOUT_BINDING = 1u; // Storage buffer binding of the vertex layout descriptor
 	constexpr uint8_t CG_MAX_VERTEX_ARRAYS = 128u;
 	constexpr uint8_t CG_MAX_VERTEX_SHADERS = 32u;
 	constexpr uint8_t CG_MAX_FRAGMENT_SHADERS = 32u;
 	constexpr uint8_t CG_MAX_SHADER_PROGRAMS = 32u;
-	constexpr uint8_t CG_MAX_RENDER_COMMANDS = 128u;
+	constexpr uint8_t CG_MAX_PROGRAM_SHADERS = 5u;	 // Vertex, tessellation control and evaluation, geometry, fragment
+	constexpr uint8_t CG_MAX_PENDING_PROGRAMS = 32u; // Programs compiling at the same time
+	constexpr uint8_t CG_MAX_SHADER_DEFINES = 32u;	 // One bit each in CGShaderDesc::variant
+	constexpr uint8_t CG_MAX_SHADER_INCLUDES = 16u;	 // Files a shader may include, each one only once
+	constexpr uint32_t CG_MAX_SHADER_VARIANTS = 128u;
+	constexpr uint32_t CG_MAX_SHADER_PATH = 256u;	 // Including the terminator
+	constexpr uint8_t CG_MAX_COMMAND_BUFFERS = 16u; // One per recording thread
+	constexpr uint8_t CG_MAX_RENDER_BUNDLES = 32u;
+	constexpr uint8_t CG_MAX_PIPELINE_STATES = 64u; // Distinct descs, equal ones share a pipeline
+	constexpr uint8_t CG_MAX_TEXTURES = 128u;
+	constexpr uint8_t CG_MAX_SAMPLERS = 16u;		// Distinct descs, equal ones share a sampler
+	constexpr uint8_t CG_MAX_TEXTURE_SLOTS = 8u;	// Binding points of the fragment stage
+	constexpr uint8_t CG_MAX_TEXTURE_MIPS = 15u;	// Up to 16384 texels on a side
+	constexpr uint16_t CG_MAX_TEXTURE_LAYERS = 256u; // Guaranteed by every backend
+	constexpr uint8_t CG_MAX_TEXTURE_ATLASES = 16u;
+	constexpr uint8_t CG_MAX_TEXTURE_UPLOADS = 128u; // Atlas regions waiting for their texels
+	constexpr uint32_t CG_TEXTURE_UPLOAD_BUDGET = 1024u * 1024u; // Texel bytes streamed per frame
+	constexpr uint32_t CG_COMMAND_ALIGNMENT = 4u;	 // Every packed command starts on this boundary
+	constexpr size_t CG_MIN_ARENA_SIZE = 4096ull;	 // First allocation of a growable arena
+	constexpr uint32_t CG_CACHE_LINE_SIZE = 64u;
+	constexpr uint8_t CG_MAX_FRAMES_IN_FLIGHT = 3u;
+	constexpr uint8_t CG_MAX_FRAME_POOLS = CG_MAX_FRAMES_IN_FLIGHT + 1u; // In-flight frames + the frame being recorded
+	constexpr uint8_t CG_MAX_RENDER_COMMAND_TYPES = 32u;
+	constexpr uint8_t CG_MAX_SOFTWARE_VARYINGS = 8u;
+	constexpr uint8_t CG_MAX_SOFTWARE_WORKERS = 16u;
+	constexpr uint32_t CG_SOFTWARE_TILE_SIZE = 64u; // Pixels per side of a binning tile
+	constexpr uint8_t CG_MAX_UPLOAD_STRATEGIES = 5u;
+	constexpr uint32_t CG_UPLOAD_STAGING_SIZE = 4u * 1024u * 1024u; // Staging bytes per frame pool
+	constexpr uint64_t CG_UPLOAD_STALL_NS = 50000ull;				 // Uploads blocking longer than this count as stalls
+	constexpr uint32_t CG_NO_UPLOAD = ~0u;
+	constexpr uint32_t CG_TRANSIENT_SIZE = 4u * 1024u * 1024u; // Transient bytes per frame pool
+	constexpr uint32_t CG_TRANSIENT_BUFFER = ~0u;			   // Buffer index that refers to the frame's transient memory
+
+	// 64-bit sort key layout (MSB -> LSB): view | pass | pipeline | vertex layout | depth
+	constexpr uint8_t CG_SORT_KEY_VIEW_SHIFT = 56u;
+	constexpr uint8_t CG_SORT_KEY_PASS_SHIFT = 48u;
+	constexpr uint8_t CG_SORT_KEY_PIPELINE_SHIFT = 32u;
+	constexpr uint8_t CG_SORT_KEY_LAYOUT_SHIFT = 24u;
+	constexpr uint8_t CG_SORT_KEY_DEPTH_SHIFT = 0u;
+	constexpr uint32_t CG_SORT_KEY_DEPTH_MASK = 0x00FFFFFFu;
 
 #pragma endregion
 
@@ -80,6 +129,16 @@ namespace cg::renderer
 		Dynamic = 2u
 	};
 
+	// How CPU data reaches a buffer after creation, fixed per buffer at creation
+	enum class CGUploadStrategy : uint8_t
+	{
+		Default = 0u,		// PersistentMap for dynamic buffers, Staging otherwise
+		SubData = 1u,		// The driver copies the data, it may wait if the range is still in use
+		Orphan = 2u,		// The store is re-specified first, the driver hands out new memory instead of waiting. Updates cover it all.
+		PersistentMap = 3u, // Written in place into the frame's segment of a persistently mapped ring
+		Staging = 4u		// Copied into mapped staging memory, then from there by the GPU
+	};
+
 	enum class CGShaderType : uint8_t
 	{
 		None = 0u,
@@ -103,6 +162,10 @@ namespace cg::renderer
 		SetIndexBuffer = 6u,
 		Draw = 7u,
 		DrawIndexed = 8u,
+		ExecuteBundle = 9u,
+		SetConstantBuffer = 10u,
+		SetTexture = 11u,
+		SetSampler = 12u,
 	};
 
 	enum CGColor : uint32_t
@@ -123,6 +186,88 @@ namespace cg::renderer
 		CG_CLEAR_STENCIL = 1 << 2
 	};
 
+	enum class CGPrimitiveTopology : uint8_t
+	{
+		TriangleList = 0u,
+		TriangleStrip = 1u,
+		LineList = 2u,
+		LineStrip = 3u,
+		PointList = 4u
+	};
+
+	enum class CGBlendMode : uint8_t
+	{
+		Opaque = 0u,
+		Alpha = 1u,		   // src * a + dst * (1 - a)
+		Additive = 2u,	   // src * a + dst
+		Premultiplied = 3u // src + dst * (1 - a)
+	};
+
+	enum class CGCompareFunc : uint8_t
+	{
+		Never = 0u,
+		Less = 1u,
+		Equal = 2u,
+		LessEqual = 3u,
+		Greater = 4u,
+		NotEqual = 5u,
+		GreaterEqual = 6u,
+		Always = 7u
+	};
+
+	enum class CGCullMode : uint8_t
+	{
+		None = 0u,
+		Front = 1u,
+		Back = 2u
+	};
+
+	enum class CGFillMode : uint8_t
+	{
+		Solid = 0u,
+		Wireframe = 1u
+	};
+
+	// Sub-states of a pipeline, executors only apply the ones that differ from the bound pipeline
+	enum CGPipelineChanges : uint8_t
+	{
+		CG_PIPELINE_SHADERS = 1 << 0,
+		CG_PIPELINE_LAYOUT = 1 << 1,
+		CG_PIPELINE_TOPOLOGY = 1 << 2,
+		CG_PIPELINE_BLEND = 1 << 3,
+		CG_PIPELINE_DEPTH = 1 << 4,
+		CG_PIPELINE_RASTER = 1 << 5,
+		CG_PIPELINE_ALL = 0x3F
+	};
+
+	enum class CGTextureFormat : uint8_t
+	{
+		None = 0u,
+		RGBA8 = 1u
+	};
+
+	enum class CGTextureFilter : uint8_t
+	{
+		Nearest = 0u,
+		Linear = 1u
+	};
+
+	enum class CGTextureAddress : uint8_t
+	{
+		Repeat = 0u,
+		Clamp = 1u,
+		Mirror = 2u
+	};
+
+	enum class CGTextureState : uint8_t
+	{
+		None = 0u,
+		Loading = 1u,	// Reserved, binds as no texture until its storage is created
+		Streaming = 2u, // Sampled from the levels that are resident so far
+		Resident = 3u,
+		Failed = 4u
+	};
+
 #pragma endregion
 
 	/* ----Data Structures---- */
@@ -151,11 +296,70 @@ namespace cg::renderer
 		bool windowed = false;
 	};
 
+	// Buffer range bound to a constant slot
+	struct CGConstantBinding
+	{
+		uint32_t buffer = 0u;
+		uint32_t offset = 0u;
+		uint32_t size = 0u;
+	};
+
+	// Shadow copy of the bound pipeline state, used to filter out redundant API calls
+	struct CGStateCache
+	{
+		CGViewport viewport = {};
+		CGConstantBinding constants[CG_MAX_CONSTANT_SLOTS] = {};
+		uint32_t program = 0u;
+		uint32_t pipeline = 0u; // Pipeline index + 1, 0 until the first SetPipelineState
+		CGConstantBinding pulledVertices = {}; // Storage range of a SetVertexBuffer in vertex pulling mode
+		uint32_t pulledLayout = 0u;			  // Layout index + 1 of the bound descriptor
+		uint32_t vertexArray = 0u;
+		uint32_t vertexBuffer = 0u; // Buffer binding of the bound vertex array
+		uint32_t vertexOffset = 0u;
+		uint32_t vertexStride = 0u;
+		uint32_t indexBuffer = 0u;
+		uint32_t clearColor = 0u;
+		uint32_t textures[CG_MAX_TEXTURE_SLOTS] = {}; // API texture, texture index + 1 for the null backend
+		uint32_t samplers[CG_MAX_TEXTURE_SLOTS] = {}; // API sampler, sampler index + 1 for the null backend
+		uint32_t skippedCalls = 0u; // Number of API calls filtered out by the cache
+		CGPrimitiveTopology topology = CGPrimitiveTopology::TriangleList; // Of the bound pipeline, draws pass it to the API
+	};
+
+	// Work the null backend would have handed to a GPU
+	struct CGRenderStats
+	{
+		uint64_t commands[CG_MAX_RENDER_COMMAND_TYPES] = {}; // Executed commands, indexed by CGRenderCommandType
+		uint64_t bytesUploaded = 0ull;
+		uint64_t stateChanges = 0ull;	 // Binds that would have reached the API
+		uint64_t redundantStates = 0ull; // Binds a state cache would have filtered out
+		uint64_t drawCalls = 0ull;
+		uint64_t vertices = 0ull;
+		uint32_t frames = 0u;
+		uint32_t buffers = 0u;
+		uint32_t shaders = 0u;
+		uint32_t programs = 0u;
+		uint32_t vertexLayouts = 0u;
+		uint32_t pipelines = 0u;
+		uint32_t textures = 0u;
+		uint32_t samplers = 0u;
+	};
+
+	// Per upload strategy, counted when the upload reaches the backend
+	struct CGUploadStats
+	{
+		uint64_t uploads = 0ull;
+		uint64_t bytes = 0ull;
+		uint64_t stalls = 0ull;	   // Uploads that blocked for longer than CG_UPLOAD_STALL_NS
+		uint64_t stallTime = 0ull; // Nanoseconds spent in those uploads
+	};
+
 	struct CGPhysicalDeviceInfo
 	{
 		const char* adapterName = nullptr;
 		uint64_t dedicatedVideoMemory = 0ull;
 		uint32_t vendorId = 0u;
+		uint32_t constantAlignment = 16u; // Offset alignment of constant buffer binds
+		uint32_t storageAlignment = 16u;  // Offset alignment of storage buffer binds, vertex buffer offsets in vertex pulling mode
 		bool isDiscrete = false;
 	};
 
@@ -175,6 +379,10 @@ namespace cg::renderer
 				//void* dxgiDebug;	   // IDXGIDebug*
 				//void* dxgiInfoQueue; // IDXGIInfoQueue*
 			} d3d11;
+			struct
+			{
+				void* device; // Instance, physical and logical device, queue and pipeline cache, owned by the backend
+			} vulkan;
 		} api = {};
 
 		CGPhysicalDeviceInfo deviceInfo = {};
@@ -198,8 +406,44 @@ namespace cg::renderer
 			} d3d11;
 			struct 
 			{
+				CGViewport viewports[CG_MAX_VIEWPORTS];
+				CGStateCache stateCache;
 				void* window;
+				void* fences[CG_MAX_FRAME_POOLS]; // GLsync - Signaled once the GPU is done with a frame pool
+				void* staging;			  // Persistent mapping of the staging ring, CG_UPLOAD_STAGING_SIZE per frame pool
+				void* transient;		  // Persistent mapping of the transient ring, CG_TRANSIENT_SIZE per frame pool
+				uint32_t stagingBuffer;
+				const char* programCache; // Directory of cached program binaries, nullptr disables the cache
+				uint64_t driverHash;	  // Adapter and driver version, cached binaries of other drivers never match
+				uint32_t transientBuffer;
+				uint32_t pullingArray;	  // Empty vertex array bound for the whole frame in vertex pulling mode, 0 otherwise
+				uint32_t layoutBuffer;	  // Vertex pulling descriptors, one per vertex layout
+				uint32_t indexOffset;	  // Bytes into the bound index buffer
+				uint32_t framebuffer;	  // Offscreen FBO of a headless context, 0 renders to the window
+				uint32_t renderbuffers[2]; // Offscreen color, depth-stencil
+				bool parallelCompile;	  // GL_KHR_parallel_shader_compile, completion can be polled
+				uint8_t frame;			  // Frame pool being executed
+				uint8_t viewportCount;
 			} opengl;
+			struct
+			{
+				CGViewport viewports[CG_MAX_VIEWPORTS];
+				CGStateCache stateCache; // Simulated bindings, vertex and index buffers are stored as index + 1
+				CGRenderStats stats;
+				uint8_t viewportCount;
+			} null;
+			struct
+			{
+				CGViewport viewports[CG_MAX_VIEWPORTS];
+				void* rasterizer; // Framebuffer, bins and worker pool, owned by the backend
+				uint8_t viewportCount;
+			} software;
+			struct
+			{
+				CGViewport viewports[CG_MAX_VIEWPORTS];
+				void* context; // Render targets, frames in flight, programs and pipelines, owned by the backend
+				uint8_t viewportCount;
+			} vulkan;
 		} api = {};
 
 		const CGRenderDevice* device = nullptr;
@@ -230,11 +474,23 @@ namespace cg::renderer
 			} opengl;
 		} api = {};
 
-		uint32_t padding[2] = {};
+		uint64_t hash = 0ull; // Of the elements, equal layouts share one vertex array in OpenGL
 		uint32_t count = 0u;
 		uint32_t size = 0u;
 	};
 
+	// Vertex shader output of the software backend: clip-space position followed by the varyings
+	struct CGSoftwareVertex
+	{
+		float position[4] = {};
+		float varyings[CG_MAX_SOFTWARE_VARYINGS] = {};
+	};
+
+	// Software shaders are plain functions. Vertex shaders read one vertex through its layout, fragment
+	// shaders turn the perspective-correct interpolated varyings into an RGBA color in [0, 1].
+	using CGSoftwareVertexShader = void(*)(const uint8_t* vertex, const CGVertexLayout& layout, CGSoftwareVertex& out);
+	using CGSoftwareFragmentShader = void(*)(const float varyings[], float color[4]);
+
 	struct alignas(16) CGBufferDesc
 	{
 		uint32_t count = 0u;
@@ -242,6 +498,7 @@ namespace cg::renderer
 		uint32_t size = 0u;
 		CGBufferType type = CGBufferType::None;
 		CGBufferUsage usage = CGBufferUsage::None;
+		CGUploadStrategy upload = CGUploadStrategy::Default;
 	};
 
 	struct alignas(16) CGBuffer
@@ -256,7 +513,19 @@ namespace cg::renderer
 			struct 
 			{
 				uint32_t buffer;
+				uint32_t segmentSize; // Bytes per frame pool segment of a dynamic buffer
+				void* mapped;		  // Persistent coherent mapping of a dynamic buffer, segment 0
 			} opengl;
+			struct
+			{
+				void* data; // CPU copy of the contents
+				uint32_t padding[2];
+			} software;
+			struct
+			{
+				uint64_t buffer; // VkBuffer
+				uint64_t memory; // VkDeviceMemory
+			} vulkan;
 		} api = {};
 
 		CGBufferDesc desc = {};
@@ -266,6 +535,9 @@ namespace cg::renderer
 	{
 		const char* filename = nullptr;
 		const char* entryPoint = nullptr;
+		const char* const* defines = nullptr; // Names of the variant defines, bit i of variant defines defines[i] as 1
+		uint32_t variant = 0u;
+		uint8_t defineCount = 0u;
 		CGShaderType shaderType = CGShaderType::None;
 	};
 
@@ -281,7 +553,19 @@ namespace cg::renderer
 			struct 
 			{
 				uint32_t shader;
+				uint32_t variantSlot; // Index + 1 in the variant cache, which owns the shader, 0 if it is deleted after linking
+				uint64_t sourceHash; // Of everything handed to the compiler, keys the program binary cache
 			} opengl;
+			struct
+			{
+				CGSoftwareVertexShader vertex;
+				CGSoftwareFragmentShader fragment;
+				uint8_t varyingCount; // Floats written by the vertex shader
+			} software;
+			struct
+			{
+				uint64_t module; // VkShaderModule
+			} vulkan;
 		} api = {};
 
 		CGShaderType type = CGShaderType::None;
@@ -300,7 +584,7 @@ namespace cg::renderer
 			} setViewClear;
 			struct
 			{
-				uint32_t program;
+				uint32_t pipeline;
 			} setPipelineState;
 			struct 
 			{
@@ -309,10 +593,13 @@ namespace cg::renderer
 			struct 
 			{
 				uint32_t buffer;
+				uint32_t offset;
+				uint32_t layout;
 			} setVertexBuffer;
 			struct 
 			{
 				uint32_t buffer;
+				uint32_t offset;
 			} setIndexBuffer;
 			struct 
 			{
@@ -323,7 +610,30 @@ namespace cg::renderer
 			struct 
 			{
 				uint32_t count;
+				uint32_t start;
+				int32_t baseVertex;
 			} drawIndexed;
+			struct
+			{
+				uint32_t bundle;
+			} executeBundle;
+			struct
+			{
+				uint32_t buffer;
+				uint32_t offset;
+				uint32_t size;
+				uint8_t slot;
+			} setConstantBuffer;
+			struct
+			{
+				uint32_t texture;
+				uint8_t slot;
+			} setTexture;
+			struct
+			{
+				uint32_t sampler;
+				uint8_t slot;
+			} setSampler;
 		} params = {};
 
 		CGRenderCommandType type = CGRenderCommandType::None;
@@ -334,10 +644,24 @@ namespace cg::renderer
 		CGVertexLayout vertexLayouts[CG_MAX_VERTEX_LAYOUTS] = {};
 		CGBuffer vertexBuffers[CG_MAX_VERTEX_BUFFERS] = {};
 		CGBuffer indexBuffers[CG_MAX_INDEX_BUFFERS] = {};
+		CGBuffer constantBuffers[CG_MAX_CONSTANT_BUFFERS] = {};
 
 		uint32_t vlCount = 0u; // Vertex layout count
 		uint32_t vbCount = 0u; // Vertex buffer count
 		uint32_t ibCount = 0u; // Index buffer count
+		uint32_t cbCount = 0u; // Constant buffer count
+	};
+
+	// A preprocessed shader variant, every variant with the same file, defines and source shares one compiled shader
+	struct CGShaderVariant
+	{
+		char filename[CG_MAX_SHADER_PATH] = {};
+		uint64_t hash = 0ull; // Expanded source and shader type
+		uint32_t variant = 0u; // Define bits
+		uint32_t shader = 0u;
+		CGShaderType type = CGShaderType::None;
+		bool compiled = false; // Only set once it compiled successfully
+		bool retained = false; // Held by a shader from CreateShader, otherwise the next change to its file replaces it
 	};
 
 	struct CGShaderPool
@@ -345,24 +669,495 @@ namespace cg::renderer
 		CGShader vertexShaders[CG_MAX_VERTEX_SHADERS] = {};
 		CGShader fragmentShaders[CG_MAX_FRAGMENT_SHADERS] = {};
 		uint32_t programs[CG_MAX_SHADER_PROGRAMS] = {};
+		uint32_t reloaded[CG_MAX_SHADER_PROGRAMS] = {}; // Stands in for programs[i] after a hot reload, 0 if never reloaded
+		CGShaderVariant variants[CG_MAX_SHADER_VARIANTS] = {}; // OpenGL
 
 		uint16_t padding = 0u;
 		uint8_t vsCount = 0u; // Vertex shader count
 		uint8_t fsCount = 0u; // Fragment shader count
 		uint32_t pCount = 0u; // Program count
+		uint32_t rCount = 0u; // Reloaded program count, programs are only looked up while there are any
+		uint32_t svCount = 0u; // Shader variant count
+	};
+
+	enum class CGProgramStatus : uint8_t
+	{
+		None = 0u, // Free slot
+		Pending = 1u,
+		Ready = 2u,
+		Failed = 3u,
+	};
+
+	// Program whose compile and link were submitted without waiting for them
+	struct CGPendingProgram
+	{
+		CGShader shaders[CG_MAX_PROGRAM_SHADERS] = {};
+		uint64_t key = 0ull; // Program binary cache key, OpenGL
+		uint32_t program = 0u;
+		uint8_t shaderCount = 0u;
+		CGProgramStatus status = CGProgramStatus::None;
+	};
+
+	struct CGPendingProgramPool
+	{
+		CGPendingProgram programs[CG_MAX_PENDING_PROGRAMS] = {};
+	};
+
+	// Program recompiled whenever one of its watched shader files changes
+	struct CGReloadProgram
+	{
+		CGShaderDesc descs[CG_MAX_PROGRAM_SHADERS] = {};
+		CGPendingProgram pending = {}; // Recompile in flight
+		uint64_t files = 0ull;		   // Watched file bits of its shaders
+		uint32_t program = 0u;		   // Handle of the program, commands keep using it across reloads
+		uint8_t shaderCount = 0u;
+		bool stale = false; // Changed again while recompiling
+	};
+
+	struct CGReloadPool
+	{
+		CGReloadProgram programs[CG_MAX_SHADER_PROGRAMS] = {};
+		uint32_t count = 0u;
+	};
+
+	struct CGBlendState
+	{
+		CGBlendMode mode = CGBlendMode::Opaque;
+		uint8_t writeMask = 0xFu; // RGBA, one bit per channel starting at red
+	};
+
+	struct CGDepthState
+	{
+		CGCompareFunc func = CGCompareFunc::Less;
+		bool test = false;
+		bool write = false;
+	};
+
+	struct CGRasterState
+	{
+		CGCullMode cull = CGCullMode::None;
+		CGFillMode fill = CGFillMode::Solid;
+		bool frontClockwise = false;
+	};
+
+	// Everything a draw needs besides its buffers and constants. Hashed byte by byte, so it has no
+	// implicit padding and the explicit one stays zero.
+	struct CGPipelineDesc
+	{
+		uint32_t program = 0u;		 // OpenGL, Vulkan, Null and Software
+		uint32_t vertexLayout = 0u;	 // Layout index, Vulkan bakes it into the pipeline
+		uint8_t vertexShader = 0u;	 // Direct3D 11, shader pool indices
+		uint8_t fragmentShader = 0u; // Direct3D 11
+		CGPrimitiveTopology topology = CGPrimitiveTopology::TriangleList;
+		CGBlendState blend = {};
+		CGDepthState depth = {};
+		CGRasterState raster = {};
+		uint8_t padding = 0u;
+	};
+
+	static_assert(sizeof(CGPipelineDesc) == 20u, "CGPipelineDesc must not have implicit padding");
+
+	// Immutable once created
+	struct CGPipelineState
+	{
+		union
+		{
+			struct
+			{
+				void* blend;  // ID3D11BlendState*
+				void* depth;  // ID3D11DepthStencilState*
+				void* raster; // ID3D11RasterizerState*
+			} d3d11;
+			struct
+			{
+				uint64_t pipeline; // VkPipeline
+			} vulkan;
+		} api = {};
+
+		CGPipelineDesc desc = {};
+		uint64_t hash = 0ull;
+	};
+
+	struct CGPipelinePool
+	{
+		CGPipelineState pipelines[CG_MAX_PIPELINE_STATES] = {};
+		uint32_t count = 0u;
+	};
+
+	struct CGTextureDesc
+	{
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		uint8_t mipCount = 1u;
+		CGTextureFormat format = CGTextureFormat::RGBA8;
+		uint16_t layers = 0u; // 0 for a plain 2D texture, the layer count of an array texture otherwise
+	};
+
+	// Storage is immutable and created for every level up front. Levels are streamed in coarsest first and
+	// sampling is clamped to the resident ones, so a texture shows up blurry right away and sharpens over frames.
+	struct CGTexture
+	{
+		union
+		{
+			struct
+			{
+				void* texture; // ID3D11Texture2D*
+				void* view;	   // ID3D11ShaderResourceView*
+			} d3d11;
+			struct
+			{
+				uint32_t texture;
+			} opengl;
+		} api = {};
+
+		CGTextureDesc desc = {};
+		std::unique_ptr<uint8_t[]> mips = nullptr; // Tightly packed levels, level 0 first, freed once all are resident
+		uint8_t residentMip = 0u; // Finest uploaded level, mipCount while none is
+		std::atomic<CGTextureState> state = CGTextureState::None; // Also written from the engine's thread
+	};
+
+	struct CGSamplerDesc
+	{
+		CGTextureFilter filter = CGTextureFilter::Linear;
+		CGTextureFilter mipFilter = CGTextureFilter::Linear;
+		CGTextureAddress address = CGTextureAddress::Repeat;
+		uint8_t maxAnisotropy = 1u; // 1 disables anisotropic filtering
+	};
+
+	struct CGSampler
+	{
+		union
+		{
+			struct
+			{
+				void* sampler; // ID3D11SamplerState*
+			} d3d11;
+			struct
+			{
+				uint32_t sampler;
+			} opengl;
+		} api = {};
+
+		CGSamplerDesc desc = {};
+	};
+
+	// Rectangle of one layer written at every level of the texture. Its mips are tightly packed, level 0
+	// first, desc holds their size and count.
+	struct CGTextureUpload
+	{
+		std::unique_ptr<uint8_t[]> mips = nullptr;
+		CGTextureDesc desc = {};
+		uint32_t texture = 0u;
+		uint32_t x = 0u;
+		uint32_t y = 0u;
+		uint16_t layer = 0u;
+	};
+
+	struct CGTexturePool
+	{
+		CGTexture textures[CG_MAX_TEXTURES] = {};
+		CGSampler samplers[CG_MAX_SAMPLERS] = {};
+		uint32_t streaming[CG_MAX_TEXTURES] = {}; // Textures with levels left to upload, oldest first
+		CGTextureUpload uploads[CG_MAX_TEXTURE_UPLOADS] = {}; // Oldest first
+		uint32_t uploadBudget = CG_TEXTURE_UPLOAD_BUDGET;
+
+		std::atomic<uint32_t> tCount = 0u; // Texture count, reserved from the engine's thread as well
+		uint32_t sCount = 0u; // Sampler count
+		uint32_t streamingCount = 0u;
+		uint32_t uploadCount = 0u;
+	};
+
+	// Packed command stream records. Each one is written behind a CGCommandHeader and only
+	// occupies its own size (rounded up to CG_COMMAND_ALIGNMENT), instead of a full CGRenderCommand.
+	struct CGCommandHeader
+	{
+		uint16_t type = 0u; // CGRenderCommandType
+		uint16_t size = 0u; // Header + payload, in bytes
+	};
+
+	struct CGSetViewClearCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetViewClear;
+
+		uint32_t color = 0u;
+		CGClearFlags clearFlags = CG_CLEAR_COLOR;
+		uint8_t view = 0u;
+		uint8_t viewport = 0u;
+	};
+
+	struct CGSetPipelineStateCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetPipelineState;
+
+		uint32_t pipeline = 0u; // Index in the pipeline pool
+	};
+
+	struct CGSetVertexShaderCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetVertexShader;
+
+		uint8_t shader = 0u;
+	};
+
+	struct CGSetFragmentShaderCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetFragmentShader;
+
+		uint8_t shader = 0u;
+	};
+
+	struct CGSetVertexBufferCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetVertexBuffer;
+
+		uint32_t buffer = 0u; // Vertex buffer and the layout created for it, or CG_TRANSIENT_BUFFER
+		uint32_t offset = 0u; // Bytes into the buffer
+		uint32_t layout = 0u; // Vertex layout of transient vertices, whose stride is taken from its buffer
+	};
+
+	struct CGSetIndexBufferCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetIndexBuffer;
+
+		uint32_t buffer = 0u; // Index buffer, or CG_TRANSIENT_BUFFER for 16-bit transient indices
+		uint32_t offset = 0u; // Bytes into the buffer
+	};
+
+	struct CGDrawCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::Draw;
+
+		uint32_t count = 0u;
+		uint32_t start = 0u;
+		uint8_t vertexBuffer = 0u;
+	};
+
+	struct CGDrawIndexedCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::DrawIndexed;
+
+		uint32_t count = 0u;
+		uint32_t start = 0u; // First index
+		int32_t baseVertex = 0; // Added to every index before the vertex is fetched
+	};
+
+	struct CGExecuteBundleCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::ExecuteBundle;
+
+		uint32_t bundle = 0u; // Index into the bundle pool
+	};
+
+	struct CGSetConstantBufferCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetConstantBuffer;
+
+		uint32_t buffer = 0u; // Constant buffer, or CG_TRANSIENT_BUFFER
+		uint32_t offset = 0u; // Bytes into the buffer, a multiple of CGPhysicalDeviceInfo::constantAlignment
+		uint32_t size = 0u;	  // Bytes visible to the shaders, 0 binds the rest of the buffer
+		uint8_t slot = 0u;
+	};
+
+	struct CGSetTextureCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetTexture;
+
+		uint32_t texture = 0u; // Index in the texture pool
+		uint8_t slot = 0u;
+	};
+
+	struct CGSetSamplerCommand
+	{
+		static constexpr CGRenderCommandType type = CGRenderCommandType::SetSampler;
+
+		uint32_t sampler = 0u; // Index in the sampler pool
+		uint8_t slot = 0u;
+	};
+
+	// Growable linear allocator. Memory is kept across resets, so a steady-state frame does not allocate.
+	struct CGLinearArena
+	{
+		std::unique_ptr<uint8_t[]> data = nullptr;
+		size_t size = 0ull;		// Bytes in use
+		size_t capacity = 0ull; // Bytes allocated
+	};
+
+	// A run of commands that is submitted (and sorted) as a single unit
+	struct CGRenderPacket
+	{
+		uint64_t sortKey = 0ull;
+		uint32_t offset = 0u; // Byte offset into the command stream
+		uint32_t size = 0u;	  // Byte size in the command stream
+	};
+
+	struct CGCommandStream
+	{
+		CGLinearArena commands = {}; // Packed, variable-length commands
+		CGLinearArena packets = {};	 // CGRenderPacket[packetCount]; the last packet is open for recording
+		uint32_t count = 0u;		 // Command count
+		uint32_t packetCount = 0u;	 // Packet count
+	};
+
+	// Slice of the frame's transient memory, bound with CG_TRANSIENT_BUFFER and offset
+	struct CGTransientAllocation
+	{
+		uint32_t buffer = CG_TRANSIENT_BUFFER;
+		uint32_t offset = 0u;
+		void* data = nullptr; // Write-only, valid until SubmitFrame
+	};
+
+	// Buffer update recorded with a frame, its data follows the record in the upload arena
+	struct CGBufferUpload
+	{
+		uint32_t buffer = 0u; // Index into the buffer pool
+		uint32_t offset = 0u; // Destination offset in bytes
+		uint32_t size = 0u;	  // Data size in bytes
+		uint32_t stride = 0u; // Bytes to the next record
+		CGBufferType type = CGBufferType::None;
+		CGUploadStrategy strategy = CGUploadStrategy::Default; // Resolved, never Default
+		bool committed = false; // Still mapped while false, skipped by the backend
 	};
 
 	struct CGCommandPool
 	{
-		CGRenderCommand commands[CG_MAX_RENDER_COMMANDS] = {};
-		uint8_t count = 0u;
+		CGCommandStream stream = {};
+		CGLinearArena order = {};	// uint32_t[packetCount], packet execution order sorted by key
+		CGLinearArena scratch = {}; // Radix sort ping-pong buffer
+		CGLinearArena uploads = {}; // CGBufferUpload records, applied before the frame's commands execute
+		uint32_t mappedUpload = CG_NO_UPLOAD; // Offset of the record of the buffer currently mapped
+		CGLinearArena transient = {};		  // Transient memory of backends without a GPU ring, never grows past CG_TRANSIENT_SIZE
+		uint32_t transientSize = 0u;		  // Transient bytes handed out this frame
+	};
+
+	// A command list that was validated and translated once into a flat array of backend operations
+	// (API object names, float colors, strides), so replaying it needs no decoding or pool lookups
+	struct CGRenderBundle
+	{
+		CGLinearArena ops = {}; // Backend-specific operations
+		uint32_t count = 0u;	// Operation count
+	};
+
+	struct CGBundlePool
+	{
+		CGRenderBundle bundles[CG_MAX_RENDER_BUNDLES] = {};
+		uint32_t count = 0u;
+	};
+
+	// Range of a geometry heap, in vertices or indices
+	struct CGHeapRange
+	{
+		uint32_t offset = 0u;
+		uint32_t count = 0u;
+	};
+
+	// Many meshes sharing one vertex buffer and one index buffer of the buffer pool. Meshes are drawn with
+	// their first vertex and index, so switching between meshes of a heap needs no rebinds.
+	struct CGGeometryHeap
+	{
+		CGLinearArena freeVertices = {}; // CGHeapRange[], free vertex ranges sorted by offset
+		CGLinearArena freeIndices = {}; // CGHeapRange[], free index ranges sorted by offset
+		uint32_t vertexBuffer = 0u; // Its vertex layout shares the index, like for every vertex buffer
+		uint32_t indexBuffer = 0u; // Only valid if indexCapacity is not 0
+		uint32_t vertexCapacity = 0u;
+		uint32_t indexCapacity = 0u;
+		uint32_t vertexStride = 0u;
+		uint32_t meshCount = 0u;
+	};
+
+	struct CGHeapPool
+	{
+		CGGeometryHeap heaps[CG_MAX_GEOMETRY_HEAPS] = {};
+		uint32_t count = 0u;
+	};
+
+	// Row of one atlas layer, as tall as the first image put on it and filled from left to right
+	struct CGAtlasShelf
+	{
+		uint32_t x = 0u; // First free column
+		uint32_t y = 0u;
+		uint32_t height = 0u;
+		uint16_t layer = 0u;
+	};
+
+	// Array texture many images are packed into, so draws of different images bind it once and keep batching.
+	// Layers fill up with shelves from the top, a new layer is started once the newest one has no room for another.
+	struct CGTextureAtlas
+	{
+		CGLinearArena shelves = {}; // CGAtlasShelf[shelfCount]
+		uint32_t texture = 0u;		// Array texture in the texture pool
+		uint32_t shelfCount = 0u;
+		uint32_t top = 0u;	 // First row of the newest layer no shelf covers
+		uint16_t layer = 0u; // Newest layer
+	};
+
+	struct CGAtlasPool
+	{
+		CGTextureAtlas atlases[CG_MAX_TEXTURE_ATLASES] = {};
+		uint32_t count = 0u;
+	};
+
+	// Place of an image in an atlas. Materials bind the atlas texture and pick the image with the layer and
+	// uv * uvScale + uvOffset, clamped half a texel inside the region when sampled with a linear filter.
+	struct CGAtlasRegion
+	{
+		float uvOffset[2] = {};
+		float uvScale[2] = {};
+		uint32_t texture = 0u;
+		uint32_t x = 0u;
+		uint32_t y = 0u;
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		uint16_t layer = 0u;
+	};
+
+	struct CGGeometryHeapDesc
+	{
+		uint32_t vertexCapacity = 0u; // In vertices
+		uint32_t vertexStride = 0u;
+		uint32_t indexCapacity = 0u; // In 16-bit indices, 0 for heaps of non-indexed meshes
+	};
+
+	// Mesh handle, the first vertex and index double as the draw parameters
+	struct CGGeometryAllocation
+	{
+		CGHeapRange vertices = {};
+		CGHeapRange indices = {};
+		uint32_t heap = 0u;
+	};
+
+	// Thread-local recording target. Each buffer is owned by exactly one thread while recording
+	// and is cache-line aligned so neighbouring buffers never share a line.
+	struct alignas(CG_CACHE_LINE_SIZE) CGCommandBuffer
+	{
+		CGCommandStream stream = {};
+		std::atomic<bool> published = false; // Set (release) by the owner once recording is done
 	};
 
 	struct CGResourcePool
 	{
 		CGBufferPool bufferPool = {};
 		CGShaderPool shaderPool = {};
-		CGCommandPool commandPool = {};
+		CGPendingProgramPool pendingPool = {};
+		CGReloadPool reloadPool = {};
+		CGPipelinePool pipelinePool = {};
+		CGTexturePool texturePool = {};
+		CGAtlasPool atlasPool = {};
+		CGBundlePool bundlePool = {};
+		CGHeapPool heapPool = {};
+		CGCommandPool commandPools[CG_MAX_FRAME_POOLS] = {};
+		CGCommandBuffer commandBuffers[CG_MAX_COMMAND_BUFFERS] = {};
+		CGUploadStats uploadStats[CG_MAX_UPLOAD_STRATEGIES] = {}; // Indexed by CGUploadStrategy
+		std::atomic<uint32_t> publishedCount = 0u; // Number of command buffers published this frame
+		uint8_t recordPool = 0u;				   // Command pool currently being recorded into
+	};
+
+	// Bounded single-producer/single-consumer ring of command pool indices, used to hand
+	// recorded frames between the main and render threads
+	struct CGFrameQueue
+	{
+		uint8_t frames[CG_MAX_FRAME_POOLS] = {};
+		alignas(CG_CACHE_LINE_SIZE) std::atomic<uint32_t> head = 0u; // Consumer position
+		alignas(CG_CACHE_LINE_SIZE) std::atomic<uint32_t> tail = 0u; // Producer position
 	};
 
 	struct CGRenderer
@@ -379,41 +1174,256 @@ namespace cg::renderer
 	/* ----Function Declarations---- */
 #pragma region Function Declarations
 
+	constexpr uint64_t MakeSortKey(const uint8_t view, const uint8_t pass, const uint32_t pipeline, const uint8_t vertexLayout, const uint32_t depth)
+	{
+		return (static_cast<uint64_t>(view) << CG_SORT_KEY_VIEW_SHIFT) |
+			   (static_cast<uint64_t>(pass) << CG_SORT_KEY_PASS_SHIFT) |
+			   (static_cast<uint64_t>(pipeline & 0xFFFFu) << CG_SORT_KEY_PIPELINE_SHIFT) |
+			   (static_cast<uint64_t>(vertexLayout) << CG_SORT_KEY_LAYOUT_SHIFT) |
+			   (static_cast<uint64_t>(depth & CG_SORT_KEY_DEPTH_MASK) << CG_SORT_KEY_DEPTH_SHIFT);
+	}
+
+	namespace ArenaOps
+	{
+		bool Reserve(const size_t capacity, CGLinearArena& arena);
+		void* Allocate(const size_t size, CGLinearArena& arena);
+		void Reset(CGLinearArena& arena);
+
+		template <typename T>
+		T* GetData(const CGLinearArena& arena)
+		{
+			return reinterpret_cast<T*>(arena.data.get());
+		}
+	}
+
+	constexpr uint32_t AlignUp(const uint32_t value, const uint32_t alignment)
+	{
+		return (value + alignment - 1u) & ~(alignment - 1u);
+	}
+
+	constexpr CGUploadStrategy GetUploadStrategy(const CGBufferDesc& desc)
+	{
+		if (desc.upload != CGUploadStrategy::Default)
+		{
+			return desc.upload;
+		}
+
+		return desc.usage == CGBufferUsage::Dynamic ? CGUploadStrategy::PersistentMap : CGUploadStrategy::Staging;
+	}
+
+	constexpr uint64_t CG_HASH_SEED = 14695981039346656037ull;
+
+	// FNV-1a, hashes of several pieces are chained through the seed
+	inline uint64_t HashBytes(const void* data, const size_t size, const uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+
+		for (size_t i = 0ull; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	inline const CGBuffer* GetBuffer(const CGBufferType type, const uint32_t buffer, const CGBufferPool& bufferPool)
+	{
+		switch (type)
+		{
+			case CGBufferType::None:
+			{
+				break;
+			}
+			case CGBufferType::Vertex:
+			{
+				return buffer < bufferPool.vbCount ? &bufferPool.vertexBuffers[buffer] : nullptr;
+			}
+			case CGBufferType::Index:
+			{
+				return buffer < bufferPool.ibCount ? &bufferPool.indexBuffers[buffer] : nullptr;
+			}
+			case CGBufferType::Constant:
+			{
+				return buffer < bufferPool.cbCount ? &bufferPool.constantBuffers[buffer] : nullptr;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// CGPipelineChanges of the sub-states that differ between two pipelines
+	uint8_t GetPipelineChanges(const CGPipelineDesc& current, const CGPipelineDesc& next);
+
+	// Starts a new packet at the end of the stream. Commands emplaced afterwards belong to it.
+	bool BeginRenderPacket(const uint64_t sortKey, CGCommandStream& stream);
+
+	// Writes a command directly into the stream and returns it for the caller to fill in, nullptr when the
+	// stream is out of memory. The pointer is only valid until the next command is emplaced into the same stream.
+	template <typename Cmd>
+	Cmd* Emplace(CGCommandStream& stream)
+	{
+		static_assert(alignof(Cmd) <= CG_COMMAND_ALIGNMENT, "Packed commands must not need more than CG_COMMAND_ALIGNMENT");
+
+		constexpr uint32_t size = AlignUp(static_cast<uint32_t>(sizeof(CGCommandHeader) + sizeof(Cmd)), CG_COMMAND_ALIGNMENT);
+
+		if (stream.packetCount == 0u && !BeginRenderPacket(0ull, stream))
+		{
+			return nullptr;
+		}
+
+		const uint32_t offset = static_cast<uint32_t>(stream.commands.size);
+		uint8_t* bytes = static_cast<uint8_t*>(ArenaOps::Allocate(size, stream.commands));
+
+		if (!bytes)
+		{
+			return nullptr;
+		}
+
+		CGCommandHeader* header = new (bytes) CGCommandHeader();
+		header->type = static_cast<uint16_t>(Cmd::type);
+		header->size = static_cast<uint16_t>(size);
+
+		CGRenderPacket& packet = ArenaOps::GetData<CGRenderPacket>(stream.packets)[stream.packetCount - 1u];
+		packet.size = offset + size - packet.offset;
+
+		stream.count++;
+
+		return new (bytes + sizeof(CGCommandHeader)) Cmd();
+	}
+
+	template <typename Cmd>
+	const Cmd& GetCommand(const CGCommandHeader& header)
+	{
+		return *reinterpret_cast<const Cmd*>(reinterpret_cast<const uint8_t*>(&header) + sizeof(CGCommandHeader));
+	}
+
+	CGCommandStream& GetCommandStream(CGRenderer& renderer);
 	bool AddRenderCommands(const uint8_t count, const CGRenderCommand commands[], CGRenderer& renderer);
-	void ExecuteRenderCommands(const CGRenderer& renderer);
+	bool AddRenderCommands(const uint64_t sortKey, const uint8_t count, const CGRenderCommand commands[], CGRenderer& renderer);
+	bool AddRenderCommands(const uint64_t sortKey, const uint8_t count, const CGRenderCommand commands[], CGCommandStream& stream);
+	void SortRenderCommands(CGRenderer& renderer);
+
+	// Multithreaded recording: each thread records into its own buffer, publishes it without locking
+	// and the submitting thread merges all published buffers into the command pool in buffer order.
+	CGCommandBuffer& GetCommandBuffer(const uint8_t thread, CGRenderer& renderer);
+	void PublishCommandBuffer(CGCommandBuffer& cmdBuffer, CGRenderer& renderer);
+	// False when a buffer did not fit, it stays published with its commands and a later merge retries it
+	bool MergeCommandBuffers(CGRenderer& renderer);
+	void ResetRenderCommands(const uint8_t pool, CGRenderer& renderer);
+	void ExecuteRenderCommands(CGRenderer& renderer);
+	void ExecuteRenderCommands(const uint8_t pool, CGRenderer& renderer);
 
 	namespace DeviceOps
 	{
 		bool CreateShader(const CGShaderDesc& desc, CGRenderer& renderer, CGShader& shader);
 		bool CreateShaderProgram(const uint8_t count, const CGShader shaders[], CGRenderer& renderer, uint32_t& program);
+		// Submits the compile of every shader and the link of the program without waiting for any of them.
+		// Poll the pending handle until it is no longer Pending, backends without async compiles finish right away.
+		bool CreateShaderProgramAsync(const uint8_t count, const CGShaderDesc descs[], CGRenderer& renderer, uint32_t& pending);
+		// Ready hands out the program, which is then in the shader pool like one of CreateShaderProgram.
+		// The pending handle is released once the status is Ready or Failed.
+		CGProgramStatus PollShaderProgram(const uint32_t pending, CGRenderer& renderer, uint32_t& program);
+		// Filenames and defines of descs have to outlive the renderer, files are the watched file bits of the shaders
+		bool WatchShaderProgram(const uint32_t program, const uint8_t count, const CGShaderDesc descs[], const uint64_t files, CGRenderer& renderer);
 		bool SetupVertexLayout(const uint8_t count, CGVertexElement elements[], CGRenderer& renderer, CGVertexLayout& vLayout);
 		bool CreateVertexLayout(const CGBuffer& vBuffer, CGRenderer& renderer, CGShader& vShader, CGVertexLayout& vLayout);
 		bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGRenderer& renderer, CGBuffer& vBuffer, const void* vbData);
 		bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGRenderer& renderer, CGBuffer& iBuffer, const void* ibData);
+		bool CreateConstantBuffer(const CGBufferDesc& cbDesc, CGRenderer& renderer, CGBuffer& cBuffer, const void* cbData);
+		// Write pointer into the segment of a CGUploadStrategy::PersistentMap buffer that belongs to the frame
+		// being recorded. Valid until SubmitFrame, the segment is not read by the GPU before then. Segments
+		// are streamed, data written in earlier frames does not carry over.
+		bool GetWritePointer(const CGBuffer& buffer, const CGRenderer& renderer, void*& data);
+		// Updates belong to the frame being recorded and are applied before its commands execute, so they
+		// are safe with a render thread. Call them from the submitting thread between BeginFrame and SubmitFrame.
+		// Buffers with the Orphan strategy only take updates of the whole buffer.
+		bool UpdateBuffer(const CGBufferType type, const uint32_t buffer, const uint32_t offset, const uint32_t size, const void* data, CGRenderer& renderer);
+		// The pointer stays valid until UnmapBuffer. Only one buffer can be mapped at a time and deferred
+		// updates fail until it is unmapped.
+		bool MapBuffer(const CGBufferType type, const uint32_t buffer, const uint32_t offset, const uint32_t size, CGRenderer& renderer, void*& data);
+		bool UnmapBuffer(const CGBufferType type, const uint32_t buffer, CGRenderer& renderer);
+		// Frame-lifetime memory for one-shot vertex, index and constant data, without a CGBuffer of its own.
+		// All of it is recycled at once when the frame pool is recorded again, after its fence has passed.
+		bool AllocateTransient(const uint32_t size, const uint32_t alignment, CGRenderer& renderer, CGTransientAllocation& allocation);
+		// Transient memory aligned for constant buffer binds, e.g. one block of per-draw transforms
+		bool AllocateConstants(const uint32_t size, CGRenderer& renderer, CGTransientAllocation& allocation);
+		bool CreateRenderBundle(const CGCommandStream& stream, CGRenderer& renderer, uint32_t& bundle);
+		// Equal descs hand out the same pipeline, so the sort key and the executors can compare pipelines by index
+		bool CreatePipelineState(const CGPipelineDesc& desc, CGRenderer& renderer, uint32_t& pipeline);
+		// Creates the heap's vertex and index buffers. Bind them once with SetVertexBuffer and SetIndexBuffer
+		// and draw every mesh of the heap with RenderOps::DrawGeometry.
+		bool CreateGeometryHeap(const CGGeometryHeapDesc& desc, CGRenderer& renderer, uint32_t& heap);
+		// Sub-allocates a mesh and uploads its data with the frame being recorded
+		bool AllocateGeometry(const uint32_t heap, const uint32_t vertexCount, const void* vertices, const uint32_t indexCount, const uint16_t* indices, CGRenderer& renderer, CGGeometryAllocation& allocation);
+		// The ranges can be handed out again right away, their next upload is ordered after the frames still using them.
+		// Allocations outside the heap or with ranges that are free already are rejected.
+		bool FreeGeometry(const CGGeometryAllocation& allocation, CGRenderer& renderer);
+		// Hands out a handle right away, so commands can reference a texture that is still being decoded.
+		// Safe to call while the thread that owns the context creates and binds textures.
+		bool ReserveTexture(CGRenderer& renderer, uint32_t& texture);
+		// Creates the immutable storage of a reserved texture and takes over its tightly packed mip chain,
+		// level 0 first. Has to run on the thread that owns the context, FrameOps::StreamTextures uploads it.
+		bool CreateTexture(const uint32_t texture, const CGTextureDesc& desc, std::unique_ptr<uint8_t[]> mips, CGRenderer& renderer);
+		// Equal descs hand out the same sampler
+		bool CreateSampler(const CGSamplerDesc& desc, CGRenderer& renderer, uint32_t& sampler);
+		// Array texture of desc.layers layers to pack images into. Regions are aligned to the coarsest level, so
+		// no level mixes neighbouring images. Few levels keep that alignment, and the space it wastes, small.
+		bool CreateTextureAtlas(const CGTextureDesc& desc, CGRenderer& renderer, uint32_t& atlas);
+		// Online best fit onto the shelves of the atlas. Images as large as a layer get a layer of their own.
+		bool AllocateAtlasRegion(const uint32_t atlas, const uint32_t width, const uint32_t height, CGRenderer& renderer, CGAtlasRegion& region);
+		// Takes over the region's mip chain, level 0 first and down to 1x1 like io::GenerateMips builds it.
+		// Has to run on the thread that owns the context, FrameOps::StreamTextures uploads it.
+		bool UploadAtlasRegion(const CGAtlasRegion& region, const uint8_t mipCount, std::unique_ptr<uint8_t[]> mips, CGRenderer& renderer);
 	}
 
 	namespace ContextOps
 	{
 		bool CreateViewport(const core::CGWindow& window, CGRenderer& renderer);
+		void MakeCurrent(const bool current, const CGRenderer& renderer);
 
 		CGRenderCommand SetViewClear(const uint8_t view, const uint8_t viewport, const CGClearFlags flags, const uint32_t color);
-		CGRenderCommand SetPipelineState(const uint32_t program);
+		CGRenderCommand SetPipelineState(const uint32_t pipeline);
 		CGRenderCommand SetVertexShader(const uint8_t vertexShader);
 		CGRenderCommand SetVertexBuffer(const uint32_t vertexBuffer);
+		CGRenderCommand SetVertexBuffer(const uint32_t vertexBuffer, const uint32_t offset);
+		CGRenderCommand SetVertexBuffer(const CGTransientAllocation& vertices, const uint32_t vertexLayout);
 		CGRenderCommand SetIndexBuffer(const uint32_t indexBuffer);
+		CGRenderCommand SetIndexBuffer(const uint32_t indexBuffer, const uint32_t offset);
+		CGRenderCommand SetIndexBuffer(const CGTransientAllocation& indices);
+		CGRenderCommand SetConstantBuffer(const uint8_t slot, const uint32_t constantBuffer, const uint32_t offset, const uint32_t size);
+		CGRenderCommand SetConstantBuffer(const uint8_t slot, const CGTransientAllocation& constants, const uint32_t size);
 		CGRenderCommand SetFragmentShader(const uint8_t fragmentShader);
+		CGRenderCommand SetTexture(const uint8_t slot, const uint32_t texture);
+		CGRenderCommand SetSampler(const uint8_t slot, const uint32_t sampler);
 	}
 
 	namespace RenderOps
 	{
 		CGRenderCommand Draw(const uint8_t vertexBuffer, const uint32_t count, const uint32_t start);
 		CGRenderCommand DrawIndexed(const uint32_t count);
+		CGRenderCommand DrawIndexed(const uint32_t count, const uint32_t start, const int32_t baseVertex);
+		CGRenderCommand DrawGeometry(const CGGeometryAllocation& allocation);
+		CGRenderCommand ExecuteBundle(const uint32_t bundle);
 	}
 
 	namespace FrameOps
 	{
-		void EndFrame(const CGRenderer& renderer);
+		bool PushFrame(const uint8_t frame, CGFrameQueue& queue);
+		bool PopFrame(CGFrameQueue& queue, uint8_t& frame);
+		// True once the GPU finished the last frame executed from the pool, waits up to timeout nanoseconds.
+		// Pools must not be recorded into again before, their dynamic buffer segments may still be read.
+		bool WaitForFrame(const uint8_t pool, CGRenderer& renderer, const uint64_t timeout);
+		void EndFrame(CGRenderer& renderer);
 		void Present(const CGRenderer& renderer);
+		// Recompiles watched programs of changed files and swaps in the ones that finished. Has to run on
+		// the thread that owns the context, between frames, and never waits on a compile that is in flight.
+		void ReloadShaderPrograms(const uint64_t changedFiles, CGRenderer& renderer);
+		// Uploads up to the texture pool's upload budget of texel bytes. Atlas regions go first and whole, then one
+		// level per texture and pass, coarsest level first. Has to run on the thread that owns the context, before
+		// the frame's commands execute.
+		void StreamTextures(CGRenderer& renderer);
 	}
 
 	namespace D3D11
@@ -432,6 +1442,13 @@ namespace cg::renderer
 			bool CreateVertexLayout(const CGRenderDevice& device, CGShader& vShader, CGVertexLayout& vLayout);
 			bool CreateVertexBuffer(const CGRenderDevice& device, const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData);
 			bool CreateIndexBuffer(const CGRenderDevice& device, const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData);
+			bool CreateConstantBuffer(const CGRenderDevice& device, const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData);
+			void DestroyBuffer(CGBuffer& buffer);
+			// Creates the blend, depth-stencil and rasterizer state objects of the desc
+			bool CreatePipelineState(const CGRenderDevice& device, const CGShaderPool& shaderPool, CGPipelineState& pipeline);
+			// Levels start out unsampled, the resource's minimum LOD follows the uploads
+			bool CreateTexture(const CGRenderDevice& device, CGTexture& texture);
+			bool CreateSampler(const CGRenderDevice& device, CGSampler& sampler);
 			bool CreateDebugInterface(CGRenderDevice& device);
 			void DestroyResources(CGResourcePool& resourcePool);
 		}
@@ -439,7 +1456,12 @@ namespace cg::renderer
 		namespace ContextOps
 		{
 			bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport);
-			void ExecuteRenderCommands(const CGRenderContext& context, const CGResourcePool& resourcePool);
+			void ExecuteRenderCommands(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool);
+			// Each SetPipelineState only applies the sub-states that differ from the previous one of the bundle
+			bool CompileBundle(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandStream& stream, CGRenderBundle& bundle);
+			void ExecuteBundle(const CGRenderContext& context, const CGRenderBundle& bundle);
+			void UploadTextureMip(const CGRenderContext& context, const uint8_t level, const void* data, CGTexture& texture);
+			void UploadTextureRegion(const CGRenderContext& context, const CGTextureUpload& upload, const uint8_t level, const void* data, const CGTexture& texture);
 			void DestroyContext(CGRenderContext& context);
 		}
 
@@ -461,27 +1483,285 @@ namespace cg::renderer
 
 	namespace OpenGL
 	{
-		bool Init(const bool debug, CGRenderFunctions& functions);
-		bool CreateDeviceAndContext(const bool debug, const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context);
+		// Headless contexts render into an offscreen framebuffer. With GLFW 3.4+ they are created
+		// surfaceless through EGL on the null platform, otherwise through a hidden window.
+		bool Init(const bool debug, const bool headless, CGRenderFunctions& functions);
+		// Vertex pulling replaces the vertex arrays with storage buffers that vertex shaders read through
+		// CGFetchAttribute(element), a function prepended to every vertex shader in that mode
+		// Program binaries are cached in programCache when it is not nullptr, the directory is created if needed
+		bool CreateDeviceAndContext(const bool debug, const bool headless, const bool vertexPulling, const char* programCache, const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context);
+
+		namespace DeviceOps
+		{
+			// Sources are preprocessed: #include "file" is resolved relative to the including file and the defines
+			// of the variant bits follow the #version line. Variants of one file, bits and expanded source compile once.
+			// With a program cache, shaders are only compiled once CreateShaderProgram misses the cache.
+			bool CreateShader(const CGRenderContext& context, CGShaderPool& shaderPool, const CGShaderDesc& desc, CGShader& shader);
+			bool CreateShaderProgram(const CGRenderContext& context, CGShaderPool& shaderPool, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program);
+			bool SubmitShaderProgram(const CGRenderContext& context, CGShaderPool& shaderPool, const uint8_t count, const CGShaderDesc descs[], CGPendingProgram& pending);
+			// Never blocks with GL_KHR_parallel_shader_compile, otherwise the first poll waits for the link
+			CGProgramStatus PollShaderProgram(const CGRenderContext& context, CGPendingProgram& pending);
+			// The handle keeps its program object, later replacements are deleted
+			void ReplaceShaderProgram(CGRenderContext& context, CGShaderPool& shaderPool, const uint32_t program, const uint32_t replacement);
+			bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData);
+			bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData);
+			bool CreateConstantBuffer(const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData);
+			void DestroyBuffer(CGBuffer& buffer);
+			// Writes the layout's descriptor instead in vertex pulling mode
+			bool CreateVertexArray(const CGRenderContext& context, const CGBufferPool& bufferPool, const CGBuffer& vBuffer, const uint32_t layout, CGVertexLayout& vLayout);
+			void* GetWritePointer(const CGBuffer& buffer, const uint8_t pool);
+			void UploadBuffers(CGRenderContext& context, const CGBufferPool& bufferPool, const uint8_t pool, const CGLinearArena& uploads, CGUploadStats stats[]);
+			void* GetTransientMemory(const CGRenderContext& context, const uint8_t pool);
+			// Immutable storage for every level, only the uploaded ones are sampled through GL_TEXTURE_BASE_LEVEL
+			bool CreateTexture(CGTexture& texture);
+			void UploadTextureMip(const uint8_t level, const void* data, CGTexture& texture);
+			void UploadTextureRegion(const CGTextureUpload& upload, const uint8_t level, const void* data, const CGTexture& texture);
+			bool CreateSampler(CGSampler& sampler);
+		}
+
+		namespace ContextOps
+		{
+			bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport);
+			void MakeCurrent(const CGRenderContext& context, const bool current);
+			// Reads back the offscreen framebuffer (or the back buffer) as RGBA8
+			bool ReadFramebuffer(const CGRenderContext& context, const int32_t width, const int32_t height, void* pixels);
+			void DestroyContext(CGRenderContext& context);
+			void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool);
+			bool CompileBundle(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandStream& stream, CGRenderBundle& bundle);
+			void ExecuteBundle(CGRenderContext& context, const CGResourcePool& resourcePool, const CGRenderBundle& bundle);
+		}
+
+		namespace FrameOps
+		{
+			bool WaitForFrame(CGRenderContext& context, const uint8_t pool, const uint64_t timeout);
+			void EndFrame(CGRenderContext& context);
+			void Present(const CGRenderContext& context);
+		}
+	}
+
+	namespace Null
+	{
+		bool Init(CGRenderFunctions& functions);
+		bool CreateDeviceAndContext(CGRenderDevice& device, CGRenderContext& context);
+
+		namespace DeviceOps
+		{
+			bool CreateShader(CGRenderContext& context, const CGShaderDesc& desc, CGShader& shader);
+			bool CreateShaderProgram(CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program);
+			bool CreateVertexBuffer(CGRenderContext& context, const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData);
+			bool CreateIndexBuffer(CGRenderContext& context, const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData);
+			void DestroyBuffer(CGRenderContext& context, CGBuffer& buffer);
+			bool CreateConstantBuffer(CGRenderContext& context, const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData);
+			bool CreateVertexLayout(CGRenderContext& context, CGVertexLayout& vLayout);
+			void UploadBuffers(CGRenderContext& context, const CGLinearArena& uploads, CGUploadStats stats[]);
+		}
+
+		namespace ContextOps
+		{
+			bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport);
+			void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool);
+			bool CompileBundle(const CGCommandStream& stream, CGRenderBundle& bundle);
+			void ExecuteBundle(CGRenderContext& context, const CGResourcePool& resourcePool, const CGRenderBundle& bundle);
+		}
+	}
+
+	namespace Software
+	{
+		bool Init(CGRenderFunctions& functions);
+		bool CreateDeviceAndContext(const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context);
 
 		namespace DeviceOps
 		{
+			// Shaders resolve to the built-in functions matching the asset name (debug_vs, debug_ps/debug_fs)
 			bool CreateShader(const CGShaderDesc& desc, CGShader& shader);
-			bool CreateShaderProgram(const uint8_t shaderCount, const CGShader shaders[], uint32_t& program);
+			bool CreateShaderProgram(CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program);
 			bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData);
 			bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData);
-			bool CreateVertexArray(const CGBuffer& vBuffer, CGVertexLayout& vLayout);
+			// Constant data is stored, the built-in software shaders do not read any
+			bool CreateConstantBuffer(const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData);
+			void DestroyBuffer(CGBuffer& buffer);
+			// Buffers are CPU copies, every strategy is a plain copy
+			void UploadBuffers(const CGBufferPool& bufferPool, const CGLinearArena& uploads, CGUploadStats stats[]);
+			void DestroyResources(CGResourcePool& resourcePool);
 		}
 
 		namespace ContextOps
 		{
-			void ExecuteRenderCommands(const CGRenderContext& context, const CGResourcePool& resourcePool);
+			bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport);
+			void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool);
+			bool CompileBundle(const CGCommandStream& stream, CGRenderBundle& bundle);
+			void ExecuteBundle(CGRenderContext& context, const CGResourcePool& resourcePool, const CGRenderBundle& bundle);
+			// RGBA8 pixels packed like CGColor (0xRRGGBBAA), row 0 is the top of the image
+			const uint32_t* GetFramebuffer(const CGRenderContext& context, uint32_t& width, uint32_t& height);
+			void DestroyContext(CGRenderContext& context);
+		}
+	}
+
+	namespace Vulkan
+	{
+		// Headless devices skip the surface and swapchain and only render into their offscreen targets
+		bool Init(const bool debug, const bool headless, CGRenderFunctions& functions);
+		bool CreateDeviceAndContext(const bool debug, const bool headless, const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context);
+		void DestroyDevice(CGRenderDevice& device);
+
+		namespace DeviceOps
+		{
+			// Loads SPIR-V, desc.filename points at the compiled .spv
+			bool CreateShader(const CGRenderDevice& device, const CGShaderDesc& desc, CGShader& shader);
+			bool CreateShaderProgram(CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program);
+			// Builds the VkPipeline up front, the vertex layout of the desc is baked into it
+			bool CreatePipelineState(CGRenderContext& context, const CGBufferPool& bufferPool, CGPipelineState& pipeline);
+			bool CreateVertexBuffer(const CGRenderDevice& device, const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData);
+			bool CreateIndexBuffer(const CGRenderDevice& device, const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData);
+			void DestroyBuffer(const CGRenderDevice& device, CGBuffer& buffer);
+			void DestroyResources(const CGRenderDevice& device, CGResourcePool& resourcePool);
+		}
+
+		namespace ContextOps
+		{
+			bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport);
+			void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool);
+			// Bundles are recorded once into secondary command buffers
+			bool CompileBundle(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandStream& stream, CGRenderBundle& bundle);
+			// Reads back the most recently submitted frame as RGBA8, waits for the GPU
+			bool ReadFramebuffer(const CGRenderContext& context, void* pixels);
+			void DestroyContext(CGRenderContext& context);
 		}
 
 		namespace FrameOps
 		{
-			void EndFrame(const CGResourcePool& resourcePool);
-			void Present(void* window);
+			void EndFrame(const CGRenderContext& context);
+			void Present(const CGRenderContext& context);
+		}
+	}
+
+#pragma endregion
+
+	/* ----Static Dispatch---- */
+#pragma region Static Dispatch
+
+	// Resolves to a constant when the backend is fixed at build time (CG_RENDERER_BACKEND), which lets the
+	// compiler fold every backend switch in the front-end down to the one live branch.
+#if defined(CG_RENDERER_STATIC)
+	constexpr CGRendererType CG_STATIC_RENDERER_TYPE = static_cast<CGRendererType>(CG_RENDERER_STATIC);
+#endif
+
+	// renderer_d3d11.cpp is only built on Windows
+#if defined(CG_HAS_D3D11)
+	constexpr bool CG_D3D11_AVAILABLE = true;
+#else
+	constexpr bool CG_D3D11_AVAILABLE = false;
+#endif
+
+	// renderer_vulkan.cpp is only built when CMake finds the Vulkan SDK
+#if defined(CG_HAS_VULKAN)
+	constexpr bool CG_VULKAN_AVAILABLE = true;
+#else
+	constexpr bool CG_VULKAN_AVAILABLE = false;
+#endif
+
+	inline CGRendererType GetRendererType(const CGRenderer& renderer)
+	{
+#if defined(CG_RENDERER_STATIC)
+		(void)renderer;
+		return CG_STATIC_RENDERER_TYPE;
+#else
+		return renderer.type;
+#endif
+	}
+
+	// Templated frame path. Each instantiation calls straight into its backend, so the frame loop
+	// carries no dispatch and the executor can be inlined into it under whole program optimization.
+	template <CGRendererType Type>
+	inline void ExecuteRenderCommands(const uint8_t pool, CGRenderer& renderer)
+	{
+		const CGCommandPool& cmdPool = renderer.resourcePool.commandPools[pool];
+
+		if constexpr (Type == CGRendererType::Direct3D11 && CG_D3D11_AVAILABLE)
+		{
+			D3D11::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool, cmdPool);
+		}
+		else if constexpr (Type == CGRendererType::OpenGL)
+		{
+			OpenGL::DeviceOps::UploadBuffers(renderer.context, renderer.resourcePool.bufferPool, pool, cmdPool.uploads, renderer.resourcePool.uploadStats);
+			OpenGL::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool, cmdPool);
+		}
+		else if constexpr (Type == CGRendererType::Null)
+		{
+			Null::DeviceOps::UploadBuffers(renderer.context, cmdPool.uploads, renderer.resourcePool.uploadStats);
+			Null::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool, cmdPool);
+		}
+		else if constexpr (Type == CGRendererType::Software)
+		{
+			Software::DeviceOps::UploadBuffers(renderer.resourcePool.bufferPool, cmdPool.uploads, renderer.resourcePool.uploadStats);
+			Software::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool, cmdPool);
+		}
+		else if constexpr (Type == CGRendererType::Vulkan && CG_VULKAN_AVAILABLE)
+		{
+			Vulkan::ContextOps::ExecuteRenderCommands(renderer.context, renderer.resourcePool, cmdPool);
+		}
+		else
+		{
+			(void)cmdPool;
+		}
+	}
+
+	namespace ContextOps
+	{
+		template <CGRendererType Type>
+		inline void MakeCurrent(const bool current, const CGRenderer& renderer)
+		{
+			// The D3D11 immediate context is not bound to a thread, it only needs a single user at a time
+			if constexpr (Type == CGRendererType::OpenGL)
+			{
+				OpenGL::ContextOps::MakeCurrent(renderer.context, current);
+			}
+			else
+			{
+				(void)current;
+				(void)renderer;
+			}
+		}
+	}
+
+	namespace FrameOps
+	{
+		template <CGRendererType Type>
+		inline void EndFrame(CGRenderer& renderer)
+		{
+			if constexpr (Type == CGRendererType::OpenGL)
+			{
+				OpenGL::FrameOps::EndFrame(renderer.context);
+			}
+			else if constexpr (Type == CGRendererType::Vulkan && CG_VULKAN_AVAILABLE)
+			{
+				Vulkan::FrameOps::EndFrame(renderer.context);
+			}
+			else
+			{
+				(void)renderer;
+			}
+		}
+
+		template <CGRendererType Type>
+		inline void Present(const CGRenderer& renderer)
+		{
+			if constexpr (Type == CGRendererType::Direct3D11 && CG_D3D11_AVAILABLE)
+			{
+				D3D11::FrameOps::Present(renderer.context.api.d3d11.swapchain);
+			}
+			else if constexpr (Type == CGRendererType::OpenGL)
+			{
+				OpenGL::FrameOps::Present(renderer.context);
+			}
+			else if constexpr (Type == CGRendererType::Vulkan && CG_VULKAN_AVAILABLE)
+			{
+				Vulkan::FrameOps::Present(renderer.context);
+			}
+			else
+			{
+				(void)renderer;
+			}
 		}
 	}
 
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include <cstdio>
+#include <new>
 #include <string>
 
 #include "renderer.h"
@@ -68,6 +69,9 @@ namespace cg::renderer::D3D11
 			return false;
 		}
 
+		// Pipelines set it from then on, draws before the first one still get triangles like in the other backends
+		GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
 		context.device = &device;
 
 		return true;
@@ -193,6 +197,7 @@ namespace cg::renderer::D3D11
 			device.deviceInfo.adapterName = adapterName;
 			device.deviceInfo.dedicatedVideoMemory = desc.DedicatedVideoMemory / 1024 / 1024;
 			device.deviceInfo.vendorId = desc.VendorId;
+			device.deviceInfo.constantAlignment = 256u; // 16 constants of 16 bytes, the unit of constant buffer ranges
 			device.api.d3d11.adapter = dxgiAdapter;
 
 			printf("Direct3D 11 Context Info:\n\n");
@@ -304,6 +309,28 @@ namespace cg::renderer::D3D11
 
 			UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
 
+			// Bits without a define are rejected like in the OpenGL backend, not compiled as another variant
+			const bool undefinedBits = desc.defineCount < CG_MAX_SHADER_DEFINES && (desc.variant >> desc.defineCount) != 0u;
+
+			if (desc.variant != 0u && (desc.defines == nullptr || desc.defineCount > CG_MAX_SHADER_DEFINES || undefinedBits))
+			{
+				printf("Variant %x of shader %s has no define for some of its bits\n", desc.variant, desc.filename);
+				return false;
+			}
+
+			// Defines of the variant bits, terminated by an empty macro
+			D3D_SHADER_MACRO macros[CG_MAX_SHADER_DEFINES + 1u] = {};
+			uint8_t macroCount = 0u;
+
+			for (uint8_t i = 0u; desc.defines && i < desc.defineCount; ++i)
+			{
+				if ((desc.variant & (1u << i)) != 0u)
+				{
+					macros[macroCount] = { desc.defines[i], "1" };
+					macroCount++;
+				}
+			}
+
 			if (context.device->debug)
 			{
 				flags |= D3DCOMPILE_DEBUG;
@@ -311,7 +338,7 @@ namespace cg::renderer::D3D11
 
 			HRESULT result = D3DCompileFromFile(
 				filename.c_str(),				   // .hlsl file
-				nullptr,						   // defines
+				macros,							   // defines
 				D3D_COMPILE_STANDARD_FILE_INCLUDE, // include header
 				desc.entryPoint,
 				target,							   // target
@@ -520,6 +547,206 @@ namespace cg::renderer::D3D11
 			return true;
 		}
 
+		bool CreateConstantBuffer(const CGRenderDevice& device, const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData)
+		{
+			D3D11_BUFFER_DESC desc = {};
+			desc.ByteWidth = AlignUp(cbDesc.size, 16u); // Constant buffers are sized in 16-byte constants
+			desc.Usage = D3D11_USAGE_DEFAULT;
+			desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			desc.CPUAccessFlags = 0U;
+			desc.MiscFlags = 0U;
+
+			D3D11_SUBRESOURCE_DATA data = {};
+			data.pSysMem = cbData;
+
+			const auto dev = GetD3D11COM<ID3D11Device*>(device.api.d3d11.device);
+			HRESULT result = dev->CreateBuffer(&desc, cbData ? &data : nullptr, GetD3D11COM<ID3D11Buffer**>(&cBuffer.api.d3d11.buffer));
+
+			if (FAILED(result))
+			{
+				return false;
+			}
+
+			return true;
+		}
+
+		void DestroyBuffer(CGBuffer& buffer)
+		{
+			if (buffer.api.d3d11.buffer)
+			{
+				GetD3D11COM<ID3D11Buffer*>(buffer.api.d3d11.buffer)->Release();
+			}
+
+			buffer.api.d3d11 = {};
+		}
+
+		static constexpr D3D11_COMPARISON_FUNC GetCompareFunc(const CGCompareFunc func)
+		{
+			switch (func)
+			{
+				case CGCompareFunc::Never:		  return D3D11_COMPARISON_NEVER;
+				case CGCompareFunc::Less:		  return D3D11_COMPARISON_LESS;
+				case CGCompareFunc::Equal:		  return D3D11_COMPARISON_EQUAL;
+				case CGCompareFunc::LessEqual:	  return D3D11_COMPARISON_LESS_EQUAL;
+				case CGCompareFunc::Greater:	  return D3D11_COMPARISON_GREATER;
+				case CGCompareFunc::NotEqual:	  return D3D11_COMPARISON_NOT_EQUAL;
+				case CGCompareFunc::GreaterEqual: return D3D11_COMPARISON_GREATER_EQUAL;
+				case CGCompareFunc::Always:		  return D3D11_COMPARISON_ALWAYS;
+			}
+
+			return D3D11_COMPARISON_LESS;
+		}
+
+		bool CreatePipelineState(const CGRenderDevice& device, const CGShaderPool& shaderPool, CGPipelineState& pipeline)
+		{
+			const CGPipelineDesc& desc = pipeline.desc;
+
+			if (desc.vertexShader >= shaderPool.vsCount || desc.fragmentShader >= shaderPool.fsCount)
+			{
+				return false;
+			}
+
+			D3D11_BLEND_DESC blendDesc = {};
+			D3D11_RENDER_TARGET_BLEND_DESC& target = blendDesc.RenderTarget[0];
+			target.BlendEnable = desc.blend.mode != CGBlendMode::Opaque;
+			target.SrcBlend = D3D11_BLEND_SRC_ALPHA;
+			target.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			target.BlendOp = D3D11_BLEND_OP_ADD;
+			target.SrcBlendAlpha = D3D11_BLEND_ONE;
+			target.DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+			target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+			target.RenderTargetWriteMask = desc.blend.writeMask; // Same bit order as D3D11_COLOR_WRITE_ENABLE
+
+			if (desc.blend.mode == CGBlendMode::Additive)
+			{
+				target.DestBlend = D3D11_BLEND_ONE;
+				target.DestBlendAlpha = D3D11_BLEND_ONE;
+			}
+			else if (desc.blend.mode == CGBlendMode::Premultiplied)
+			{
+				target.SrcBlend = D3D11_BLEND_ONE;
+			}
+
+			D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+			depthDesc.DepthEnable = desc.depth.test;
+			depthDesc.DepthWriteMask = desc.depth.write ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+			depthDesc.DepthFunc = GetCompareFunc(desc.depth.func);
+
+			D3D11_RASTERIZER_DESC rasterDesc = {};
+			rasterDesc.FillMode = desc.raster.fill == CGFillMode::Wireframe ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
+			rasterDesc.CullMode = desc.raster.cull == CGCullMode::Front ? D3D11_CULL_FRONT : desc.raster.cull == CGCullMode::Back ? D3D11_CULL_BACK : D3D11_CULL_NONE;
+			rasterDesc.FrontCounterClockwise = !desc.raster.frontClockwise;
+			rasterDesc.DepthClipEnable = TRUE;
+
+			const auto dev = GetD3D11COM<ID3D11Device*>(device.api.d3d11.device);
+
+			// The device hands out the same object for equal descs, pipelines only differing elsewhere share them
+			if (FAILED(dev->CreateBlendState(&blendDesc, GetD3D11COM<ID3D11BlendState**>(&pipeline.api.d3d11.blend))))
+			{
+				return false;
+			}
+
+			if (FAILED(dev->CreateDepthStencilState(&depthDesc, GetD3D11COM<ID3D11DepthStencilState**>(&pipeline.api.d3d11.depth))))
+			{
+				GetD3D11COM<ID3D11BlendState*>(pipeline.api.d3d11.blend)->Release();
+				pipeline.api.d3d11 = {};
+				return false;
+			}
+
+			if (FAILED(dev->CreateRasterizerState(&rasterDesc, GetD3D11COM<ID3D11RasterizerState**>(&pipeline.api.d3d11.raster))))
+			{
+				GetD3D11COM<ID3D11DepthStencilState*>(pipeline.api.d3d11.depth)->Release();
+				GetD3D11COM<ID3D11BlendState*>(pipeline.api.d3d11.blend)->Release();
+				pipeline.api.d3d11 = {};
+				return false;
+			}
+
+			return true;
+		}
+
+		bool CreateTexture(const CGRenderDevice& device, CGTexture& texture)
+		{
+			const CGTextureDesc& desc = texture.desc;
+
+			D3D11_TEXTURE2D_DESC textureDesc = {};
+			textureDesc.Width = desc.width;
+			textureDesc.Height = desc.height;
+			textureDesc.MipLevels = desc.mipCount;
+			textureDesc.ArraySize = desc.layers > 0u ? desc.layers : 1U;
+			textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			textureDesc.SampleDesc.Count = 1U;
+			textureDesc.Usage = D3D11_USAGE_DEFAULT;
+			textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+			const auto dev = GetD3D11COM<ID3D11Device*>(device.api.d3d11.device);
+
+			if (FAILED(dev->CreateTexture2D(&textureDesc, nullptr, GetD3D11COM<ID3D11Texture2D**>(&texture.api.d3d11.texture))))
+			{
+				return false;
+			}
+
+			// An array of a single layer still needs an array view to match Texture2DArray in the shaders
+			D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+			viewDesc.Format = textureDesc.Format;
+			viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			viewDesc.Texture2DArray.MipLevels = desc.mipCount;
+			viewDesc.Texture2DArray.ArraySize = textureDesc.ArraySize;
+
+			// The view covers every level, the minimum LOD of the resource keeps the missing ones from being sampled
+			if (FAILED(dev->CreateShaderResourceView(GetD3D11COM<ID3D11Texture2D*>(texture.api.d3d11.texture), desc.layers > 0u ? &viewDesc : nullptr, GetD3D11COM<ID3D11ShaderResourceView**>(&texture.api.d3d11.view))))
+			{
+				GetD3D11COM<ID3D11Texture2D*>(texture.api.d3d11.texture)->Release();
+				texture.api.d3d11 = {};
+				return false;
+			}
+
+			return true;
+		}
+
+		static constexpr D3D11_FILTER GetFilter(const CGSamplerDesc& desc)
+		{
+			if (desc.maxAnisotropy > 1u)
+			{
+				return D3D11_FILTER_ANISOTROPIC;
+			}
+
+			// Point is 0 and linear 1 in each of the mip, mag and min fields
+			return static_cast<D3D11_FILTER>(
+				(desc.filter == CGTextureFilter::Linear ? 0x14 : 0x0) |
+				(desc.mipFilter == CGTextureFilter::Linear ? 0x1 : 0x0)
+			);
+		}
+
+		static constexpr D3D11_TEXTURE_ADDRESS_MODE GetAddressMode(const CGTextureAddress address)
+		{
+			switch (address)
+			{
+				case CGTextureAddress::Repeat: return D3D11_TEXTURE_ADDRESS_WRAP;
+				case CGTextureAddress::Clamp:  return D3D11_TEXTURE_ADDRESS_CLAMP;
+				case CGTextureAddress::Mirror: return D3D11_TEXTURE_ADDRESS_MIRROR;
+			}
+
+			return D3D11_TEXTURE_ADDRESS_WRAP;
+		}
+
+		bool CreateSampler(const CGRenderDevice& device, CGSampler& sampler)
+		{
+			const CGSamplerDesc& desc = sampler.desc;
+
+			D3D11_SAMPLER_DESC samplerDesc = {};
+			samplerDesc.Filter = GetFilter(desc);
+			samplerDesc.AddressU = GetAddressMode(desc.address);
+			samplerDesc.AddressV = samplerDesc.AddressU;
+			samplerDesc.AddressW = samplerDesc.AddressU;
+			samplerDesc.MaxAnisotropy = desc.maxAnisotropy;
+			samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+			samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+			const auto dev = GetD3D11COM<ID3D11Device*>(device.api.d3d11.device);
+
+			return SUCCEEDED(dev->CreateSamplerState(&samplerDesc, GetD3D11COM<ID3D11SamplerState**>(&sampler.api.d3d11.sampler)));
+		}
+
 		bool CreateDebugInterface(CGRenderDevice& device)
 		{
 			if (device.api.d3d11.d3dDebug || device.api.d3d11.d3dInfoQueue)
@@ -607,6 +834,16 @@ namespace cg::renderer::D3D11
 					}
 				}
 
+				for (uint8_t i = 0u; i < bufferPool.cbCount; ++i)
+				{
+					void*& constantBuffer = bufferPool.constantBuffers[i].api.d3d11.buffer;
+					if (constantBuffer)
+					{
+						GetD3D11COM<ID3D11Buffer*>(constantBuffer)->Release();
+						constantBuffer = nullptr;
+					}
+				}
+
 				for (uint8_t i = 0u; i < bufferPool.vlCount; ++i)
 				{
 					void*& vertexLayout = bufferPool.vertexLayouts[i].api.d3d11.layout;
@@ -637,12 +874,52 @@ namespace cg::renderer::D3D11
 					vShader = nullptr;
 				}
 			}
+
+			{
+				CGPipelinePool& pipelinePool = resourcePool.pipelinePool;
+
+				for (uint32_t i = 0u; i < pipelinePool.count; ++i)
+				{
+					CGPipelineState& pipeline = pipelinePool.pipelines[i];
+
+					GetD3D11COM<ID3D11RasterizerState*>(pipeline.api.d3d11.raster)->Release();
+					GetD3D11COM<ID3D11DepthStencilState*>(pipeline.api.d3d11.depth)->Release();
+					GetD3D11COM<ID3D11BlendState*>(pipeline.api.d3d11.blend)->Release();
+					pipeline.api.d3d11 = {};
+				}
+			}
+
+			{
+				CGTexturePool& texturePool = resourcePool.texturePool;
+
+				for (uint32_t i = 0u; i < texturePool.tCount.load(std::memory_order_acquire); ++i)
+				{
+					CGTexture& texture = texturePool.textures[i];
+
+					// Reserved textures that never got their storage have nothing to release
+					if (texture.api.d3d11.texture)
+					{
+						GetD3D11COM<ID3D11ShaderResourceView*>(texture.api.d3d11.view)->Release();
+						GetD3D11COM<ID3D11Texture2D*>(texture.api.d3d11.texture)->Release();
+						texture.api.d3d11 = {};
+					}
+				}
+
+				for (uint32_t i = 0u; i < texturePool.sCount; ++i)
+				{
+					void*& sampler = texturePool.samplers[i].api.d3d11.sampler;
+
+					GetD3D11COM<ID3D11SamplerState*>(sampler)->Release();
+					sampler = nullptr;
+				}
+			}
 		}
 	}
 
 	namespace RenderOps
 	{
 		static void Draw(ID3D11DeviceContext* ctx, const UINT count, const UINT start);
+		static void DrawIndexed(ID3D11DeviceContext* ctx, const UINT count, const UINT start, const INT baseVertex);
 	}
 
 	namespace ContextOps
@@ -652,6 +929,82 @@ namespace cg::renderer::D3D11
 		static void IASetIndexBuffer(ID3D11DeviceContext* ctx, ID3D11Buffer* iBuffer, const DXGI_FORMAT format, const UINT offset);
 		static void VSSetShader(ID3D11DeviceContext* ctx, ID3D11VertexShader* vShader);
 		static void PSSetShader(ID3D11DeviceContext* ctx, ID3D11PixelShader* pShader);
+		static void SetConstantBuffer(ID3D11DeviceContext* ctx, const UINT slot, ID3D11Buffer* cBuffer);
+		static void PSSetTexture(ID3D11DeviceContext* ctx, const UINT slot, ID3D11ShaderResourceView* view);
+		static void PSSetSampler(ID3D11DeviceContext* ctx, const UINT slot, ID3D11SamplerState* sampler);
+
+		// Pipeline state objects resolved to what the context binds
+		struct PipelineObjects
+		{
+			ID3D11VertexShader* vertexShader;
+			ID3D11PixelShader* pixelShader;
+			ID3D11BlendState* blend;
+			ID3D11DepthStencilState* depth;
+			ID3D11RasterizerState* raster;
+			D3D11_PRIMITIVE_TOPOLOGY topology;
+		};
+
+		static constexpr D3D11_PRIMITIVE_TOPOLOGY GetPrimitiveTopology(const CGPrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+				case CGPrimitiveTopology::TriangleList:	 return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+				case CGPrimitiveTopology::TriangleStrip: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+				case CGPrimitiveTopology::LineList:		 return D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+				case CGPrimitiveTopology::LineStrip:	 return D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP;
+				case CGPrimitiveTopology::PointList:	 return D3D11_PRIMITIVE_TOPOLOGY_POINTLIST;
+			}
+
+			return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		}
+
+		static PipelineObjects GetPipelineObjects(const CGShaderPool& shaderPool, const CGPipelineState& pipeline)
+		{
+			PipelineObjects objects = {};
+			objects.vertexShader = GetD3D11COM<ID3D11VertexShader*>(shaderPool.vertexShaders[pipeline.desc.vertexShader].api.d3d11.shader);
+			objects.pixelShader = GetD3D11COM<ID3D11PixelShader*>(shaderPool.fragmentShaders[pipeline.desc.fragmentShader].api.d3d11.shader);
+			objects.blend = GetD3D11COM<ID3D11BlendState*>(pipeline.api.d3d11.blend);
+			objects.depth = GetD3D11COM<ID3D11DepthStencilState*>(pipeline.api.d3d11.depth);
+			objects.raster = GetD3D11COM<ID3D11RasterizerState*>(pipeline.api.d3d11.raster);
+			objects.topology = GetPrimitiveTopology(pipeline.desc.topology);
+
+			return objects;
+		}
+
+		// Input layouts come with the vertex buffer, everything else of the pipeline is bound here
+		static void SetPipelineState(ID3D11DeviceContext* ctx, const PipelineObjects& pipeline, const uint8_t changes)
+		{
+			if (!ctx)
+			{
+				return;
+			}
+
+			if (changes & CG_PIPELINE_SHADERS)
+			{
+				ctx->VSSetShader(pipeline.vertexShader, nullptr, 0U);
+				ctx->PSSetShader(pipeline.pixelShader, nullptr, 0U);
+			}
+
+			if (changes & CG_PIPELINE_TOPOLOGY)
+			{
+				ctx->IASetPrimitiveTopology(pipeline.topology);
+			}
+
+			if (changes & CG_PIPELINE_BLEND)
+			{
+				ctx->OMSetBlendState(pipeline.blend, nullptr, 0xFFFFFFFFU);
+			}
+
+			if (changes & CG_PIPELINE_DEPTH)
+			{
+				ctx->OMSetDepthStencilState(pipeline.depth, 0U);
+			}
+
+			if (changes & CG_PIPELINE_RASTER)
+			{
+				ctx->RSSetState(pipeline.raster);
+			}
+		}
 
 		void OMSetClearView(ID3D11DeviceContext* ctx, ID3D11RenderTargetView* rtv, const D3D11_VIEWPORT& viewport, const float r, const float g, const float b, const float a)
 		{
@@ -679,8 +1032,6 @@ namespace cg::renderer::D3D11
 			ctx->IASetInputLayout(vLayout);
 
 			ctx->IASetVertexBuffers(0U, 1U, &vBuffer, &stride, &offset);
-
-			ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 		}
 
 		void IASetIndexBuffer(ID3D11DeviceContext* ctx, ID3D11Buffer* iBuffer, const DXGI_FORMAT format, const UINT offset)
@@ -713,6 +1064,107 @@ namespace cg::renderer::D3D11
 			ctx->PSSetShader(pShader, nullptr, 0U);
 		}
 
+		// Slots are shared by all stages, like the uniform buffer binding points of OpenGL
+		void SetConstantBuffer(ID3D11DeviceContext* ctx, const UINT slot, ID3D11Buffer* cBuffer)
+		{
+			if (!ctx || !cBuffer)
+			{
+				return;
+			}
+
+			ctx->VSSetConstantBuffers(slot, 1U, &cBuffer);
+			ctx->PSSetConstantBuffers(slot, 1U, &cBuffer);
+		}
+
+		void PSSetTexture(ID3D11DeviceContext* ctx, const UINT slot, ID3D11ShaderResourceView* view)
+		{
+			if (!ctx)
+			{
+				return;
+			}
+
+			ctx->PSSetShaderResources(slot, 1U, &view);
+		}
+
+		void PSSetSampler(ID3D11DeviceContext* ctx, const UINT slot, ID3D11SamplerState* sampler)
+		{
+			if (!ctx || !sampler)
+			{
+				return;
+			}
+
+			ctx->PSSetSamplers(slot, 1U, &sampler);
+		}
+
+		enum class BundleOpType : uint8_t
+		{
+			ClearView = 0u,
+			SetVertexShader = 1u,
+			SetPixelShader = 2u,
+			SetVertexBuffer = 3u,
+			SetIndexBuffer = 4u,
+			Draw = 5u,
+			SetConstantBuffer = 6u,
+			SetPipelineState = 7u,
+			SetTexture = 8u,
+			SetSampler = 9u,
+		};
+
+		// Resolved Direct3D 11 operation, holding the COM pointers and converted values directly
+		struct BundleOp
+		{
+			union
+			{
+				struct
+				{
+					D3D11_VIEWPORT viewport;
+					FLOAT rgba[4];
+					ID3D11RenderTargetView* rtv;
+				} clearView;
+				ID3D11VertexShader* vertexShader;
+				ID3D11PixelShader* pixelShader;
+				struct
+				{
+					ID3D11InputLayout* layout;
+					ID3D11Buffer* buffer;
+					UINT stride;
+					UINT offset;
+				} vertexBuffer;
+				struct
+				{
+					ID3D11Buffer* buffer;
+					UINT offset;
+				} indexBuffer;
+				struct
+				{
+					UINT count;
+					UINT start;
+				} draw;
+				struct
+				{
+					ID3D11Buffer* buffer;
+					UINT slot;
+				} constantBuffer;
+				struct
+				{
+					PipelineObjects objects;
+					uint8_t changes; // Against the previous pipeline of the bundle
+				} pipeline;
+				struct
+				{
+					const CGTexture* texture; // Its view may only be created after the bundle
+					UINT slot;
+				} texture;
+				struct
+				{
+					ID3D11SamplerState* sampler;
+					UINT slot;
+				} sampler;
+			} params = {};
+
+			BundleOpType type = BundleOpType::Draw;
+		};
+
 		bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport)
 		{
 			viewport.width = static_cast<float>(width);
@@ -721,115 +1173,584 @@ namespace cg::renderer::D3D11
 			return true;
 		}
 
-		void ExecuteRenderCommands(const CGRenderContext& context, const CGResourcePool& resourcePool)
+		void ExecuteRenderCommands(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool)
 		{
 			const CGBufferPool& bufferPool = resourcePool.bufferPool;
 			const CGShaderPool& shaderPool = resourcePool.shaderPool;
+			const CGPipelinePool& pipelinePool = resourcePool.pipelinePool;
+
+			// Pipeline the context state matches, nullptr once something else changed any of it
+			const CGPipelineState* bound = nullptr;
+
+			const CGCommandStream& stream = cmdPool.stream;
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			// Pools that were never sorted execute in submission order
+			const uint32_t* order = cmdPool.order.size == stream.packetCount * sizeof(uint32_t) ? ArenaOps::GetData<uint32_t>(cmdPool.order) : nullptr;
 
-			for (uint8_t i = 0u; i < resourcePool.commandPool.count; ++i)
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
 			{
-				const CGRenderCommand& cmd = resourcePool.commandPool.commands[i];
+				const CGRenderPacket& packet = packets[order ? order[p] : p];
 
-				switch (cmd.type)
+				const uint8_t* cursor = commands + packet.offset;
+				const uint8_t* end = cursor + packet.size;
+
+				while (cursor < end)
 				{
-					case CGRenderCommandType::None:
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					switch (static_cast<CGRenderCommandType>(header.type))
 					{
-						break;
+						case CGRenderCommandType::None:
+						{
+							break;
+						}
+						case CGRenderCommandType::SetViewClear:
+						{
+							const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+							void* renderTargetView = context.api.d3d11.renderTargetViews[cmd.view];
+							const CGViewport& viewport = context.api.d3d11.viewports[cmd.viewport];
+							uint32_t color = cmd.color;
+
+							D3D11_VIEWPORT _viewport = {};
+							_viewport.Width = viewport.width;
+							_viewport.Height = viewport.height;
+							_viewport.MinDepth = viewport.minDepth;
+							_viewport.MaxDepth = viewport.maxDepth;
+
+							OMSetClearView(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								GetD3D11COM<ID3D11RenderTargetView*>(renderTargetView),
+								_viewport,
+								((color >> 24) & 0xFF) * CG_ONE_OVER_255,
+								((color >> 16) & 0xFF) * CG_ONE_OVER_255,
+								((color >> 8) & 0xFF) * CG_ONE_OVER_255,
+								(color & 0xFF) * CG_ONE_OVER_255
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::SetPipelineState:
+						{
+							const CGSetPipelineStateCommand& cmd = GetCommand<CGSetPipelineStateCommand>(header);
+
+							if (cmd.pipeline >= pipelinePool.count)
+							{
+								break;
+							}
+
+							const CGPipelineState& pipeline = pipelinePool.pipelines[cmd.pipeline];
+
+							if (bound == &pipeline)
+							{
+								continue;
+							}
+
+							SetPipelineState(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								GetPipelineObjects(shaderPool, pipeline),
+								bound ? GetPipelineChanges(bound->desc, pipeline.desc) : static_cast<uint8_t>(CG_PIPELINE_ALL)
+							);
+
+							bound = &pipeline;
+
+							continue;
+						}
+						case CGRenderCommandType::SetVertexShader:
+						{
+							const CGSetVertexShaderCommand& cmd = GetCommand<CGSetVertexShaderCommand>(header);
+
+							void* vertexShader = shaderPool.vertexShaders[cmd.shader].api.d3d11.shader;
+							bound = nullptr;
+
+							VSSetShader(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								GetD3D11COM<ID3D11VertexShader*>(vertexShader)
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::SetFragmentShader:
+						{
+							const CGSetFragmentShaderCommand& cmd = GetCommand<CGSetFragmentShaderCommand>(header);
+
+							void* pixelShader = shaderPool.fragmentShaders[cmd.shader].api.d3d11.shader;
+							bound = nullptr;
+
+							PSSetShader(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								GetD3D11COM<ID3D11PixelShader*>(pixelShader)
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::SetVertexBuffer:
+						{
+							const CGSetVertexBufferCommand& cmd = GetCommand<CGSetVertexBufferCommand>(header);
+
+							// No transient memory in Direct3D 11 yet
+							if (cmd.buffer == CG_TRANSIENT_BUFFER)
+							{
+								break;
+							}
+
+							const CGVertexLayout& vertexLayout = bufferPool.vertexLayouts[cmd.buffer];
+							const CGBuffer& vertexBuffer = bufferPool.vertexBuffers[cmd.buffer];
+
+							IASetVertexBuffer(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								GetD3D11COM<ID3D11InputLayout*>(vertexLayout.api.d3d11.layout),
+								GetD3D11COM<ID3D11Buffer*>(vertexBuffer.api.d3d11.buffer),
+								vertexBuffer.desc.stride,
+								cmd.offset
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::SetIndexBuffer:
+						{
+							const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+
+							if (cmd.buffer == CG_TRANSIENT_BUFFER)
+							{
+								break;
+							}
+
+							const CGBuffer& indexBuffer = bufferPool.indexBuffers[cmd.buffer];
+
+							IASetIndexBuffer(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								GetD3D11COM<ID3D11Buffer*>(indexBuffer.api.d3d11.buffer),
+								DXGI_FORMAT_R16_UINT,
+								cmd.offset
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::Draw:
+						{
+							const CGDrawCommand& cmd = GetCommand<CGDrawCommand>(header);
+
+							RenderOps::Draw(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								cmd.count,
+								cmd.start
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::DrawIndexed:
+						{
+							const CGDrawIndexedCommand& cmd = GetCommand<CGDrawIndexedCommand>(header);
+
+							RenderOps::DrawIndexed(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								cmd.count,
+								cmd.start,
+								cmd.baseVertex
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::ExecuteBundle:
+						{
+							const CGExecuteBundleCommand& cmd = GetCommand<CGExecuteBundleCommand>(header);
+
+							if (cmd.bundle < resourcePool.bundlePool.count)
+							{
+								ExecuteBundle(context, resourcePool.bundlePool.bundles[cmd.bundle]);
+								bound = nullptr;
+							}
+
+							continue;
+						}
+						case CGRenderCommandType::SetConstantBuffer:
+						{
+							const CGSetConstantBufferCommand& cmd = GetCommand<CGSetConstantBufferCommand>(header);
+
+							// Ranges need ID3D11DeviceContext1, whole buffers only for now
+							if (cmd.buffer >= bufferPool.cbCount || cmd.offset != 0u || cmd.slot >= CG_MAX_CONSTANT_SLOTS)
+							{
+								break;
+							}
+
+							SetConstantBuffer(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								cmd.slot,
+								GetD3D11COM<ID3D11Buffer*>(bufferPool.constantBuffers[cmd.buffer].api.d3d11.buffer)
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::SetTexture:
+						{
+							const CGSetTextureCommand& cmd = GetCommand<CGSetTextureCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.texture >= resourcePool.texturePool.tCount.load(std::memory_order_acquire))
+							{
+								break;
+							}
+
+							// Textures still loading bind no view, which samples black
+							PSSetTexture(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								cmd.slot,
+								GetD3D11COM<ID3D11ShaderResourceView*>(resourcePool.texturePool.textures[cmd.texture].api.d3d11.view)
+							);
+
+							continue;
+						}
+						case CGRenderCommandType::SetSampler:
+						{
+							const CGSetSamplerCommand& cmd = GetCommand<CGSetSamplerCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.sampler >= resourcePool.texturePool.sCount)
+							{
+								break;
+							}
+
+							PSSetSampler(
+								GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
+								cmd.slot,
+								GetD3D11COM<ID3D11SamplerState*>(resourcePool.texturePool.samplers[cmd.sampler].api.d3d11.sampler)
+							);
+
+							continue;
+						}
 					}
-					case CGRenderCommandType::SetViewClear:
+
+					break;
+				}
+			}
+		}
+
+		bool CompileBundle(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandStream& stream, CGRenderBundle& bundle)
+		{
+			const CGBufferPool& bufferPool = resourcePool.bufferPool;
+			const CGShaderPool& shaderPool = resourcePool.shaderPool;
+			const CGPipelinePool& pipelinePool = resourcePool.pipelinePool;
+
+			// Nothing is known about the state a bundle is replayed in, its first pipeline is bound in full
+			const CGPipelineState* previous = nullptr;
+
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			ArenaOps::Reset(bundle.ops);
+			bundle.count = 0u;
+
+			const auto AddOp = [&bundle](const BundleOpType type) -> BundleOp&
+			{
+				BundleOp* op = new (ArenaOps::Allocate(sizeof(BundleOp), bundle.ops)) BundleOp();
+				op->type = type;
+
+				bundle.count++;
+
+				return *op;
+			};
+
+			// Bundles replay in recorded order, packets are not sorted
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const uint8_t* cursor = commands + packets[p].offset;
+				const uint8_t* end = cursor + packets[p].size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					switch (static_cast<CGRenderCommandType>(header.type))
 					{
-						void* renderTargetView = context.api.d3d11.renderTargetViews[cmd.params.setViewClear.view];
-						const CGViewport& viewport = context.api.d3d11.viewports[cmd.params.setViewClear.viewport];
-						uint32_t color = cmd.params.setViewClear.color;
+						case CGRenderCommandType::SetViewClear:
+						{
+							const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+							if (cmd.view >= context.api.d3d11.renderTargetViewCount || cmd.viewport >= context.api.d3d11.viewportCount)
+							{
+								break;
+							}
+
+							const CGViewport& viewport = context.api.d3d11.viewports[cmd.viewport];
+
+							BundleOp& op = AddOp(BundleOpType::ClearView);
+							op.params.clearView.viewport.TopLeftX = viewport.x;
+							op.params.clearView.viewport.TopLeftY = viewport.y;
+							op.params.clearView.viewport.Width = viewport.width;
+							op.params.clearView.viewport.Height = viewport.height;
+							op.params.clearView.viewport.MinDepth = viewport.minDepth;
+							op.params.clearView.viewport.MaxDepth = viewport.maxDepth;
+							op.params.clearView.rgba[0] = ((cmd.color >> 24) & 0xFF) * CG_ONE_OVER_255;
+							op.params.clearView.rgba[1] = ((cmd.color >> 16) & 0xFF) * CG_ONE_OVER_255;
+							op.params.clearView.rgba[2] = ((cmd.color >> 8) & 0xFF) * CG_ONE_OVER_255;
+							op.params.clearView.rgba[3] = (cmd.color & 0xFF) * CG_ONE_OVER_255;
+							op.params.clearView.rtv = GetD3D11COM<ID3D11RenderTargetView*>(context.api.d3d11.renderTargetViews[cmd.view]);
+
+							continue;
+						}
+						case CGRenderCommandType::SetPipelineState:
+						{
+							const CGSetPipelineStateCommand& cmd = GetCommand<CGSetPipelineStateCommand>(header);
+
+							if (cmd.pipeline >= pipelinePool.count)
+							{
+								break;
+							}
+
+							const CGPipelineState& pipeline = pipelinePool.pipelines[cmd.pipeline];
+
+							if (previous == &pipeline)
+							{
+								continue;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::SetPipelineState);
+							op.params.pipeline.objects = GetPipelineObjects(shaderPool, pipeline);
+							op.params.pipeline.changes = previous ? GetPipelineChanges(previous->desc, pipeline.desc) : static_cast<uint8_t>(CG_PIPELINE_ALL);
+
+							previous = &pipeline;
+
+							continue;
+						}
+						case CGRenderCommandType::SetVertexShader:
+						{
+							const CGSetVertexShaderCommand& cmd = GetCommand<CGSetVertexShaderCommand>(header);
+
+							if (cmd.shader >= shaderPool.vsCount)
+							{
+								break;
+							}
+
+							previous = nullptr;
+
+							AddOp(BundleOpType::SetVertexShader).params.vertexShader = GetD3D11COM<ID3D11VertexShader*>(shaderPool.vertexShaders[cmd.shader].api.d3d11.shader);
+
+							continue;
+						}
+						case CGRenderCommandType::SetFragmentShader:
+						{
+							const CGSetFragmentShaderCommand& cmd = GetCommand<CGSetFragmentShaderCommand>(header);
+
+							if (cmd.shader >= shaderPool.fsCount)
+							{
+								break;
+							}
+
+							previous = nullptr;
+
+							AddOp(BundleOpType::SetPixelShader).params.pixelShader = GetD3D11COM<ID3D11PixelShader*>(shaderPool.fragmentShaders[cmd.shader].api.d3d11.shader);
+
+							continue;
+						}
+						case CGRenderCommandType::SetVertexBuffer:
+						{
+							const CGSetVertexBufferCommand& cmd = GetCommand<CGSetVertexBufferCommand>(header);
+
+							if (cmd.buffer >= bufferPool.vlCount || cmd.buffer >= bufferPool.vbCount)
+							{
+								break;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::SetVertexBuffer);
+							op.params.vertexBuffer.layout = GetD3D11COM<ID3D11InputLayout*>(bufferPool.vertexLayouts[cmd.buffer].api.d3d11.layout);
+							op.params.vertexBuffer.buffer = GetD3D11COM<ID3D11Buffer*>(bufferPool.vertexBuffers[cmd.buffer].api.d3d11.buffer);
+							op.params.vertexBuffer.stride = bufferPool.vertexBuffers[cmd.buffer].desc.stride;
+							op.params.vertexBuffer.offset = cmd.offset;
+
+							continue;
+						}
+						case CGRenderCommandType::SetIndexBuffer:
+						{
+							const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+
+							if (cmd.buffer >= bufferPool.ibCount)
+							{
+								break;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::SetIndexBuffer);
+							op.params.indexBuffer.buffer = GetD3D11COM<ID3D11Buffer*>(bufferPool.indexBuffers[cmd.buffer].api.d3d11.buffer);
+							op.params.indexBuffer.offset = cmd.offset;
+
+							continue;
+						}
+						case CGRenderCommandType::Draw:
+						{
+							const CGDrawCommand& cmd = GetCommand<CGDrawCommand>(header);
+
+							BundleOp& op = AddOp(BundleOpType::Draw);
+							op.params.draw.count = cmd.count;
+							op.params.draw.start = cmd.start;
+
+							continue;
+						}
+						case CGRenderCommandType::SetConstantBuffer:
+						{
+							const CGSetConstantBufferCommand& cmd = GetCommand<CGSetConstantBufferCommand>(header);
+
+							if (cmd.buffer >= bufferPool.cbCount || cmd.offset != 0u || cmd.slot >= CG_MAX_CONSTANT_SLOTS)
+							{
+								break;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::SetConstantBuffer);
+							op.params.constantBuffer.buffer = GetD3D11COM<ID3D11Buffer*>(bufferPool.constantBuffers[cmd.buffer].api.d3d11.buffer);
+							op.params.constantBuffer.slot = cmd.slot;
+
+							continue;
+						}
+						case CGRenderCommandType::SetTexture:
+						{
+							const CGSetTextureCommand& cmd = GetCommand<CGSetTextureCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.texture >= resourcePool.texturePool.tCount.load(std::memory_order_acquire))
+							{
+								break;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::SetTexture);
+							op.params.texture.texture = &resourcePool.texturePool.textures[cmd.texture];
+							op.params.texture.slot = cmd.slot;
+
+							continue;
+						}
+						case CGRenderCommandType::SetSampler:
+						{
+							const CGSetSamplerCommand& cmd = GetCommand<CGSetSamplerCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.sampler >= resourcePool.texturePool.sCount)
+							{
+								break;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::SetSampler);
+							op.params.sampler.sampler = GetD3D11COM<ID3D11SamplerState*>(resourcePool.texturePool.samplers[cmd.sampler].api.d3d11.sampler);
+							op.params.sampler.slot = cmd.slot;
+
+							continue;
+						}
+						case CGRenderCommandType::None:
+						case CGRenderCommandType::DrawIndexed:
+						case CGRenderCommandType::ExecuteBundle:
+						{
+							break;
+						}
+					}
+
+					// Invalid, unsupported or nested commands make the whole bundle invalid
+					ArenaOps::Reset(bundle.ops);
+					bundle.count = 0u;
+
+					return false;
+				}
+			}
 
-						D3D11_VIEWPORT _viewport = {};
-						_viewport.Width = viewport.width;
-						_viewport.Height = viewport.height;
-						_viewport.MinDepth = viewport.minDepth;
-						_viewport.MaxDepth = viewport.maxDepth;
+			return bundle.count > 0u;
+		}
+
+		void ExecuteBundle(const CGRenderContext& context, const CGRenderBundle& bundle)
+		{
+			const auto ctx = GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context);
 
+			const BundleOp* ops = ArenaOps::GetData<BundleOp>(bundle.ops);
+
+			for (uint32_t i = 0u; i < bundle.count; ++i)
+			{
+				const BundleOp& op = ops[i];
+
+				switch (op.type)
+				{
+					case BundleOpType::ClearView:
+					{
 						OMSetClearView(
-							GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
-							GetD3D11COM<ID3D11RenderTargetView*>(renderTargetView),
-							_viewport,
-							((color >> 24) & 0xFF) * CG_ONE_OVER_255,
-							((color >> 16) & 0xFF) * CG_ONE_OVER_255,
-							((color >> 8) & 0xFF) * CG_ONE_OVER_255,
-							(color & 0xFF) * CG_ONE_OVER_255
+							ctx,
+							op.params.clearView.rtv,
+							op.params.clearView.viewport,
+							op.params.clearView.rgba[0],
+							op.params.clearView.rgba[1],
+							op.params.clearView.rgba[2],
+							op.params.clearView.rgba[3]
 						);
-
-						continue;
+						break;
 					}
-					case CGRenderCommandType::SetPipelineState:
+					case BundleOpType::SetVertexShader:
 					{
-						continue;
+						VSSetShader(ctx, op.params.vertexShader);
+						break;
 					}
-					case CGRenderCommandType::SetVertexShader:
+					case BundleOpType::SetPixelShader:
 					{
-						void* vertexShader = shaderPool.vertexShaders[cmd.params.setShader.shader].api.d3d11.shader;
-
-						VSSetShader(
-							GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
-							GetD3D11COM<ID3D11VertexShader*>(vertexShader)
-						);
-
-						continue;
+						PSSetShader(ctx, op.params.pixelShader);
+						break;
 					}
-					case CGRenderCommandType::SetFragmentShader:
+					case BundleOpType::SetVertexBuffer:
 					{
-						void* pixelShader = shaderPool.fragmentShaders[cmd.params.setShader.shader].api.d3d11.shader;
-
-						PSSetShader(
-							GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
-							GetD3D11COM<ID3D11PixelShader*>(pixelShader)
-						);
-
-						continue;
+						IASetVertexBuffer(ctx, op.params.vertexBuffer.layout, op.params.vertexBuffer.buffer, op.params.vertexBuffer.stride, op.params.vertexBuffer.offset);
+						break;
 					}
-					case CGRenderCommandType::SetVertexBuffer:
+					case BundleOpType::SetIndexBuffer:
 					{
-						const CGVertexLayout& vertexLayout = bufferPool.vertexLayouts[cmd.params.setVertexBuffer.buffer];
-						const CGBuffer& vertexBuffer = bufferPool.vertexBuffers[cmd.params.setVertexBuffer.buffer];
-
-						IASetVertexBuffer(
-							GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
-							GetD3D11COM<ID3D11InputLayout*>(vertexLayout.api.d3d11.layout),
-							GetD3D11COM<ID3D11Buffer*>(vertexBuffer.api.d3d11.buffer),
-							vertexBuffer.desc.stride,
-							0U
-						);
-
-						continue;
+						IASetIndexBuffer(ctx, op.params.indexBuffer.buffer, DXGI_FORMAT_R16_UINT, op.params.indexBuffer.offset);
+						break;
 					}
-					case CGRenderCommandType::SetIndexBuffer:
+					case BundleOpType::Draw:
 					{
-						const CGBuffer& indexBuffer = bufferPool.indexBuffers[cmd.params.setIndexBuffer.buffer];
-
-						IASetIndexBuffer(
-							GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
-							GetD3D11COM<ID3D11Buffer*>(indexBuffer.api.d3d11.buffer),
-							DXGI_FORMAT_R16_UINT,
-							0U
-						);
-
-						continue;
+						RenderOps::Draw(ctx, op.params.draw.count, op.params.draw.start);
+						break;
 					}
-					case CGRenderCommandType::Draw:
+					case BundleOpType::SetConstantBuffer:
 					{
-						RenderOps::Draw(
-							GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context),
-							cmd.params.draw.count,
-							cmd.params.draw.start
-						);
-
-						continue;
+						SetConstantBuffer(ctx, op.params.constantBuffer.slot, op.params.constantBuffer.buffer);
+						break;
+					}
+					case BundleOpType::SetPipelineState:
+					{
+						SetPipelineState(ctx, op.params.pipeline.objects, op.params.pipeline.changes);
+						break;
+					}
+					case BundleOpType::SetTexture:
+					{
+						PSSetTexture(ctx, op.params.texture.slot, GetD3D11COM<ID3D11ShaderResourceView*>(op.params.texture.texture->api.d3d11.view));
+						break;
+					}
+					case BundleOpType::SetSampler:
+					{
+						PSSetSampler(ctx, op.params.sampler.slot, op.params.sampler.sampler);
+						break;
 					}
 				}
-
-				break;
 			}
 		}
 
+		void UploadTextureMip(const CGRenderContext& context, const uint8_t level, const void* data, CGTexture& texture)
+		{
+			const auto ctx = GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context);
+			const auto resource = GetD3D11COM<ID3D11Texture2D*>(texture.api.d3d11.texture);
+			const UINT width = texture.desc.width >> level ? texture.desc.width >> level : 1U;
+
+			ctx->UpdateSubresource(resource, level, nullptr, data, width * 4U, 0U);
+			ctx->SetResourceMinLOD(resource, static_cast<FLOAT>(level));
+		}
+
+		void UploadTextureRegion(const CGRenderContext& context, const CGTextureUpload& upload, const uint8_t level, const void* data, const CGTexture& texture)
+		{
+			const auto ctx = GetD3D11COM<ID3D11DeviceContext*>(context.api.d3d11.context);
+			const UINT width = upload.desc.width >> level ? upload.desc.width >> level : 1U;
+			const UINT height = upload.desc.height >> level ? upload.desc.height >> level : 1U;
+
+			D3D11_BOX box = {};
+			box.left = upload.x >> level;
+			box.top = upload.y >> level;
+			box.right = box.left + width;
+			box.bottom = box.top + height;
+			box.back = 1U;
+
+			ctx->UpdateSubresource(GetD3D11COM<ID3D11Texture2D*>(texture.api.d3d11.texture), D3D11CalcSubresource(level, upload.layer, texture.desc.mipCount), &box, data, width * 4U, 0U);
+		}
+
 		void DestroyContext(CGRenderContext& context)
 		{
 			for (uint8_t i = 0u; i < context.api.d3d11.renderTargetViewCount; ++i)
@@ -869,6 +1790,16 @@ namespace cg::renderer::D3D11
 
 			ctx->Draw(count, start);
 		}
+
+		void DrawIndexed(ID3D11DeviceContext* ctx, const UINT count, const UINT start, const INT baseVertex)
+		{
+			if (!ctx)
+			{
+				return;
+			}
+
+			ctx->DrawIndexed(count, start, baseVertex);
+		}
 	}
 
 	namespace FrameOps
@@ -0,0 +1,428 @@
+#include <cstring>
+
+#include "renderer.h"
+
+// renderer_null.cpp
+namespace cg::renderer::Null
+{
+	static int InitNull()
+	{
+		return 1;
+	}
+
+	static void ShutdownNull()
+	{
+	}
+
+	// Counts a bind the way an API state cache would see it
+	static void SetState(CGRenderStats& stats, uint32_t& bound, const uint32_t value)
+	{
+		if (bound == value)
+		{
+			stats.redundantStates++;
+			return;
+		}
+
+		bound = value;
+		stats.stateChanges++;
+	}
+
+	static void SetViewport(CGRenderStats& stats, CGStateCache& cache, const CGViewport& viewport)
+	{
+		if (std::memcmp(&cache.viewport, &viewport, sizeof(CGViewport)) == 0)
+		{
+			stats.redundantStates++;
+			return;
+		}
+
+		cache.viewport = viewport;
+		stats.stateChanges++;
+	}
+
+	// Every command except ExecuteBundle, which needs the resource pool and is handled by the caller
+	static void ExecuteCommand(CGRenderContext& context, const CGPipelinePool& pipelinePool, const CGCommandHeader& header)
+	{
+		CGStateCache& cache = context.api.null.stateCache;
+		CGRenderStats& stats = context.api.null.stats;
+
+		if (header.type < CG_MAX_RENDER_COMMAND_TYPES)
+		{
+			stats.commands[header.type]++;
+		}
+
+		switch (static_cast<CGRenderCommandType>(header.type))
+		{
+			case CGRenderCommandType::None:
+			{
+				break;
+			}
+			case CGRenderCommandType::SetViewClear:
+			{
+				const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+				if (cmd.viewport < context.api.null.viewportCount)
+				{
+					SetViewport(stats, cache, context.api.null.viewports[cmd.viewport]);
+				}
+
+				SetState(stats, cache.clearColor, cmd.color);
+
+				break;
+			}
+			case CGRenderCommandType::SetPipelineState:
+			{
+				const uint32_t pipeline = GetCommand<CGSetPipelineStateCommand>(header).pipeline;
+
+				if (pipeline >= pipelinePool.count)
+				{
+					break;
+				}
+
+				if (cache.pipeline == pipeline + 1u)
+				{
+					stats.redundantStates++;
+					break;
+				}
+
+				const CGPipelineDesc& desc = pipelinePool.pipelines[pipeline].desc;
+				uint8_t changes = cache.pipeline ? GetPipelineChanges(pipelinePool.pipelines[cache.pipeline - 1u].desc, desc) : static_cast<uint8_t>(CG_PIPELINE_ALL);
+
+				// One API call per sub-state that differs
+				for (; changes != 0u; changes &= static_cast<uint8_t>(changes - 1u))
+				{
+					stats.stateChanges++;
+				}
+
+				cache.pipeline = pipeline + 1u;
+				break;
+			}
+			case CGRenderCommandType::SetVertexShader:
+			case CGRenderCommandType::SetFragmentShader:
+			{
+				break;
+			}
+			case CGRenderCommandType::SetVertexBuffer:
+			{
+				const CGSetVertexBufferCommand& cmd = GetCommand<CGSetVertexBufferCommand>(header);
+
+				// Transient binds go through the vertex array of their layout, offsets always reach the API
+				if (cmd.buffer == CG_TRANSIENT_BUFFER || cmd.offset != 0u)
+				{
+					cache.vertexArray = 0u;
+				}
+
+				SetState(stats, cache.vertexArray, (cmd.buffer == CG_TRANSIENT_BUFFER ? cmd.layout : cmd.buffer) + 1u);
+				break;
+			}
+			case CGRenderCommandType::SetIndexBuffer:
+			{
+				const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+
+				if (cmd.offset != 0u)
+				{
+					cache.indexBuffer = 0u;
+				}
+
+				// The transient buffer is tracked as one past the last index buffer
+				SetState(stats, cache.indexBuffer, (cmd.buffer == CG_TRANSIENT_BUFFER ? CG_MAX_INDEX_BUFFERS : cmd.buffer) + 1u);
+				break;
+			}
+			case CGRenderCommandType::Draw:
+			{
+				stats.drawCalls++;
+				stats.vertices += GetCommand<CGDrawCommand>(header).count;
+				break;
+			}
+			case CGRenderCommandType::DrawIndexed:
+			{
+				stats.drawCalls++;
+				stats.vertices += GetCommand<CGDrawIndexedCommand>(header).count;
+				break;
+			}
+			case CGRenderCommandType::ExecuteBundle:
+			{
+				break;
+			}
+			case CGRenderCommandType::SetConstantBuffer:
+			{
+				const CGSetConstantBufferCommand& cmd = GetCommand<CGSetConstantBufferCommand>(header);
+
+				if (cmd.slot >= CG_MAX_CONSTANT_SLOTS)
+				{
+					break;
+				}
+
+				// One bind-range call per change, compared as a whole range. The transient buffer is tracked as
+				// one past the last constant buffer.
+				CGConstantBinding& bound = cache.constants[cmd.slot];
+				const uint32_t buffer = (cmd.buffer == CG_TRANSIENT_BUFFER ? CG_MAX_CONSTANT_BUFFERS : cmd.buffer) + 1u;
+
+				if (bound.buffer == buffer && bound.offset == cmd.offset && bound.size == cmd.size)
+				{
+					stats.redundantStates++;
+					break;
+				}
+
+				bound.buffer = buffer;
+				bound.offset = cmd.offset;
+				bound.size = cmd.size;
+				stats.stateChanges++;
+
+				break;
+			}
+			case CGRenderCommandType::SetTexture:
+			{
+				const CGSetTextureCommand& cmd = GetCommand<CGSetTextureCommand>(header);
+
+				if (cmd.slot < CG_MAX_TEXTURE_SLOTS)
+				{
+					SetState(stats, cache.textures[cmd.slot], cmd.texture + 1u);
+				}
+
+				break;
+			}
+			case CGRenderCommandType::SetSampler:
+			{
+				const CGSetSamplerCommand& cmd = GetCommand<CGSetSamplerCommand>(header);
+
+				if (cmd.slot < CG_MAX_TEXTURE_SLOTS)
+				{
+					SetState(stats, cache.samplers[cmd.slot], cmd.sampler + 1u);
+				}
+
+				break;
+			}
+		}
+	}
+
+	bool Init(CGRenderFunctions& functions)
+	{
+		functions.init = InitNull;
+		functions.shutdown = ShutdownNull;
+
+		return true;
+	}
+
+	bool CreateDeviceAndContext(CGRenderDevice& device, CGRenderContext& context)
+	{
+		device.deviceInfo.adapterName = "Null Device";
+		device.deviceInfo.constantAlignment = 256u; // The strictest common GPU requirement
+
+		context.api.null = {};
+		context.device = &device;
+
+		return true;
+	}
+
+	namespace DeviceOps
+	{
+		bool CreateShader(CGRenderContext& context, const CGShaderDesc& desc, CGShader& shader)
+		{
+			// Sources are never read, the benchmark only covers engine-side bookkeeping
+			if (desc.shaderType == CGShaderType::None)
+			{
+				return false;
+			}
+
+			shader.type = desc.shaderType;
+			context.api.null.stats.shaders++;
+
+			return true;
+		}
+
+		bool CreateShaderProgram(CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program)
+		{
+			if (shaderCount < 1u || shaders == nullptr)
+			{
+				return false;
+			}
+
+			// Names start at 1 like GL programs, 0 stays "no program"
+			context.api.null.stats.programs++;
+			program = context.api.null.stats.programs;
+
+			return true;
+		}
+
+		bool CreateVertexBuffer(CGRenderContext& context, const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData)
+		{
+			(void)vBuffer;
+
+			CGRenderStats& stats = context.api.null.stats;
+			stats.buffers++;
+			stats.bytesUploaded += vbData ? vbDesc.size : 0u;
+
+			return true;
+		}
+
+		bool CreateIndexBuffer(CGRenderContext& context, const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData)
+		{
+			(void)iBuffer;
+
+			CGRenderStats& stats = context.api.null.stats;
+			stats.buffers++;
+			stats.bytesUploaded += ibData ? ibDesc.size : 0u;
+
+			return true;
+		}
+
+		void DestroyBuffer(CGRenderContext& context, CGBuffer& buffer)
+		{
+			(void)buffer;
+
+			context.api.null.stats.buffers--;
+		}
+
+		bool CreateConstantBuffer(CGRenderContext& context, const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData)
+		{
+			(void)cBuffer;
+
+			CGRenderStats& stats = context.api.null.stats;
+			stats.buffers++;
+			stats.bytesUploaded += cbData ? cbDesc.size : 0u;
+
+			return true;
+		}
+
+		bool CreateVertexLayout(CGRenderContext& context, CGVertexLayout& vLayout)
+		{
+			if (vLayout.count < 1u)
+			{
+				return false;
+			}
+
+			context.api.null.stats.vertexLayouts++;
+
+			return true;
+		}
+
+		void UploadBuffers(CGRenderContext& context, const CGLinearArena& uploads, CGUploadStats stats[])
+		{
+			const uint8_t* records = ArenaOps::GetData<uint8_t>(uploads);
+
+			for (size_t offset = 0ull; offset < uploads.size;)
+			{
+				const CGBufferUpload& upload = *reinterpret_cast<const CGBufferUpload*>(records + offset);
+				offset += upload.stride;
+
+				if (!upload.committed)
+				{
+					continue;
+				}
+
+				CGUploadStats& strategyStats = stats[static_cast<uint8_t>(upload.strategy)];
+				strategyStats.uploads++;
+				strategyStats.bytes += upload.size;
+
+				context.api.null.stats.bytesUploaded += upload.size;
+			}
+		}
+	}
+
+	namespace ContextOps
+	{
+		bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport)
+		{
+			viewport.x = 0.0f;
+			viewport.y = 0.0f;
+			viewport.width = static_cast<float>(width);
+			viewport.height = static_cast<float>(height);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+
+			return true;
+		}
+
+		void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool)
+		{
+			const CGCommandStream& stream = cmdPool.stream;
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			// Pools that were never sorted execute in submission order
+			const uint32_t* order = cmdPool.order.size == stream.packetCount * sizeof(uint32_t) ? ArenaOps::GetData<uint32_t>(cmdPool.order) : nullptr;
+
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const CGRenderPacket& packet = packets[order ? order[p] : p];
+
+				const uint8_t* cursor = commands + packet.offset;
+				const uint8_t* end = cursor + packet.size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					ExecuteCommand(context, resourcePool.pipelinePool, header);
+
+					if (static_cast<CGRenderCommandType>(header.type) == CGRenderCommandType::ExecuteBundle)
+					{
+						const CGExecuteBundleCommand& cmd = GetCommand<CGExecuteBundleCommand>(header);
+
+						if (cmd.bundle < resourcePool.bundlePool.count)
+						{
+							ExecuteBundle(context, resourcePool, resourcePool.bundlePool.bundles[cmd.bundle]);
+						}
+					}
+				}
+			}
+
+			context.api.null.stats.frames++;
+		}
+
+		bool CompileBundle(const CGCommandStream& stream, CGRenderBundle& bundle)
+		{
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			ArenaOps::Reset(bundle.ops);
+			bundle.count = 0u;
+
+			// There is nothing to translate to, the packed commands are kept as they are and packets are
+			// flattened into recorded order
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const uint8_t* cursor = commands + packets[p].offset;
+				const uint8_t* end = cursor + packets[p].size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					// Nested bundles make the whole bundle invalid
+					void* op = static_cast<CGRenderCommandType>(header.type) != CGRenderCommandType::ExecuteBundle ?
+						ArenaOps::Allocate(header.size, bundle.ops) : nullptr;
+
+					if (!op)
+					{
+						ArenaOps::Reset(bundle.ops);
+						bundle.count = 0u;
+
+						return false;
+					}
+
+					std::memcpy(op, &header, header.size);
+					bundle.count++;
+				}
+			}
+
+			return bundle.count > 0u;
+		}
+
+		void ExecuteBundle(CGRenderContext& context, const CGResourcePool& resourcePool, const CGRenderBundle& bundle)
+		{
+			const uint8_t* cursor = ArenaOps::GetData<uint8_t>(bundle.ops);
+			const uint8_t* end = cursor + bundle.ops.size;
+
+			while (cursor < end)
+			{
+				const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+				cursor += header.size;
+
+				ExecuteCommand(context, resourcePool.pipelinePool, header);
+			}
+		}
+	}
+}
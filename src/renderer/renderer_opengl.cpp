@@ -1,6 +1,9 @@
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <new>
 
 #include "renderer.h"
 #include "platform/window.h"
@@ -79,10 +82,22 @@ namespace cg::renderer::OpenGL
 		}
 	}
 
-	bool Init(const bool debug, CGRenderFunctions& functions)
+	bool Init(const bool debug, const bool headless, CGRenderFunctions& functions)
 	{
 		functions.init = glfwInit;
 		functions.shutdown = glfwTerminate;
+
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+		// Without a display server the null platform creates a surfaceless EGL context
+		const bool surfaceless = headless && glfwPlatformSupported(GLFW_PLATFORM_NULL);
+
+		if (surfaceless)
+		{
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+		}
+#else
+		const bool surfaceless = false;
+#endif
 	
 		if (!functions.init())
 		{
@@ -94,11 +109,135 @@ namespace cg::renderer::OpenGL
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debug);
+
+		// Headless contexts still come with a window, it is just never shown
+		if (headless)
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		}
+
+		if (surfaceless)
+		{
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+		}
 	
 		return true;
 	}
 
-	bool CreateDeviceAndContext(const bool debug, const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context)
+	// Color and depth-stencil targets that replace the default framebuffer of a headless context
+	static bool CreateOffscreenFramebuffer(const int32_t width, const int32_t height, CGRenderContext& context)
+	{
+		GLuint framebuffer = 0u;
+		GLuint renderbuffers[2] = {};
+
+		glCreateFramebuffers(1, &framebuffer);
+		glCreateRenderbuffers(2, renderbuffers);
+
+		glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, width, height);
+		glNamedRenderbufferStorage(renderbuffers[1], GL_DEPTH24_STENCIL8, width, height);
+
+		glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+		glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+
+		if (glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("Offscreen framebuffer incomplete");
+
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(2, renderbuffers);
+
+			return false;
+		}
+
+		// Stays bound for the lifetime of the context, clears and draws land in it
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+		context.api.opengl.framebuffer = framebuffer;
+		context.api.opengl.renderbuffers[0] = renderbuffers[0];
+		context.api.opengl.renderbuffers[1] = renderbuffers[1];
+
+		return true;
+	}
+
+	// std430 mirror of CGVertexLayoutDesc in the vertex pulling prelude
+	struct PullElement
+	{
+		uint32_t offset = 0u;
+		uint32_t components = 0u;
+		uint32_t type = 0u; // 0 float, 1 unsigned int
+		uint32_t padding = 0u;
+	};
+
+	struct PullLayout
+	{
+		uint32_t stride = 0u;
+		uint32_t count = 0u;
+		uint32_t padding[2] = {};
+		PullElement elements[CG_MAX_VERTEX_ELEMENTS] = {};
+	};
+
+	// Descriptors are bound as storage ranges, so each one starts at a storage offset alignment
+	static uint32_t GetLayoutDescriptorStride(const CGRenderContext& context)
+	{
+		return AlignUp(static_cast<uint32_t>(sizeof(PullLayout)), context.device->deviceInfo.storageAlignment);
+	}
+
+	// Vertex data is fetched through storage buffers, the only vertex array left is an empty one that
+	// carries the element buffer binding and stays bound for the lifetime of the context
+	static bool CreatePullingResources(CGRenderContext& context)
+	{
+		uint32_t vao = 0u;
+		uint32_t buffer = 0u;
+
+		glCreateVertexArrays(1, &vao);
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(GetLayoutDescriptorStride(context)) * CG_MAX_VERTEX_LAYOUTS, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		if (glGetError() != GL_NO_ERROR || vao == 0u || buffer == 0u)
+		{
+			printf("Failed to create the vertex pulling resources");
+
+			glDeleteVertexArrays(1, &vao);
+			glDeleteBuffers(1, &buffer);
+
+			return false;
+		}
+
+		context.api.opengl.pullingArray = vao;
+		context.api.opengl.layoutBuffer = buffer;
+
+		return true;
+	}
+
+	// One-shot data of all frame pools in a single persistently mapped buffer, each pool owns a segment
+	static bool CreateTransientBuffer(CGRenderContext& context)
+	{
+		constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		constexpr GLsizeiptr size = static_cast<GLsizeiptr>(CG_TRANSIENT_SIZE) * CG_MAX_FRAME_POOLS;
+
+		uint32_t buffer = 0u;
+
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, size, nullptr, flags);
+
+		void* mapped = glMapNamedBufferRange(buffer, 0, size, flags);
+
+		if (glGetError() != GL_NO_ERROR || !mapped)
+		{
+			printf("Failed to create the transient buffer");
+
+			glDeleteBuffers(1, &buffer);
+
+			return false;
+		}
+
+		context.api.opengl.transientBuffer = buffer;
+		context.api.opengl.transient = mapped;
+
+		return true;
+	}
+
+	bool CreateDeviceAndContext(const bool debug, const bool headless, const bool vertexPulling, const char* programCache, const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context)
 	{
 		auto winptr = static_cast<GLFWwindow*>(window.winptr);
 	
@@ -126,12 +265,89 @@ namespace cg::renderer::OpenGL
 		}
 
 		context.api.opengl.window = window.winptr;
+		context.api.opengl.stateCache = {};
+		context.device = &device;
+
+		if (headless && !CreateOffscreenFramebuffer(window.width, window.height, context))
+		{
+			return false;
+		}
+
+		if (!CreateTransientBuffer(context))
+		{
+			return false;
+		}
+
+		GLint constantAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &constantAlignment);
+
+		if (constantAlignment > 0)
+		{
+			device.deviceInfo.constantAlignment = static_cast<uint32_t>(constantAlignment);
+		}
+
+		GLint storageAlignment = 0;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+
+		if (storageAlignment > 0)
+		{
+			device.deviceInfo.storageAlignment = static_cast<uint32_t>(storageAlignment);
+		}
+
+		if (vertexPulling && !CreatePullingResources(context))
+		{
+			return false;
+		}
+
+		// Let the driver pick its compiler thread count, GL_COMPLETION_STATUS_KHR is queryable either way
+		context.api.opengl.parallelCompile = false;
+
+		if (GLAD_GL_KHR_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+			context.api.opengl.parallelCompile = true;
+		}
+		else if (GLAD_GL_ARB_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+			context.api.opengl.parallelCompile = true;
+		}
 
 		//const char* vendor = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
 		device.deviceInfo.adapterName = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
 		const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
 		const char* shaderVersion = reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION));
 
+		// Binaries are only valid for the driver that produced them, its version string is part of every key
+		context.api.opengl.driverHash = CG_HASH_SEED;
+
+		if (device.deviceInfo.adapterName)
+		{
+			context.api.opengl.driverHash = HashBytes(device.deviceInfo.adapterName, strlen(device.deviceInfo.adapterName), context.api.opengl.driverHash);
+		}
+
+		if (version)
+		{
+			context.api.opengl.driverHash = HashBytes(version, strlen(version), context.api.opengl.driverHash);
+		}
+
+		GLint binaryFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+
+		context.api.opengl.programCache = nullptr;
+
+		if (programCache && binaryFormats > 0)
+		{
+			if (io::MakeDirectory(programCache))
+			{
+				context.api.opengl.programCache = programCache;
+			}
+			else
+			{
+				printf("Program cache directory %s is not usable, programs are always compiled\n", programCache);
+			}
+		}
+
 		printf("OpenGL Context Info:\n\n");
 		printf("  Debug: %s\n", device.debug ? "True" : "False");
 		printf("  Physical Adapter: %s\n", device.deviceInfo.adapterName);
@@ -208,315 +424,2345 @@ namespace cg::renderer::OpenGL
 			return true;
 		}
 
-		bool CreateShader(const CGShaderDesc& desc, CGShader& shader)
-		{				
-			io::CGFile shaderFile = io::ReadFile(desc.filename);
-			char* shaderSource = shaderFile.data.get();
+		static_assert(CG_PULL_VERTEX_BINDING == 0u && CG_PULL_LAYOUT_BINDING == 1u, "The vertex pulling prelude hardcodes its bindings");
 
-			uint32_t& _shader = shader.api.opengl.shader;
-			
-			_shader = glCreateShader(GetShaderType(shader.type));
-			glShaderSource(_shader, 1, &shaderSource, nullptr);
-			glCompileShader(_shader);
-			
-			
-			if (!CheckShaderCompileErrors(_shader, shader.type))
+		// Prepended to vertex shaders in vertex pulling mode, right after their #version line. Attributes are
+		// read with CGFetchAttribute(element) instead of vertex inputs, elements keep their vertex array locations.
+		static constexpr const char* PULLING_PRELUDE = R"(
+layout(std430, binding = 0) readonly buffer CGVertexData
+{
+	uint cgVertexWords[];
+};
+
+struct CGVertexElementDesc
+{
+	uint offset;
+	uint components;
+	uint type;
+	uint padding;
+};
+
+layout(std430, binding = 1) readonly buffer CGVertexLayoutDesc
+{
+	uint cgVertexStride;
+	uint cgVertexElementCount;
+	uvec2 cgVertexPadding;
+	CGVertexElementDesc cgVertexElements[];
+};
+
+// Unsigned integers are converted to float, like a vertex array without normalization does
+vec4 CGFetchAttribute(const uint element)
+{
+	vec4 value = vec4(0.0, 0.0, 0.0, 1.0);
+
+	if (element >= cgVertexElementCount)
+	{
+		return value;
+	}
+
+	const CGVertexElementDesc desc = cgVertexElements[element];
+	const uint word = (uint(gl_VertexID) * cgVertexStride + desc.offset) >> 2u;
+
+	for (uint i = 0u; i < desc.components; ++i)
+	{
+		const uint bits = cgVertexWords[word + i];
+		value[i] = desc.type == 1u ? float(bits) : uintBitsToFloat(bits);
+	}
+
+	return value;
+}
+)";
+
+		static constexpr uint32_t SHADER_PATH_SIZE = CG_MAX_SHADER_PATH;
+
+		// Files of one expansion, their index is the source string number of their #line directives
+		struct ShaderExpansion
+		{
+			CGLinearArena source;
+			char files[CG_MAX_SHADER_INCLUDES][SHADER_PATH_SIZE] = {};
+			uint8_t fileCount = 0u;
+		};
+
+		static bool AppendText(const char* text, const size_t size, CGLinearArena& arena)
+		{
+			void* memory = ArenaOps::Allocate(size, arena);
+
+			if (!memory)
 			{
-				glDeleteShader(_shader);
 				return false;
 			}
 
+			memcpy(memory, text, size);
+
 			return true;
 		}
 
-		bool CreateShaderProgram(const uint8_t shaderCount, const CGShader shaders[], uint32_t& program)
+		static bool AppendLineDirective(const uint32_t line, const uint8_t file, CGLinearArena& arena)
 		{
-			program = glCreateProgram();
+			char directive[32];
+			const int length = snprintf(directive, sizeof(directive), "#line %u %u\n", line, file);
 
-			// Attach shaders
-			for (uint8_t i = 0u; i < shaderCount; ++i)
+			return AppendText(directive, static_cast<size_t>(length), arena);
+		}
+
+		// Copies the file into the expansion with every #include "file" replaced by the included file.
+		// Includes are resolved relative to the including file and each file is only included once.
+		static bool ExpandShaderFile(const uint8_t file, ShaderExpansion& expansion)
+		{
+			const char* path = expansion.files[file];
+			io::CGFile shaderFile = io::ReadFile(path);
+
+			if (!shaderFile.data)
 			{
-				const uint32_t shader = shaders[i].api.opengl.shader;
-				glAttachShader(program, shader);
+				printf("Failed to read shader %s\n", path);
+				return false;
 			}
 
-			glLinkProgram(program);
+			const char* cursor = shaderFile.data.get();
+			const char* end = cursor + shaderFile.size;
 
-			const auto DeleteShaders = [shaderCount, &shaders, program]()
+			for (uint32_t line = 1u; cursor < end; ++line)
 			{
-				for (uint8_t i = 0u; i < shaderCount; ++i)
+				const char* newline = static_cast<const char*>(memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+				const char* next = newline ? newline + 1 : end;
+
+				const char* directive = cursor;
+
+				while (directive < next && (*directive == ' ' || *directive == '\t'))
 				{
-					const uint32_t shader = shaders[i].api.opengl.shader;
+					directive++;
+				}
 
-					glDetachShader(program, shader);
-					glDeleteShader(shader);
+				if (next - directive < 8 || strncmp(directive, "#include", 8) != 0)
+				{
+					if (!AppendText(cursor, static_cast<size_t>(next - cursor), expansion.source))
+					{
+						return false;
+					}
+
+					cursor = next;
+					continue;
 				}
-			};
 
-			if (!CheckShaderCompileErrors(program, CGShaderType::Program))
-			{
-				DeleteShaders();
-				glDeleteProgram(program);
+				const char* open = static_cast<const char*>(memchr(directive, '"', static_cast<size_t>(next - directive)));
+				const char* close = open ? static_cast<const char*>(memchr(open + 1, '"', static_cast<size_t>(next - open - 1))) : nullptr;
 
-				return false;
-			}
+				if (!close)
+				{
+					printf("Malformed #include in %s(%u)\n", path, line);
+					return false;
+				}
 
-			DeleteShaders();
+				const char* slash = strrchr(path, '/');
+				const size_t directoryLength = slash ? static_cast<size_t>(slash - path + 1) : 0u;
+				const size_t nameLength = static_cast<size_t>(close - open - 1);
 
-			return true;
-		}
+				char included[SHADER_PATH_SIZE];
 
-		bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData)
-		{
-			uint32_t& buffer = vBuffer.api.opengl.buffer;
+				if (directoryLength + nameLength >= SHADER_PATH_SIZE)
+				{
+					printf("Include path too long in %s(%u)\n", path, line);
+					return false;
+				}
 
-			glCreateBuffers(1, &buffer);
+				memcpy(included, path, directoryLength);
+				memcpy(included + directoryLength, open + 1, nameLength);
+				included[directoryLength + nameLength] = '\0';
 
-			if (buffer == 0)
-			{
-				return false;
+				bool expanded = false;
+
+				for (uint8_t i = 0u; i < expansion.fileCount; ++i)
+				{
+					expanded |= strcmp(expansion.files[i], included) == 0;
+				}
+
+				// Files included before leave an empty line, the lines after it keep their numbers
+				if (expanded)
+				{
+					if (!AppendText("\n", 1u, expansion.source))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					if (expansion.fileCount >= CG_MAX_SHADER_INCLUDES)
+					{
+						printf("Too many includes in %s(%u)\n", path, line);
+						return false;
+					}
+
+					const uint8_t includedFile = expansion.fileCount;
+					memcpy(expansion.files[includedFile], included, directoryLength + nameLength + 1u);
+					expansion.fileCount++;
+
+					if (!AppendLineDirective(1u, includedFile, expansion.source) || !ExpandShaderFile(includedFile, expansion))
+					{
+						return false;
+					}
+
+					if (!AppendLineDirective(line + 1u, file, expansion.source))
+					{
+						return false;
+					}
+				}
+
+				cursor = next;
 			}
 
-			glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(vbDesc.size), vbData, 0u);
-			
-			if (glGetError() != GL_NO_ERROR)
+			// The next line directive has to start on a line of its own
+			if (shaderFile.size > 0u && end[-1] != '\n')
 			{
-				glDeleteBuffers(1, &buffer);
-				return false;
+				return AppendText("\n", 1u, expansion.source);
 			}
 
 			return true;
 		}
 
-		bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData)
+		// Preprocesses the source and creates the shader, or shares the one of a variant with the same source.
+		// Nothing is compiled here. Retained shaders outlive the call, their variant is never replaced.
+		static bool LoadShaderSource(const CGRenderContext& context, CGShaderPool& shaderPool, const CGShaderDesc& desc, const bool retained, CGShader& shader)
 		{
-			uint32_t& buffer = iBuffer.api.opengl.buffer;
-
-			glCreateBuffers(1, &buffer);
+			const bool undefinedBits = desc.defineCount < CG_MAX_SHADER_DEFINES && (desc.variant >> desc.defineCount) != 0u;
 
-			if (buffer == 0u)
+			if (desc.variant != 0u && (desc.defines == nullptr || desc.defineCount > CG_MAX_SHADER_DEFINES || undefinedBits))
 			{
+				printf("Variant %x of shader %s has no define for some of its bits\n", desc.variant, desc.filename);
 				return false;
 			}
 
-			glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(ibDesc.size), ibData, 0u);
+			ShaderExpansion expansion = {};
+			const size_t pathLength = desc.filename ? strlen(desc.filename) : SHADER_PATH_SIZE;
 
-			if (glGetError() != GL_NO_ERROR)
+			if (pathLength >= SHADER_PATH_SIZE)
 			{
-				glDeleteBuffers(1, &buffer);
+				printf("Shader path too long\n");
 				return false;
 			}
 
-			return true;
-		}
+			memcpy(expansion.files[0], desc.filename, pathLength + 1u);
+			expansion.fileCount = 1u;
 
-		static constexpr GLint GetAttributeCount(const CGVertexFormat format)
-		{
-			switch (format)
+			if (!ExpandShaderFile(0u, expansion) || !AppendText("", 1u, expansion.source))
 			{
-				case CGVertexFormat::None:   return -1;
-				case CGVertexFormat::UInt:   return 1;
-				case CGVertexFormat::UInt2:  return 2;
-				case CGVertexFormat::UInt3:  return 3;
-				case CGVertexFormat::UInt4:  return 4;
-				case CGVertexFormat::Float:  return 1;
-				case CGVertexFormat::Float2: return 2;
-				case CGVertexFormat::Float3: return 3;
-				case CGVertexFormat::Float4: return 4;
+				return false;
 			}
 
-			return -1;
-		}
+			// Defines and the vertex pulling prelude go after the #version line, which has to stay first
+			const char* shaderSource = reinterpret_cast<const char*>(expansion.source.data.get());
+			const char* version = strstr(shaderSource, "#version");
+			const char* body = version ? strchr(version, '\n') : nullptr;
+			body = body ? body + 1 : shaderSource;
 
-		static constexpr GLenum GetAttributeType(const CGVertexFormat format)
-		{
-			switch (format)
+			CGLinearArena injected = {};
+
+			for (uint8_t i = 0u; i < desc.defineCount; ++i)
 			{
-				case CGVertexFormat::None:   return ~0u;
-				case CGVertexFormat::UInt:
-				case CGVertexFormat::UInt2:
-				case CGVertexFormat::UInt3:
-				case CGVertexFormat::UInt4:  return GL_UNSIGNED_INT;
-				case CGVertexFormat::Float:
-				case CGVertexFormat::Float2:
-				case CGVertexFormat::Float3:
-				case CGVertexFormat::Float4: return GL_FLOAT;
-			}
-		
-			return ~0u;
-		}
+				if ((desc.variant & (1u << i)) == 0u)
+				{
+					continue;
+				}
 
-		bool CreateVertexArray(const CGBuffer& vBuffer, CGVertexLayout& vLayout)
-		{
-			uint32_t& vao = vLayout.api.opengl.vao;
+				const char* define = "#define ";
 
-			glCreateVertexArrays(1, &vao);
+				if (!AppendText(define, strlen(define), injected) || !AppendText(desc.defines[i], strlen(desc.defines[i]), injected) || !AppendText(" 1\n", 3u, injected))
+				{
+					return false;
+				}
+			}
 
-			if (vao == 0u)
+			if (context.api.opengl.pullingArray && shader.type == CGShaderType::Vertex && !AppendText(PULLING_PRELUDE, strlen(PULLING_PRELUDE), injected))
 			{
 				return false;
 			}
 
-			const uint32_t vbo = vBuffer.api.opengl.buffer;
-
-			if (vbo == 0u)
+			if (injected.size > 0u && !AppendLineDirective(2u, 0u, injected))
 			{
-				glDeleteVertexArrays(1, &vao);
 				return false;
 			}
 
-			glVertexArrayVertexBuffer(vao, 0u, vbo, static_cast<GLintptr>(0), static_cast<GLsizei>(vBuffer.desc.stride));
+			// The expansion ends with a terminator for strstr, the compiler does not get it
+			const size_t headerSize = static_cast<size_t>(body - shaderSource);
+			const size_t bodySize = expansion.source.size - 1u - headerSize;
 
-			for (uint8_t i = 0u; i < vLayout.count; ++i)
+			const char* sources[3] = { shaderSource, injected.size > 0u ? reinterpret_cast<const char*>(injected.data.get()) : "", body };
+			const GLint lengths[3] = { static_cast<GLint>(headerSize), static_cast<GLint>(injected.size), static_cast<GLint>(bodySize) };
+
+			uint64_t& sourceHash = shader.api.opengl.sourceHash;
+			sourceHash = HashBytes(&shader.type, sizeof(shader.type), CG_HASH_SEED);
+
+			for (uint8_t i = 0u; i < 3u; ++i)
 			{
-				const CGVertexElement& element = vLayout.elements[i];
-				const CGVertexFormat format = element.format;
+				sourceHash = lengths[i] > 0 ? HashBytes(sources[i], static_cast<size_t>(lengths[i]), sourceHash) : sourceHash;
+			}
 
-				glEnableVertexArrayAttrib(vao, i);
-				glVertexArrayAttribFormat(vao, i, GetAttributeCount(format), GetAttributeType(format), GL_FALSE, element.offset);
-				glVertexArrayAttribBinding(vao, i, 0);
+			// The hash alone could let two different sources share a shader
+			for (uint32_t i = 0u; i < shaderPool.svCount; ++i)
+			{
+				const CGShaderVariant& variant = shaderPool.variants[i];
 
-				if (glGetError() != GL_NO_ERROR)
+				if (variant.hash == sourceHash && variant.variant == desc.variant && strcmp(variant.filename, desc.filename) == 0)
 				{
-					glDeleteVertexArrays(1, &vao);
+					shaderPool.variants[i].retained |= retained;
+					shader.api.opengl.shader = shaderPool.variants[i].shader;
+					shader.api.opengl.variantSlot = i + 1u;
+					return true;
+				}
+			}
+
+			uint32_t& _shader = shader.api.opengl.shader;
+			_shader = glCreateShader(GetShaderType(shader.type));
+
+			glShaderSource(_shader, 3, sources, lengths);
+
+			// A file that changed replaces its previous variant, so hot reloads do not fill up the cache
+			uint32_t slot = shaderPool.svCount;
+
+			for (uint32_t i = 0u; i < shaderPool.svCount; ++i)
+			{
+				const CGShaderVariant& variant = shaderPool.variants[i];
+
+				if (!variant.retained && variant.type == shader.type && variant.variant == desc.variant && strcmp(variant.filename, desc.filename) == 0)
+				{
+					// Only programs still being linked hold it, the driver deletes it once they detach it
+					glDeleteShader(variant.shader);
+					slot = i;
+					break;
+				}
+			}
+
+			// Shaders that do not fit into the cache are deleted once their program is linked
+			shader.api.opengl.variantSlot = 0u;
+
+			if (slot < CG_MAX_SHADER_VARIANTS)
+			{
+				CGShaderVariant& variant = shaderPool.variants[slot];
+				memcpy(variant.filename, desc.filename, pathLength + 1u);
+				variant.hash = sourceHash;
+				variant.variant = desc.variant;
+				variant.shader = _shader;
+				variant.type = shader.type;
+				variant.compiled = false;
+				variant.retained = retained;
+
+				shaderPool.svCount = slot < shaderPool.svCount ? shaderPool.svCount : slot + 1u;
+				shader.api.opengl.variantSlot = slot + 1u;
+			}
+
+			return true;
+		}
+
+		// Issues the compile without waiting for it, unless the variant already compiled successfully
+		static void CompileShader(const CGShaderPool& shaderPool, const CGShader& shader)
+		{
+			const uint32_t slot = shader.api.opengl.variantSlot;
+
+			if (slot != 0u && shaderPool.variants[slot - 1u].compiled)
+			{
+				return;
+			}
+
+			glCompileShader(shader.api.opengl.shader);
+		}
+
+		// Waits for the compile, a variant that failed is compiled again by the next shader that uses it
+		static bool CheckShaderCompiled(CGShaderPool& shaderPool, const CGShader& shader)
+		{
+			const uint32_t slot = shader.api.opengl.variantSlot;
+
+			if (slot != 0u && shaderPool.variants[slot - 1u].compiled)
+			{
+				return true;
+			}
+
+			if (!CheckShaderCompileErrors(shader.api.opengl.shader, shader.type))
+			{
+				return false;
+			}
+
+			if (slot != 0u)
+			{
+				shaderPool.variants[slot - 1u].compiled = true;
+			}
+
+			return true;
+		}
+
+		bool CreateShader(const CGRenderContext& context, CGShaderPool& shaderPool, const CGShaderDesc& desc, CGShader& shader)
+		{
+			if (!LoadShaderSource(context, shaderPool, desc, true, shader))
+			{
+				return false;
+			}
+
+			uint32_t& _shader = shader.api.opengl.shader;
+
+			// Compiled on a cache miss only, a cached program never needs its shaders
+			if (context.api.opengl.programCache)
+			{
+				return true;
+			}
+
+			CompileShader(shaderPool, shader);
+
+			if (!CheckShaderCompiled(shaderPool, shader))
+			{
+				if (shader.api.opengl.variantSlot == 0u)
+				{
+					glDeleteShader(_shader);
+				}
+
+				return false;
+			}
+
+			return true;
+		}
+
+		// Cache entries start with this header, anything that does not match it is recompiled and overwritten
+		struct ProgramBinaryHeader
+		{
+			uint32_t magic = 0u;
+			uint32_t format = 0u; // GLenum of the binary
+			uint64_t key = 0ull;
+			uint64_t driverHash = 0ull;
+			uint32_t size = 0u;
+			uint32_t padding = 0u;
+		};
+
+		static constexpr uint32_t PROGRAM_BINARY_MAGIC = 0x42504743u; // "CGPB"
+
+		static void GetProgramBinaryPath(const CGRenderContext& context, const uint64_t key, char (&path)[512])
+		{
+			snprintf(path, sizeof(path), "%s/%016llx.bin", context.api.opengl.programCache, static_cast<unsigned long long>(key));
+		}
+
+		static bool LoadProgramBinary(const CGRenderContext& context, const uint64_t key, const uint32_t program)
+		{
+			char path[512];
+			GetProgramBinaryPath(context, key, path);
+
+			const io::CGFile file = io::ReadFile(path);
+
+			if (!file.data || file.size < sizeof(ProgramBinaryHeader))
+			{
+				return false;
+			}
+
+			ProgramBinaryHeader header = {};
+			memcpy(&header, file.data.get(), sizeof(header));
+
+			if (header.magic != PROGRAM_BINARY_MAGIC || header.key != key || header.driverHash != context.api.opengl.driverHash || header.size != file.size - sizeof(header))
+			{
+				return false;
+			}
+
+			glProgramBinary(program, header.format, file.data.get() + sizeof(header), static_cast<GLsizei>(header.size));
+
+			// Drivers reject binaries they no longer accept, even with a matching version string
+			GLint success = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+			return success == GL_TRUE;
+		}
+
+		static void SaveProgramBinary(const CGRenderContext& context, const uint64_t key, const uint32_t program)
+		{
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+			if (length < 1)
+			{
+				return;
+			}
+
+			auto data = std::make_unique<uint8_t[]>(sizeof(ProgramBinaryHeader) + static_cast<size_t>(length));
+
+			ProgramBinaryHeader header = {};
+			GLsizei written = 0;
+			GLenum format = 0u;
+
+			glGetProgramBinary(program, length, &written, &format, data.get() + sizeof(header));
+
+			if (written < 1)
+			{
+				return;
+			}
+
+			header.magic = PROGRAM_BINARY_MAGIC;
+			header.format = format;
+			header.key = key;
+			header.driverHash = context.api.opengl.driverHash;
+			header.size = static_cast<uint32_t>(written);
+
+			memcpy(data.get(), &header, sizeof(header));
+
+			char path[512];
+			GetProgramBinaryPath(context, key, path);
+
+			if (!io::WriteFile(path, data.get(), sizeof(header) + static_cast<size_t>(written)))
+			{
+				printf("Failed to write program binary %s\n", path);
+			}
+		}
+
+		static uint64_t GetProgramKey(const CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[])
+		{
+			uint64_t key = context.api.opengl.driverHash;
+
+			for (uint8_t i = 0u; i < shaderCount; ++i)
+			{
+				key = HashBytes(&shaders[i].api.opengl.sourceHash, sizeof(uint64_t), key);
+			}
+
+			return key;
+		}
+
+		static void DeleteProgramShaders(const uint8_t shaderCount, const CGShader shaders[], const uint32_t program, const bool attached)
+		{
+			for (uint8_t i = 0u; i < shaderCount; ++i)
+			{
+				const uint32_t shader = shaders[i].api.opengl.shader;
+
+				if (attached)
+				{
+					glDetachShader(program, shader);
+				}
+
+				// Cached variants stay around for the next program that uses them
+				if (shaders[i].api.opengl.variantSlot == 0u)
+				{
+					glDeleteShader(shader);
+				}
+			}
+		}
+
+		bool CreateShaderProgram(const CGRenderContext& context, CGShaderPool& shaderPool, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program)
+		{
+			program = glCreateProgram();
+
+			const bool cached = context.api.opengl.programCache != nullptr;
+			const uint64_t key = GetProgramKey(context, shaderCount, shaders);
+
+			const auto DeleteShaders = [shaderCount, &shaders, program](const bool attached)
+			{
+				DeleteProgramShaders(shaderCount, shaders, program, attached);
+			};
+
+			if (cached && LoadProgramBinary(context, key, program))
+			{
+				DeleteShaders(false);
+				return true;
+			}
+
+			// Shaders of a cached renderer were never compiled
+			for (uint8_t i = 0u; cached && i < shaderCount; ++i)
+			{
+				CompileShader(shaderPool, shaders[i]);
+
+				if (!CheckShaderCompiled(shaderPool, shaders[i]))
+				{
+					DeleteShaders(false);
+					glDeleteProgram(program);
+
+					return false;
+				}
+			}
+
+			// Attach shaders
+			for (uint8_t i = 0u; i < shaderCount; ++i)
+			{
+				const uint32_t shader = shaders[i].api.opengl.shader;
+				glAttachShader(program, shader);
+			}
+
+			if (cached)
+			{
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+
+			glLinkProgram(program);
+
+			if (!CheckShaderCompileErrors(program, CGShaderType::Program))
+			{
+				DeleteShaders(true);
+				glDeleteProgram(program);
+
+				return false;
+			}
+
+			DeleteShaders(true);
+
+			if (cached)
+			{
+				SaveProgramBinary(context, key, program);
+			}
+
+			return true;
+		}
+
+		// Nothing here waits on the driver: compile and link are only issued, errors are checked by PollShaderProgram
+		bool SubmitShaderProgram(const CGRenderContext& context, CGShaderPool& shaderPool, const uint8_t count, const CGShaderDesc descs[], CGPendingProgram& pending)
+		{
+			pending.shaderCount = 0u;
+
+			for (uint8_t i = 0u; i < count; ++i)
+			{
+				CGShader& shader = pending.shaders[i];
+				shader.type = descs[i].shaderType;
+
+				if (!LoadShaderSource(context, shaderPool, descs[i], false, shader))
+				{
+					DeleteProgramShaders(pending.shaderCount, pending.shaders, 0u, false);
+					return false;
+				}
+
+				pending.shaderCount++;
+			}
+
+			const uint32_t program = glCreateProgram();
+			const bool cached = context.api.opengl.programCache != nullptr;
+
+			pending.program = program;
+			pending.key = GetProgramKey(context, count, pending.shaders);
+
+			if (cached && LoadProgramBinary(context, pending.key, program))
+			{
+				DeleteProgramShaders(count, pending.shaders, program, false);
+				pending.status = CGProgramStatus::Ready;
+
+				return true;
+			}
+
+			for (uint8_t i = 0u; i < count; ++i)
+			{
+				CompileShader(shaderPool, pending.shaders[i]);
+			}
+
+			for (uint8_t i = 0u; i < count; ++i)
+			{
+				glAttachShader(program, pending.shaders[i].api.opengl.shader);
+			}
+
+			if (cached)
+			{
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+
+			glLinkProgram(program);
+
+			pending.status = CGProgramStatus::Pending;
+
+			return true;
+		}
+
+		CGProgramStatus PollShaderProgram(const CGRenderContext& context, CGPendingProgram& pending)
+		{
+			if (pending.status != CGProgramStatus::Pending)
+			{
+				return pending.status;
+			}
+
+			const uint32_t program = pending.program;
+
+			if (context.api.opengl.parallelCompile)
+			{
+				// The program completes after all of its shaders, their status does not need to be polled
+				GLint completed = GL_FALSE;
+				glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+
+				if (completed == GL_FALSE)
+				{
+					return CGProgramStatus::Pending;
+				}
+			}
+
+			bool success = true;
+
+			// Compile errors explain a failed link, they are only looked at once the link is done
+			for (uint8_t i = 0u; i < pending.shaderCount; ++i)
+			{
+				success &= CheckShaderCompileErrors(pending.shaders[i].api.opengl.shader, pending.shaders[i].type);
+			}
+
+			success = success && CheckShaderCompileErrors(program, CGShaderType::Program);
+
+			DeleteProgramShaders(pending.shaderCount, pending.shaders, program, true);
+
+			if (!success)
+			{
+				glDeleteProgram(program);
+				pending.status = CGProgramStatus::Failed;
+
+				return pending.status;
+			}
+
+			if (context.api.opengl.programCache)
+			{
+				SaveProgramBinary(context, pending.key, program);
+			}
+
+			pending.status = CGProgramStatus::Ready;
+
+			return pending.status;
+		}
+
+		void ReplaceShaderProgram(CGRenderContext& context, CGShaderPool& shaderPool, const uint32_t program, const uint32_t replacement)
+		{
+			for (uint32_t i = 0u; i < shaderPool.pCount; ++i)
+			{
+				if (shaderPool.programs[i] != program)
+				{
+					continue;
+				}
+
+				// Deleting the handle's program would let glCreateProgram hand its name out again. Frames
+				// in flight may still use an older replacement, the driver keeps it alive until they are done.
+				if (shaderPool.reloaded[i] != 0u)
+				{
+					glDeleteProgram(shaderPool.reloaded[i]);
+				}
+				else
+				{
+					shaderPool.rCount++;
+				}
+
+				shaderPool.reloaded[i] = replacement;
+
+				// Rebinds the handle on its next use, along with the rest of the pipeline holding it
+				if (context.api.opengl.stateCache.program == program)
+				{
+					context.api.opengl.stateCache.program = 0u;
+					context.api.opengl.stateCache.pipeline = 0u;
+				}
+
+				return;
+			}
+
+			glDeleteProgram(replacement);
+		}
+
+		// Dynamic buffers are rings with one segment per frame pool, mapped once for their whole lifetime.
+		// The CPU writes the segment of the frame being recorded while the GPU reads older ones, fences
+		// keep a pool (and with it its segment) from being recorded again before the GPU is done with it.
+		static bool CreateDynamicBuffer(const CGBufferDesc& desc, CGBuffer& cgBuffer, const void* data)
+		{
+			uint32_t& buffer = cgBuffer.api.opengl.buffer;
+
+			glCreateBuffers(1, &buffer);
+
+			if (buffer == 0u)
+			{
+				return false;
+			}
+
+			constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			// Segment offsets stay valid for every binding point, including uniform buffers
+			const uint32_t segmentSize = AlignUp(desc.size, 256u);
+			const GLsizeiptr size = static_cast<GLsizeiptr>(segmentSize) * CG_MAX_FRAME_POOLS;
+
+			glNamedBufferStorage(buffer, size, nullptr, flags);
+
+			void* mapped = glMapNamedBufferRange(buffer, 0, size, flags);
+
+			if (glGetError() != GL_NO_ERROR || !mapped)
+			{
+				glDeleteBuffers(1, &buffer);
+				return false;
+			}
+
+			// Every segment starts out with the initial contents
+			if (data)
+			{
+				for (uint8_t i = 0u; i < CG_MAX_FRAME_POOLS; ++i)
+				{
+					std::memcpy(static_cast<uint8_t*>(mapped) + static_cast<size_t>(segmentSize) * i, data, desc.size);
+				}
+			}
+
+			cgBuffer.api.opengl.segmentSize = segmentSize;
+			cgBuffer.api.opengl.mapped = mapped;
+
+			return true;
+		}
+
+		// Storage of the remaining strategies only differs in how much of it the driver may rewrite later
+		static bool CreateBuffer(const CGBufferDesc& desc, CGBuffer& cgBuffer, const void* data)
+		{
+			const CGUploadStrategy strategy = GetUploadStrategy(desc);
+
+			if (strategy == CGUploadStrategy::PersistentMap)
+			{
+				return CreateDynamicBuffer(desc, cgBuffer, data);
+			}
+
+			uint32_t& buffer = cgBuffer.api.opengl.buffer;
+
+			glCreateBuffers(1, &buffer);
+
+			if (buffer == 0u)
+			{
+				return false;
+			}
+
+			switch (strategy)
+			{
+				case CGUploadStrategy::Default:
+				case CGUploadStrategy::PersistentMap:
+				case CGUploadStrategy::Staging:
+				{
+					// Only written by copies on the GPU
+					glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(desc.size), data, 0u);
+					break;
+				}
+				case CGUploadStrategy::SubData:
+				{
+					glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(desc.size), data, GL_DYNAMIC_STORAGE_BIT);
+					break;
+				}
+				case CGUploadStrategy::Orphan:
+				{
+					// Orphaning re-specifies the store, which immutable storage does not allow
+					glNamedBufferData(buffer, static_cast<GLsizeiptr>(desc.size), data, GL_STREAM_DRAW);
+					break;
+				}
+			}
+
+			if (glGetError() != GL_NO_ERROR)
+			{
+				glDeleteBuffers(1, &buffer);
+				return false;
+			}
+
+			return true;
+		}
+
+		bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData)
+		{
+			return CreateBuffer(vbDesc, vBuffer, vbData);
+		}
+
+		bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData)
+		{
+			return CreateBuffer(ibDesc, iBuffer, ibData);
+		}
+
+		// Bound as uniform buffer ranges, the ring segments of dynamic ones are aligned for that already
+		bool CreateConstantBuffer(const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData)
+		{
+			return CreateBuffer(cbDesc, cBuffer, cbData);
+		}
+
+		// Deleting a persistently mapped buffer unmaps it as well
+		void DestroyBuffer(CGBuffer& buffer)
+		{
+			if (buffer.api.opengl.buffer != 0u)
+			{
+				glDeleteBuffers(1, &buffer.api.opengl.buffer);
+			}
+
+			buffer.api.opengl = {};
+		}
+
+		bool CreateTexture(CGTexture& texture)
+		{
+			const CGTextureDesc& desc = texture.desc;
+			uint32_t& name = texture.api.opengl.texture;
+
+			glCreateTextures(desc.layers > 0u ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, 1, &name);
+
+			if (name == 0u)
+			{
+				return false;
+			}
+
+			if (desc.layers > 0u)
+			{
+				glTextureStorage3D(name, desc.mipCount, GL_RGBA8, static_cast<GLsizei>(desc.width), static_cast<GLsizei>(desc.height), desc.layers);
+			}
+			else
+			{
+				glTextureStorage2D(name, desc.mipCount, GL_RGBA8, static_cast<GLsizei>(desc.width), static_cast<GLsizei>(desc.height));
+
+				// Nothing is sampled from the levels that are not uploaded yet
+				glTextureParameteri(name, GL_TEXTURE_BASE_LEVEL, desc.mipCount - 1);
+			}
+
+			glTextureParameteri(name, GL_TEXTURE_MAX_LEVEL, desc.mipCount - 1);
+
+			if (glGetError() != GL_NO_ERROR)
+			{
+				glDeleteTextures(1, &name);
+				name = 0u;
+				return false;
+			}
+
+			return true;
+		}
+
+		void UploadTextureMip(const uint8_t level, const void* data, CGTexture& texture)
+		{
+			const uint32_t width = texture.desc.width >> level ? texture.desc.width >> level : 1u;
+			const uint32_t height = texture.desc.height >> level ? texture.desc.height >> level : 1u;
+
+			glTextureSubImage2D(texture.api.opengl.texture, level, 0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, data);
+			glTextureParameteri(texture.api.opengl.texture, GL_TEXTURE_BASE_LEVEL, level);
+		}
+
+		void UploadTextureRegion(const CGTextureUpload& upload, const uint8_t level, const void* data, const CGTexture& texture)
+		{
+			const uint32_t width = upload.desc.width >> level ? upload.desc.width >> level : 1u;
+			const uint32_t height = upload.desc.height >> level ? upload.desc.height >> level : 1u;
+
+			glTextureSubImage3D(texture.api.opengl.texture, level, static_cast<GLint>(upload.x >> level), static_cast<GLint>(upload.y >> level), upload.layer,
+				static_cast<GLsizei>(width), static_cast<GLsizei>(height), 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+
+		static constexpr GLenum GetMinFilter(const CGTextureFilter filter, const CGTextureFilter mipFilter)
+		{
+			if (filter == CGTextureFilter::Nearest)
+			{
+				return mipFilter == CGTextureFilter::Nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_LINEAR;
+			}
+
+			return mipFilter == CGTextureFilter::Nearest ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+		}
+
+		static constexpr GLenum GetAddressMode(const CGTextureAddress address)
+		{
+			switch (address)
+			{
+				case CGTextureAddress::Repeat: return GL_REPEAT;
+				case CGTextureAddress::Clamp:  return GL_CLAMP_TO_EDGE;
+				case CGTextureAddress::Mirror: return GL_MIRRORED_REPEAT;
+			}
+
+			return GL_REPEAT;
+		}
+
+		bool CreateSampler(CGSampler& sampler)
+		{
+			const CGSamplerDesc& desc = sampler.desc;
+			uint32_t& name = sampler.api.opengl.sampler;
+
+			glCreateSamplers(1, &name);
+
+			if (name == 0u)
+			{
+				return false;
+			}
+
+			const GLenum address = GetAddressMode(desc.address);
+
+			glSamplerParameteri(name, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(GetMinFilter(desc.filter, desc.mipFilter)));
+			glSamplerParameteri(name, GL_TEXTURE_MAG_FILTER, desc.filter == CGTextureFilter::Nearest ? GL_NEAREST : GL_LINEAR);
+			glSamplerParameteri(name, GL_TEXTURE_WRAP_S, static_cast<GLint>(address));
+			glSamplerParameteri(name, GL_TEXTURE_WRAP_T, static_cast<GLint>(address));
+
+			if (desc.maxAnisotropy > 1u)
+			{
+				glSamplerParameterf(name, GL_TEXTURE_MAX_ANISOTROPY, static_cast<float>(desc.maxAnisotropy));
+			}
+
+			if (glGetError() != GL_NO_ERROR)
+			{
+				glDeleteSamplers(1, &name);
+				name = 0u;
+				return false;
+			}
+
+			return true;
+		}
+
+		static constexpr GLint GetAttributeCount(const CGVertexFormat format)
+		{
+			switch (format)
+			{
+				case CGVertexFormat::None:   return -1;
+				case CGVertexFormat::UInt:   return 1;
+				case CGVertexFormat::UInt2:  return 2;
+				case CGVertexFormat::UInt3:  return 3;
+				case CGVertexFormat::UInt4:  return 4;
+				case CGVertexFormat::Float:  return 1;
+				case CGVertexFormat::Float2: return 2;
+				case CGVertexFormat::Float3: return 3;
+				case CGVertexFormat::Float4: return 4;
+			}
+
+			return -1;
+		}
+
+		static constexpr GLenum GetAttributeType(const CGVertexFormat format)
+		{
+			switch (format)
+			{
+				case CGVertexFormat::None:   return ~0u;
+				case CGVertexFormat::UInt:
+				case CGVertexFormat::UInt2:
+				case CGVertexFormat::UInt3:
+				case CGVertexFormat::UInt4:  return GL_UNSIGNED_INT;
+				case CGVertexFormat::Float:
+				case CGVertexFormat::Float2:
+				case CGVertexFormat::Float3:
+				case CGVertexFormat::Float4: return GL_FLOAT;
+			}
+		
+			return ~0u;
+		}
+
+		// Vertex pulling reads the same layout from a storage buffer, written once per layout
+		static bool WriteLayoutDescriptor(const CGRenderContext& context, const CGBuffer& vBuffer, const uint32_t layout, const CGVertexLayout& vLayout)
+		{
+			if (layout >= CG_MAX_VERTEX_LAYOUTS || vLayout.count > CG_MAX_VERTEX_ELEMENTS)
+			{
+				return false;
+			}
+
+			PullLayout descriptor = {};
+			descriptor.stride = vBuffer.desc.stride;
+			descriptor.count = vLayout.count;
+
+			for (uint8_t i = 0u; i < vLayout.count; ++i)
+			{
+				const CGVertexElement& element = vLayout.elements[i];
+
+				descriptor.elements[i].offset = element.offset;
+				descriptor.elements[i].components = static_cast<uint32_t>(GetAttributeCount(element.format));
+				descriptor.elements[i].type = GetAttributeType(element.format) == GL_UNSIGNED_INT ? 1u : 0u;
+			}
+
+			const GLintptr offset = static_cast<GLintptr>(GetLayoutDescriptorStride(context)) * layout;
+			glNamedBufferSubData(context.api.opengl.layoutBuffer, offset, static_cast<GLsizeiptr>(sizeof(descriptor)), &descriptor);
+
+			return glGetError() == GL_NO_ERROR;
+		}
+
+		static bool HasSameElements(const CGVertexLayout& a, const CGVertexLayout& b)
+		{
+			if (a.hash != b.hash || a.count != b.count)
+			{
+				return false;
+			}
+
+			for (uint32_t i = 0u; i < a.count; ++i)
+			{
+				const CGVertexElement& elementA = a.elements[i];
+				const CGVertexElement& elementB = b.elements[i];
+
+				if (elementA.attribute != elementB.attribute || elementA.format != elementB.format || elementA.offset != elementB.offset)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool CreateVertexArray(const CGRenderContext& context, const CGBufferPool& bufferPool, const CGBuffer& vBuffer, const uint32_t layout, CGVertexLayout& vLayout)
+		{
+			uint32_t& vao = vLayout.api.opengl.vao;
+
+			if (context.api.opengl.pullingArray)
+			{
+				vao = 0u;
+				return WriteLayoutDescriptor(context, vBuffer, layout, vLayout);
+			}
+
+			// One vertex array per format, buffers are swapped on its binding point when bound
+			for (uint32_t i = 0u; i < bufferPool.vlCount; ++i)
+			{
+				const CGVertexLayout& existing = bufferPool.vertexLayouts[i];
+
+				if (existing.api.opengl.vao != 0u && HasSameElements(existing, vLayout))
+				{
+					vao = existing.api.opengl.vao;
+					return true;
+				}
+			}
+
+			glCreateVertexArrays(1, &vao);
+
+			if (vao == 0u)
+			{
+				return false;
+			}
+
+			const uint32_t vbo = vBuffer.api.opengl.buffer;
+
+			if (vbo == 0u)
+			{
+				glDeleteVertexArrays(1, &vao);
+				return false;
+			}
+
+			glVertexArrayVertexBuffer(vao, 0u, vbo, static_cast<GLintptr>(0), static_cast<GLsizei>(vBuffer.desc.stride));
+
+			for (uint8_t i = 0u; i < vLayout.count; ++i)
+			{
+				const CGVertexElement& element = vLayout.elements[i];
+				const CGVertexFormat format = element.format;
+
+				glEnableVertexArrayAttrib(vao, i);
+				glVertexArrayAttribFormat(vao, i, GetAttributeCount(format), GetAttributeType(format), GL_FALSE, element.offset);
+				glVertexArrayAttribBinding(vao, i, 0);
+
+				if (glGetError() != GL_NO_ERROR)
+				{
+					glDeleteVertexArrays(1, &vao);
 					return false;
 				}
 			}
 
 			return true;
 		}
-	}
 
-	namespace RenderOps
-	{
-		static void Draw(const uint32_t start, const uint32_t count);
-	}
+		void* GetWritePointer(const CGBuffer& buffer, const uint8_t pool)
+		{
+			if (!buffer.api.opengl.mapped || pool >= CG_MAX_FRAME_POOLS)
+			{
+				return nullptr;
+			}
+
+			return static_cast<uint8_t*>(buffer.api.opengl.mapped) + static_cast<size_t>(buffer.api.opengl.segmentSize) * pool;
+		}
+
+		// Staging memory is a ring like the dynamic buffers, the fence of a frame pool guards its segment as well
+		static void* GetStagingSegment(CGRenderContext& context, const uint8_t pool)
+		{
+			uint32_t& buffer = context.api.opengl.stagingBuffer;
+
+			if (buffer == 0u)
+			{
+				constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				constexpr GLsizeiptr size = static_cast<GLsizeiptr>(CG_UPLOAD_STAGING_SIZE) * CG_MAX_FRAME_POOLS;
+
+				glCreateBuffers(1, &buffer);
+				glNamedBufferStorage(buffer, size, nullptr, flags);
+
+				context.api.opengl.staging = glMapNamedBufferRange(buffer, 0, size, flags);
+
+				if (glGetError() != GL_NO_ERROR || !context.api.opengl.staging)
+				{
+					printf("Failed to create the staging buffer\n");
+
+					glDeleteBuffers(1, &buffer);
+					buffer = 0u;
+					context.api.opengl.staging = nullptr;
+
+					return nullptr;
+				}
+			}
+
+			return static_cast<uint8_t*>(context.api.opengl.staging) + static_cast<size_t>(CG_UPLOAD_STAGING_SIZE) * pool;
+		}
+
+		void* GetTransientMemory(const CGRenderContext& context, const uint8_t pool)
+		{
+			if (!context.api.opengl.transient || pool >= CG_MAX_FRAME_POOLS)
+			{
+				return nullptr;
+			}
+
+			return static_cast<uint8_t*>(context.api.opengl.transient) + static_cast<size_t>(CG_TRANSIENT_SIZE) * pool;
+		}
+
+		void UploadBuffers(CGRenderContext& context, const CGBufferPool& bufferPool, const uint8_t pool, const CGLinearArena& uploads, CGUploadStats stats[])
+		{
+			const uint8_t* records = ArenaOps::GetData<uint8_t>(uploads);
+			uint32_t stagingCursor = 0u;
+
+			for (size_t offset = 0ull; offset < uploads.size;)
+			{
+				const CGBufferUpload& upload = *reinterpret_cast<const CGBufferUpload*>(records + offset);
+				const uint8_t* data = reinterpret_cast<const uint8_t*>(&upload + 1);
+
+				offset += upload.stride;
+
+				if (!upload.committed)
+				{
+					continue;
+				}
+
+				const CGBuffer& cgBuffer = *GetBuffer(upload.type, upload.buffer, bufferPool);
+				const uint32_t buffer = cgBuffer.api.opengl.buffer;
+				const GLintptr dstOffset = static_cast<GLintptr>(upload.offset);
+				const GLsizeiptr size = static_cast<GLsizeiptr>(upload.size);
+
+				const auto start = std::chrono::steady_clock::now();
+
+				switch (upload.strategy)
+				{
+					case CGUploadStrategy::Default:
+					{
+						continue;
+					}
+					case CGUploadStrategy::SubData:
+					{
+						glNamedBufferSubData(buffer, dstOffset, size, data);
+						break;
+					}
+					case CGUploadStrategy::Orphan:
+					{
+						// The whole store is replaced, which is why recording only accepts updates that cover all of it
+						glNamedBufferData(buffer, static_cast<GLsizeiptr>(cgBuffer.desc.size), nullptr, GL_STREAM_DRAW);
+						glNamedBufferSubData(buffer, dstOffset, size, data);
+						break;
+					}
+					case CGUploadStrategy::PersistentMap:
+					{
+						// Recorded by MapBuffer, the segment of the frame is still only read by this frame
+						void* segment = GetWritePointer(cgBuffer, pool);
+
+						if (segment)
+						{
+							std::memcpy(static_cast<uint8_t*>(segment) + upload.offset, data, upload.size);
+						}
+
+						break;
+					}
+					case CGUploadStrategy::Staging:
+					{
+						uint8_t* staging = static_cast<uint8_t*>(GetStagingSegment(context, pool));
+
+						if (staging && stagingCursor + upload.size <= CG_UPLOAD_STAGING_SIZE)
+						{
+							std::memcpy(staging + stagingCursor, data, upload.size);
+
+							const GLintptr srcOffset = static_cast<GLintptr>(CG_UPLOAD_STAGING_SIZE) * pool + stagingCursor;
+							glCopyNamedBufferSubData(context.api.opengl.stagingBuffer, buffer, srcOffset, dstOffset, size);
+
+							stagingCursor = AlignUp(stagingCursor + upload.size, 16u);
+						}
+						else
+						{
+							// The segment is full, a one-off buffer keeps the update ordered with the frame
+							uint32_t temporary = 0u;
+
+							glCreateBuffers(1, &temporary);
+							glNamedBufferStorage(temporary, size, data, 0u);
+							glCopyNamedBufferSubData(temporary, buffer, 0, dstOffset, size);
+							glDeleteBuffers(1, &temporary);
+						}
+
+						break;
+					}
+				}
+
+				const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+				CGUploadStats& strategyStats = stats[static_cast<uint8_t>(upload.strategy)];
+				strategyStats.uploads++;
+				strategyStats.bytes += upload.size;
+
+				if (elapsed > CG_UPLOAD_STALL_NS)
+				{
+					strategyStats.stalls++;
+					strategyStats.stallTime += elapsed;
+				}
+			}
+		}
+	}
+
+	namespace RenderOps
+	{
+		static void Draw(const GLenum mode, const uint32_t start, const uint32_t count);
+		static void DrawIndexed(const GLenum mode, const uint32_t count, const uint32_t offset, const int32_t baseVertex);
+	}
+
+	namespace ContextOps
+	{
+		static constexpr GLbitfield MapClearFlags(const CGClearFlags flags)
+		{
+			GLbitfield glFlags = 0u;
+
+			if (flags & CG_CLEAR_COLOR)
+			{
+				glFlags |= GL_COLOR_BUFFER_BIT;
+			}
+
+			if (flags & CG_CLEAR_DEPTH)
+			{
+				glFlags |= GL_DEPTH_BUFFER_BIT;
+			}
+
+			if (flags & CG_CLEAR_STENCIL)
+			{
+				glFlags |= GL_STENCIL_BUFFER_BIT;
+			}
+
+			return glFlags;
+		}
+
+		static void SetClearColor(CGStateCache& cache, const uint32_t color, const float rgba[4])
+		{
+			if (cache.clearColor == color)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glClearColor(rgba[0], rgba[1], rgba[2], rgba[3]);
+
+			cache.clearColor = color;
+		}
+
+		static void ClearView(CGStateCache& cache, const CGClearFlags flags, const uint32_t color)
+		{
+			const float rgba[4] =
+			{
+				((color >> 24) & 0xFF) * CG_ONE_OVER_255,
+				((color >> 16) & 0xFF) * CG_ONE_OVER_255,
+				((color >> 8) & 0xFF) * CG_ONE_OVER_255,
+				(color & 0xFF) * CG_ONE_OVER_255
+			};
+
+			SetClearColor(cache, color, rgba);
+
+			glClear(MapClearFlags(flags));
+		}
+
+		static void SetViewport(CGStateCache& cache, const CGViewport& viewport)
+		{
+			CGViewport& current = cache.viewport;
+
+			if (current.x == viewport.x && current.y == viewport.y &&
+				current.width == viewport.width && current.height == viewport.height &&
+				current.minDepth == viewport.minDepth && current.maxDepth == viewport.maxDepth)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glViewport(
+				static_cast<GLint>(viewport.x), 
+				static_cast<GLint>(viewport.y), 
+				static_cast<GLsizei>(viewport.width), 
+				static_cast<GLsizei>(viewport.height)
+			);
+			glDepthRangef(viewport.minDepth, viewport.maxDepth);
+
+			current = viewport;
+		}
+
+		static void BindVertexArray(CGStateCache& cache, const uint32_t vertexArray)
+		{
+			if (cache.vertexArray == vertexArray)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glBindVertexArray(vertexArray);
+
+			cache.vertexArray = vertexArray;
+			// The element and vertex buffer bindings are part of the VAO state
+			cache.indexBuffer = 0u;
+			cache.vertexBuffer = 0u;
+		}
+
+		static void BindVertexArrayBuffer(CGStateCache& cache, const uint32_t buffer, const uint32_t offset, const uint32_t stride)
+		{
+			if (cache.vertexArray == 0u)
+			{
+				return;
+			}
+
+			if (cache.vertexBuffer == buffer && cache.vertexOffset == offset && cache.vertexStride == stride)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glVertexArrayVertexBuffer(cache.vertexArray, 0u, buffer, static_cast<GLintptr>(offset), static_cast<GLsizei>(stride));
+
+			cache.vertexBuffer = buffer;
+			cache.vertexOffset = offset;
+			cache.vertexStride = stride;
+		}
+
+		static void BindIndexBuffer(CGStateCache& cache, const uint32_t indexBuffer)
+		{
+			if (cache.vertexArray == 0u)
+			{
+				return;
+			}
+
+			if (cache.indexBuffer == indexBuffer)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glVertexArrayElementBuffer(cache.vertexArray, indexBuffer);
+
+			cache.indexBuffer = indexBuffer;
+		}
+
+		static void BindConstantBuffer(CGStateCache& cache, const uint8_t slot, const uint32_t buffer, const uint32_t offset, const uint32_t size)
+		{
+			CGConstantBinding& bound = cache.constants[slot];
+
+			if (bound.buffer == buffer && bound.offset == offset && bound.size == size)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glBindBufferRange(GL_UNIFORM_BUFFER, slot, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+
+			bound.buffer = buffer;
+			bound.offset = offset;
+			bound.size = size;
+		}
+
+		static void BindTexture(CGStateCache& cache, const uint8_t slot, const uint32_t texture)
+		{
+			if (cache.textures[slot] == texture)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glBindTextureUnit(slot, texture);
+
+			cache.textures[slot] = texture;
+		}
+
+		static void BindSampler(CGStateCache& cache, const uint8_t slot, const uint32_t sampler)
+		{
+			if (cache.samplers[slot] == sampler)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			glBindSampler(slot, sampler);
+
+			cache.samplers[slot] = sampler;
+		}
+
+		// Vertex data and its layout descriptor, the vertex pulling counterpart of binding a vertex array
+		static bool BindVertexStorage(CGRenderContext& context, const uint32_t layout, const uint32_t buffer, const uint32_t offset, const uint32_t size)
+		{
+			CGStateCache& cache = context.api.opengl.stateCache;
+			const uint32_t alignment = context.device->deviceInfo.storageAlignment;
+
+			if (offset % alignment != 0u)
+			{
+				printf("Vertex pulling needs vertex buffer offsets aligned to %u bytes\n", alignment);
+				return false;
+			}
+
+			CGConstantBinding& bound = cache.pulledVertices;
+
+			if (bound.buffer == buffer && bound.offset == offset && bound.size == size)
+			{
+				cache.skippedCalls++;
+			}
+			else
+			{
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CG_PULL_VERTEX_BINDING, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+
+				bound.buffer = buffer;
+				bound.offset = offset;
+				bound.size = size;
+			}
+
+			if (cache.pulledLayout == layout + 1u)
+			{
+				cache.skippedCalls++;
+				return true;
+			}
+
+			const GLintptr descriptor = static_cast<GLintptr>(GetLayoutDescriptorStride(context)) * layout;
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CG_PULL_LAYOUT_BINDING, context.api.opengl.layoutBuffer, descriptor, static_cast<GLsizeiptr>(sizeof(PullLayout)));
+
+			cache.pulledLayout = layout + 1u;
+
+			return true;
+		}
+
+		// The cache holds the handle, a hot reloaded program is bound in its place
+		static void UseProgram(CGStateCache& cache, const CGShaderPool& shaderPool, const uint32_t program)
+		{
+			if (cache.program == program)
+			{
+				cache.skippedCalls++;
+				return;
+			}
 
-	namespace ContextOps
-	{
-		static constexpr GLbitfield MapClearFlags(const CGClearFlags flags)
+			uint32_t bound = program;
+
+			for (uint32_t i = 0u; shaderPool.rCount > 0u && i < shaderPool.pCount; ++i)
+			{
+				if (shaderPool.programs[i] == program && shaderPool.reloaded[i] != 0u)
+				{
+					bound = shaderPool.reloaded[i];
+					break;
+				}
+			}
+
+			glUseProgram(bound);
+
+			cache.program = program;
+		}
+
+		static constexpr GLenum GetPrimitiveMode(const CGPrimitiveTopology topology)
 		{
-			GLbitfield glFlags = 0u;
+			switch (topology)
+			{
+				case CGPrimitiveTopology::TriangleList:	 return GL_TRIANGLES;
+				case CGPrimitiveTopology::TriangleStrip: return GL_TRIANGLE_STRIP;
+				case CGPrimitiveTopology::LineList:		 return GL_LINES;
+				case CGPrimitiveTopology::LineStrip:	 return GL_LINE_STRIP;
+				case CGPrimitiveTopology::PointList:	 return GL_POINTS;
+			}
 
-			if (flags & CG_CLEAR_COLOR)
+			return GL_TRIANGLES;
+		}
+
+		static constexpr GLenum GetCompareFunc(const CGCompareFunc func)
+		{
+			switch (func)
 			{
-				glFlags |= GL_COLOR_BUFFER_BIT;
+				case CGCompareFunc::Never:		  return GL_NEVER;
+				case CGCompareFunc::Less:		  return GL_LESS;
+				case CGCompareFunc::Equal:		  return GL_EQUAL;
+				case CGCompareFunc::LessEqual:	  return GL_LEQUAL;
+				case CGCompareFunc::Greater:	  return GL_GREATER;
+				case CGCompareFunc::NotEqual:	  return GL_NOTEQUAL;
+				case CGCompareFunc::GreaterEqual: return GL_GEQUAL;
+				case CGCompareFunc::Always:		  return GL_ALWAYS;
 			}
 
-			if (flags & CG_CLEAR_DEPTH)
+			return GL_LESS;
+		}
+
+		static void SetBlendState(const CGBlendState& blend)
+		{
+			switch (blend.mode)
 			{
-				glFlags |= GL_DEPTH_BUFFER_BIT;
+				case CGBlendMode::Opaque:
+				{
+					glDisable(GL_BLEND);
+					break;
+				}
+				case CGBlendMode::Alpha:
+				{
+					glEnable(GL_BLEND);
+					glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+					break;
+				}
+				case CGBlendMode::Additive:
+				{
+					glEnable(GL_BLEND);
+					glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ONE, GL_ONE);
+					break;
+				}
+				case CGBlendMode::Premultiplied:
+				{
+					glEnable(GL_BLEND);
+					glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+					break;
+				}
 			}
 
-			if (flags & CG_CLEAR_STENCIL)
+			glColorMask((blend.writeMask & 1u) != 0u, (blend.writeMask & 2u) != 0u, (blend.writeMask & 4u) != 0u, (blend.writeMask & 8u) != 0u);
+		}
+
+		static void SetDepthState(const CGDepthState& depth)
+		{
+			if (depth.test)
 			{
-				glFlags |= GL_STENCIL_BUFFER_BIT;
+				glEnable(GL_DEPTH_TEST);
+				glDepthFunc(GetCompareFunc(depth.func));
+			}
+			else
+			{
+				glDisable(GL_DEPTH_TEST);
 			}
 
-			return glFlags;
+			glDepthMask(depth.write ? GL_TRUE : GL_FALSE);
 		}
 
-		static void ClearView(const CGClearFlags flags, const float r, const float g, const float b, const float a)
+		static void SetRasterState(const CGRasterState& raster)
 		{
-			glClearColor(r, g, b, a);
-			glClear(MapClearFlags(flags));
+			if (raster.cull == CGCullMode::None)
+			{
+				glDisable(GL_CULL_FACE);
+			}
+			else
+			{
+				glEnable(GL_CULL_FACE);
+				glCullFace(raster.cull == CGCullMode::Front ? GL_FRONT : GL_BACK);
+			}
+
+			glFrontFace(raster.frontClockwise ? GL_CW : GL_CCW);
+			glPolygonMode(GL_FRONT_AND_BACK, raster.fill == CGFillMode::Wireframe ? GL_LINE : GL_FILL);
 		}
 
-		static void BindVertexArray(const uint32_t vertexArray)
+		// Only the sub-states that differ from the bound pipeline reach the API. The vertex layout is bound
+		// with the vertex buffer and the topology is handed to the draws.
+		static void SetPipelineState(CGStateCache& cache, const CGResourcePool& resourcePool, const uint32_t pipeline)
 		{
-			glBindVertexArray(vertexArray);
+			if (cache.pipeline == pipeline + 1u)
+			{
+				cache.skippedCalls++;
+				return;
+			}
+
+			const CGPipelinePool& pipelinePool = resourcePool.pipelinePool;
+			const CGPipelineDesc& desc = pipelinePool.pipelines[pipeline].desc;
+			const uint8_t changes = cache.pipeline ? GetPipelineChanges(pipelinePool.pipelines[cache.pipeline - 1u].desc, desc) : static_cast<uint8_t>(CG_PIPELINE_ALL);
+
+			if (changes & CG_PIPELINE_SHADERS)
+			{
+				UseProgram(cache, resourcePool.shaderPool, desc.program);
+			}
+
+			if (changes & CG_PIPELINE_BLEND)
+			{
+				SetBlendState(desc.blend);
+			}
+
+			if (changes & CG_PIPELINE_DEPTH)
+			{
+				SetDepthState(desc.depth);
+			}
+
+			if (changes & CG_PIPELINE_RASTER)
+			{
+				SetRasterState(desc.raster);
+			}
+
+			cache.topology = desc.topology;
+			cache.pipeline = pipeline + 1u;
+		}
+
+		bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport)
+		{
+			viewport.width = static_cast<float>(width);
+			viewport.height = static_cast<float>(height);
+
+			return true;
+		}
+
+		enum class BundleOpType : uint8_t
+		{
+			SetViewport = 0u,
+			Clear = 1u,
+			SetPipelineState = 2u,
+			BindVertexArray = 3u,
+			BindIndexBuffer = 4u,
+			Draw = 5u,
+			BindConstantBuffer = 6u,
+			BindVertexStorage = 7u,
+			BindTexture = 8u,
+			BindSampler = 9u,
+		};
+
+		// Resolved OpenGL operation, everything the replay needs is already in GL terms
+		struct BundleOp
+		{
+			union
+			{
+				CGViewport viewport;
+				struct
+				{
+					float rgba[4];
+					uint32_t color;
+					GLbitfield mask;
+				} clear;
+				uint32_t name; // Pipeline or buffer
+				struct
+				{
+					uint32_t start;
+					uint32_t count;
+				} draw;
+				struct
+				{
+					uint32_t buffer;
+					uint32_t offset;
+					uint32_t size;
+					uint8_t slot;
+				} constants;
+				struct
+				{
+					uint32_t buffer;
+					uint32_t offset;
+					uint32_t segmentSize; // Dynamic buffers move on to the segment of the replaying frame
+					uint32_t size;		  // Stride when bound to a vertex array
+					uint32_t layout;	  // Vertex array in OpenGL terms, or the layout index in vertex pulling mode
+				} vertices;
+				struct
+				{
+					uint32_t name; // Texture index, its storage may only be created after the bundle, or sampler
+					uint8_t slot;
+				} binding;
+			} params = {};
+
+			BundleOpType type = BundleOpType::Draw;
+		};
+
+		void MakeCurrent(const CGRenderContext& context, const bool current)
+		{
+			glfwMakeContextCurrent(current ? static_cast<GLFWwindow*>(context.api.opengl.window) : nullptr);
+
+			// Framebuffer bindings are context state and survive the hand over, rebinding keeps it explicit
+			if (current && context.api.opengl.framebuffer)
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, context.api.opengl.framebuffer);
+			}
+		}
+
+		bool ReadFramebuffer(const CGRenderContext& context, const int32_t width, const int32_t height, void* pixels)
+		{
+			if (!pixels || width < 1 || height < 1)
+			{
+				return false;
+			}
+
+			// Rows are returned bottom-up, like every glReadPixels
+			glNamedFramebufferReadBuffer(context.api.opengl.framebuffer, context.api.opengl.framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, context.api.opengl.framebuffer);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+			return true;
+		}
+
+		void DestroyContext(CGRenderContext& context)
+		{
+			for (void*& fence : context.api.opengl.fences)
+			{
+				if (fence)
+				{
+					glDeleteSync(static_cast<GLsync>(fence));
+					fence = nullptr;
+				}
+			}
+
+			if (context.api.opengl.stagingBuffer)
+			{
+				glDeleteBuffers(1, &context.api.opengl.stagingBuffer);
+
+				context.api.opengl.stagingBuffer = 0u;
+				context.api.opengl.staging = nullptr;
+			}
+
+			if (context.api.opengl.transientBuffer)
+			{
+				glDeleteBuffers(1, &context.api.opengl.transientBuffer);
+
+				context.api.opengl.transientBuffer = 0u;
+				context.api.opengl.transient = nullptr;
+			}
+
+			if (context.api.opengl.pullingArray)
+			{
+				glDeleteVertexArrays(1, &context.api.opengl.pullingArray);
+				glDeleteBuffers(1, &context.api.opengl.layoutBuffer);
+
+				context.api.opengl.pullingArray = 0u;
+				context.api.opengl.layoutBuffer = 0u;
+			}
+
+			if (!context.api.opengl.framebuffer)
+			{
+				return;
+			}
+
+			glDeleteFramebuffers(1, &context.api.opengl.framebuffer);
+			glDeleteRenderbuffers(2, context.api.opengl.renderbuffers);
+
+			context.api.opengl.framebuffer = 0u;
+			context.api.opengl.renderbuffers[0] = 0u;
+			context.api.opengl.renderbuffers[1] = 0u;
 		}
 
-		static void UseProgram(const uint32_t program)
+		// Vertex arrays only hold the format and are shared by equal layouts, the buffer binding is swapped
+		// in whenever it differs. Dynamic segments, offsets and transient memory all resolve here.
+		static bool BindVertexBuffer(CGRenderContext& context, const CGBufferPool& bufferPool, const CGSetVertexBufferCommand& cmd)
 		{
-			glUseProgram(program);
+			const bool transient = cmd.buffer == CG_TRANSIENT_BUFFER;
+			const uint32_t layout = transient ? cmd.layout : cmd.buffer;
+
+			if (layout >= bufferPool.vlCount || layout >= bufferPool.vbCount)
+			{
+				return false;
+			}
+
+			const CGBuffer& vBuffer = bufferPool.vertexBuffers[layout];
+			const uint8_t frame = context.api.opengl.frame;
+
+			uint32_t buffer = vBuffer.api.opengl.buffer;
+			uint32_t offset = vBuffer.api.opengl.segmentSize * frame + cmd.offset;
+			uint32_t size = vBuffer.desc.size - cmd.offset;
+
+			if (transient)
+			{
+				buffer = context.api.opengl.transientBuffer;
+				offset = CG_TRANSIENT_SIZE * frame + cmd.offset;
+				size = CG_TRANSIENT_SIZE - cmd.offset;
+			}
+			else if (cmd.offset >= vBuffer.desc.size)
+			{
+				return false;
+			}
+
+			if (context.api.opengl.pullingArray)
+			{
+				return BindVertexStorage(context, layout, buffer, offset, size);
+			}
+
+			BindVertexArray(context.api.opengl.stateCache, bufferPool.vertexLayouts[layout].api.opengl.vao);
+			BindVertexArrayBuffer(context.api.opengl.stateCache, buffer, offset, vBuffer.desc.stride);
+
+			return true;
 		}
 
-		void ExecuteRenderCommands(const CGRenderContext& context, const CGResourcePool& resourcePool)
+		void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool)
 		{
+			CGStateCache& cache = context.api.opengl.stateCache;
+
 			const CGBufferPool& bufferPool = resourcePool.bufferPool;
 			const CGShaderPool& shaderPool = resourcePool.shaderPool;
 
-			for (uint8_t i = 0u; i < resourcePool.commandPool.count; ++i)
+			// The pool index doubles as the dynamic buffer segment and the fence slot
+			context.api.opengl.frame = static_cast<uint8_t>(&cmdPool - resourcePool.commandPools);
+
+			// Index buffers still need a vertex array in vertex pulling mode
+			if (context.api.opengl.pullingArray)
 			{
-				const CGRenderCommand& cmd = resourcePool.commandPool.commands[i];
+				BindVertexArray(cache, context.api.opengl.pullingArray);
+			}
+
+			const CGCommandStream& stream = cmdPool.stream;
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			// Pools that were never sorted execute in submission order
+			const uint32_t* order = cmdPool.order.size == stream.packetCount * sizeof(uint32_t) ? ArenaOps::GetData<uint32_t>(cmdPool.order) : nullptr;
+
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const CGRenderPacket& packet = packets[order ? order[p] : p];
+
+				const uint8_t* cursor = commands + packet.offset;
+				const uint8_t* end = cursor + packet.size;
 
-				switch (cmd.type)
+				while (cursor < end)
 				{
-					case CGRenderCommandType::None:
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					switch (static_cast<CGRenderCommandType>(header.type))
 					{
-						break;
+						case CGRenderCommandType::None:
+						{
+							break;
+						}
+						case CGRenderCommandType::SetViewClear:
+						{
+							const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+							if (cmd.viewport < context.api.opengl.viewportCount)
+							{
+								SetViewport(cache, context.api.opengl.viewports[cmd.viewport]);
+							}
+
+							ClearView(cache, cmd.clearFlags, cmd.color);
+
+							continue;
+						}
+						case CGRenderCommandType::SetPipelineState:
+						{
+							const CGSetPipelineStateCommand& cmd = GetCommand<CGSetPipelineStateCommand>(header);
+
+							if (cmd.pipeline >= resourcePool.pipelinePool.count)
+							{
+								break;
+							}
+
+							SetPipelineState(cache, resourcePool, cmd.pipeline);
+
+							continue;
+						}
+						case CGRenderCommandType::SetVertexShader:
+						case CGRenderCommandType::SetFragmentShader:
+						{
+							// Part of the linked program in OpenGL
+							continue;
+						}
+						case CGRenderCommandType::SetVertexBuffer:
+						{
+							if (!BindVertexBuffer(context, bufferPool, GetCommand<CGSetVertexBufferCommand>(header)))
+							{
+								break;
+							}
+
+							continue;
+						}
+						case CGRenderCommandType::SetIndexBuffer:
+						{
+							const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+
+							if (cmd.buffer == CG_TRANSIENT_BUFFER)
+							{
+								BindIndexBuffer(cache, context.api.opengl.transientBuffer);
+								context.api.opengl.indexOffset = CG_TRANSIENT_SIZE * context.api.opengl.frame + cmd.offset;
+							}
+							else
+							{
+								BindIndexBuffer(cache, bufferPool.indexBuffers[cmd.buffer].api.opengl.buffer);
+								context.api.opengl.indexOffset = cmd.offset;
+							}
+
+							continue;
+						}
+						case CGRenderCommandType::Draw:
+						{
+							const CGDrawCommand& cmd = GetCommand<CGDrawCommand>(header);
+
+							RenderOps::Draw(GetPrimitiveMode(cache.topology), cmd.start, cmd.count);
+						
+							continue;
+						}
+						case CGRenderCommandType::DrawIndexed:
+						{
+							const CGDrawIndexedCommand& cmd = GetCommand<CGDrawIndexedCommand>(header);
+
+							RenderOps::DrawIndexed(GetPrimitiveMode(cache.topology), cmd.count, context.api.opengl.indexOffset + cmd.start * static_cast<uint32_t>(sizeof(uint16_t)), cmd.baseVertex);
+
+							continue;
+						}
+						case CGRenderCommandType::SetConstantBuffer:
+						{
+							const CGSetConstantBufferCommand& cmd = GetCommand<CGSetConstantBufferCommand>(header);
+
+							if (cmd.slot >= CG_MAX_CONSTANT_SLOTS)
+							{
+								break;
+							}
+
+							// Transient ranges need an explicit size, buffers default to everything past the offset
+							if (cmd.buffer == CG_TRANSIENT_BUFFER)
+							{
+								if (cmd.size == 0u)
+								{
+									break;
+								}
+
+								const uint32_t offset = CG_TRANSIENT_SIZE * context.api.opengl.frame + cmd.offset;
+								BindConstantBuffer(cache, cmd.slot, context.api.opengl.transientBuffer, offset, cmd.size);
+							}
+							else
+							{
+								if (cmd.buffer >= bufferPool.cbCount || cmd.offset >= bufferPool.constantBuffers[cmd.buffer].desc.size)
+								{
+									break;
+								}
+
+								const CGBuffer& cBuffer = bufferPool.constantBuffers[cmd.buffer];
+								const uint32_t offset = cBuffer.api.opengl.segmentSize * context.api.opengl.frame + cmd.offset;
+								const uint32_t size = cmd.size ? cmd.size : cBuffer.desc.size - cmd.offset;
+
+								BindConstantBuffer(cache, cmd.slot, cBuffer.api.opengl.buffer, offset, size);
+							}
+
+							continue;
+						}
+						case CGRenderCommandType::ExecuteBundle:
+						{
+							const CGExecuteBundleCommand& cmd = GetCommand<CGExecuteBundleCommand>(header);
+
+							if (cmd.bundle < resourcePool.bundlePool.count)
+							{
+								ExecuteBundle(context, resourcePool, resourcePool.bundlePool.bundles[cmd.bundle]);
+							}
+
+							continue;
+						}
+						case CGRenderCommandType::SetTexture:
+						{
+							const CGSetTextureCommand& cmd = GetCommand<CGSetTextureCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.texture >= resourcePool.texturePool.tCount.load(std::memory_order_acquire))
+							{
+								break;
+							}
+
+							// Textures still loading bind as 0, which samples black
+							BindTexture(cache, cmd.slot, resourcePool.texturePool.textures[cmd.texture].api.opengl.texture);
+
+							continue;
+						}
+						case CGRenderCommandType::SetSampler:
+						{
+							const CGSetSamplerCommand& cmd = GetCommand<CGSetSamplerCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.sampler >= resourcePool.texturePool.sCount)
+							{
+								break;
+							}
+
+							BindSampler(cache, cmd.slot, resourcePool.texturePool.samplers[cmd.sampler].api.opengl.sampler);
+
+							continue;
+						}
 					}
-					case CGRenderCommandType::SetViewClear:
+
+					break;
+				}
+			}
+		}
+
+		bool CompileBundle(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandStream& stream, CGRenderBundle& bundle)
+		{
+			const CGBufferPool& bufferPool = resourcePool.bufferPool;
+
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			ArenaOps::Reset(bundle.ops);
+			bundle.count = 0u;
+
+			const auto AddOp = [&bundle](const BundleOpType type) -> BundleOp&
+			{
+				BundleOp* op = new (ArenaOps::Allocate(sizeof(BundleOp), bundle.ops)) BundleOp();
+				op->type = type;
+
+				bundle.count++;
+
+				return *op;
+			};
+
+			// Bundles replay in recorded order, packets are not sorted
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const uint8_t* cursor = commands + packets[p].offset;
+				const uint8_t* end = cursor + packets[p].size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					switch (static_cast<CGRenderCommandType>(header.type))
 					{
-						uint32_t color = cmd.params.setViewClear.color;
+						case CGRenderCommandType::SetViewClear:
+						{
+							const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+							if (cmd.viewport < context.api.opengl.viewportCount)
+							{
+								AddOp(BundleOpType::SetViewport).params.viewport = context.api.opengl.viewports[cmd.viewport];
+							}
+
+							BundleOp& op = AddOp(BundleOpType::Clear);
+							op.params.clear.rgba[0] = ((cmd.color >> 24) & 0xFF) * CG_ONE_OVER_255;
+							op.params.clear.rgba[1] = ((cmd.color >> 16) & 0xFF) * CG_ONE_OVER_255;
+							op.params.clear.rgba[2] = ((cmd.color >> 8) & 0xFF) * CG_ONE_OVER_255;
+							op.params.clear.rgba[3] = (cmd.color & 0xFF) * CG_ONE_OVER_255;
+							op.params.clear.color = cmd.color;
+							op.params.clear.mask = MapClearFlags(cmd.clearFlags);
+
+							continue;
+						}
+						case CGRenderCommandType::SetPipelineState:
+						{
+							const CGSetPipelineStateCommand& cmd = GetCommand<CGSetPipelineStateCommand>(header);
+
+							if (cmd.pipeline >= resourcePool.pipelinePool.count)
+							{
+								return false;
+							}
+
+							AddOp(BundleOpType::SetPipelineState).params.name = cmd.pipeline;
+
+							continue;
+						}
+						case CGRenderCommandType::SetVertexShader:
+						case CGRenderCommandType::SetFragmentShader:
+						{
+							// Part of the linked program in OpenGL
+							continue;
+						}
+						case CGRenderCommandType::SetVertexBuffer:
+						{
+							const CGSetVertexBufferCommand& cmd = GetCommand<CGSetVertexBufferCommand>(header);
+
+							if (context.api.opengl.pullingArray)
+							{
+								if (cmd.buffer >= bufferPool.vlCount || cmd.buffer >= bufferPool.vbCount || cmd.offset >= bufferPool.vertexBuffers[cmd.buffer].desc.size)
+								{
+									return false;
+								}
+
+								const CGBuffer& vBuffer = bufferPool.vertexBuffers[cmd.buffer];
+
+								BundleOp& op = AddOp(BundleOpType::BindVertexStorage);
+								op.params.vertices.buffer = vBuffer.api.opengl.buffer;
+								op.params.vertices.offset = cmd.offset;
+								op.params.vertices.segmentSize = vBuffer.api.opengl.segmentSize;
+								op.params.vertices.size = vBuffer.desc.size - cmd.offset;
+								op.params.vertices.layout = cmd.buffer;
+
+								continue;
+							}
+
+							if (cmd.buffer >= bufferPool.vlCount || cmd.buffer >= bufferPool.vbCount || cmd.offset >= bufferPool.vertexBuffers[cmd.buffer].desc.size)
+							{
+								return false;
+							}
+
+							const CGBuffer& vBuffer = bufferPool.vertexBuffers[cmd.buffer];
+
+							BundleOp& op = AddOp(BundleOpType::BindVertexArray);
+							op.params.vertices.buffer = vBuffer.api.opengl.buffer;
+							op.params.vertices.offset = cmd.offset;
+							op.params.vertices.segmentSize = vBuffer.api.opengl.segmentSize;
+							op.params.vertices.size = vBuffer.desc.stride;
+							op.params.vertices.layout = bufferPool.vertexLayouts[cmd.buffer].api.opengl.vao;
+
+							continue;
+						}
+						case CGRenderCommandType::SetIndexBuffer:
+						{
+							const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+
+							if (cmd.buffer >= bufferPool.ibCount || cmd.offset != 0u)
+							{
+								return false;
+							}
+
+							AddOp(BundleOpType::BindIndexBuffer).params.name = bufferPool.indexBuffers[cmd.buffer].api.opengl.buffer;
+
+							continue;
+						}
+						case CGRenderCommandType::Draw:
+						{
+							const CGDrawCommand& cmd = GetCommand<CGDrawCommand>(header);
+
+							BundleOp& op = AddOp(BundleOpType::Draw);
+							op.params.draw.start = cmd.start;
+							op.params.draw.count = cmd.count;
+
+							continue;
+						}
+						case CGRenderCommandType::SetConstantBuffer:
+						{
+							const CGSetConstantBufferCommand& cmd = GetCommand<CGSetConstantBufferCommand>(header);
+
+							if (cmd.slot >= CG_MAX_CONSTANT_SLOTS || cmd.buffer >= bufferPool.cbCount)
+							{
+								return false;
+							}
+
+							const CGBuffer& cBuffer = bufferPool.constantBuffers[cmd.buffer];
+
+							// The segment of a dynamic buffer changes every frame, bundles replay fixed ranges
+							if (cBuffer.api.opengl.mapped || cmd.offset >= cBuffer.desc.size)
+							{
+								return false;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::BindConstantBuffer);
+							op.params.constants.buffer = cBuffer.api.opengl.buffer;
+							op.params.constants.offset = cmd.offset;
+							op.params.constants.size = cmd.size ? cmd.size : cBuffer.desc.size - cmd.offset;
+							op.params.constants.slot = cmd.slot;
+
+							continue;
+						}
+						case CGRenderCommandType::SetTexture:
+						{
+							const CGSetTextureCommand& cmd = GetCommand<CGSetTextureCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.texture >= resourcePool.texturePool.tCount.load(std::memory_order_acquire))
+							{
+								return false;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::BindTexture);
+							op.params.binding.name = cmd.texture;
+							op.params.binding.slot = cmd.slot;
+
+							continue;
+						}
+						case CGRenderCommandType::SetSampler:
+						{
+							const CGSetSamplerCommand& cmd = GetCommand<CGSetSamplerCommand>(header);
+
+							if (cmd.slot >= CG_MAX_TEXTURE_SLOTS || cmd.sampler >= resourcePool.texturePool.sCount)
+							{
+								return false;
+							}
+
+							BundleOp& op = AddOp(BundleOpType::BindSampler);
+							op.params.binding.name = resourcePool.texturePool.samplers[cmd.sampler].api.opengl.sampler;
+							op.params.binding.slot = cmd.slot;
+
+							continue;
+						}
+						case CGRenderCommandType::None:
+						case CGRenderCommandType::DrawIndexed:
+						case CGRenderCommandType::ExecuteBundle:
+						{
+							break;
+						}
+					}
 
-						ClearView(
-							cmd.params.setViewClear.clearFlags,
-							((color >> 24) & 0xFF) * CG_ONE_OVER_255,
-							((color >> 16) & 0xFF) * CG_ONE_OVER_255,
-							((color >> 8) & 0xFF) * CG_ONE_OVER_255,
-							(color & 0xFF) * CG_ONE_OVER_255
-						);
+					// Unsupported or nested commands make the whole bundle invalid
+					ArenaOps::Reset(bundle.ops);
+					bundle.count = 0u;
 
-						continue;
+					return false;
+				}
+			}
+
+			return bundle.count > 0u;
+		}
+
+		void ExecuteBundle(CGRenderContext& context, const CGResourcePool& resourcePool, const CGRenderBundle& bundle)
+		{
+			CGStateCache& cache = context.api.opengl.stateCache;
+
+			const BundleOp* ops = ArenaOps::GetData<BundleOp>(bundle.ops);
+
+			for (uint32_t i = 0u; i < bundle.count; ++i)
+			{
+				const BundleOp& op = ops[i];
+
+				switch (op.type)
+				{
+					case BundleOpType::SetViewport:
+					{
+						SetViewport(cache, op.params.viewport);
+						break;
 					}
-					case CGRenderCommandType::SetPipelineState:
+					case BundleOpType::Clear:
 					{
-						UseProgram(cmd.params.setPipelineState.program);
-
-						continue;
+						SetClearColor(cache, op.params.clear.color, op.params.clear.rgba);
+						glClear(op.params.clear.mask);
+						break;
 					}
-					case CGRenderCommandType::SetVertexBuffer:
+					case BundleOpType::SetPipelineState:
 					{
-						const CGVertexLayout& vLayout = bufferPool.vertexLayouts[cmd.params.setVertexBuffer.buffer];
-
-						BindVertexArray(vLayout.api.opengl.vao);
+						SetPipelineState(cache, resourcePool, op.params.name);
+						break;
+					}
+					case BundleOpType::BindVertexArray:
+					{
+						const uint32_t offset = op.params.vertices.segmentSize * context.api.opengl.frame + op.params.vertices.offset;
 
-						continue;
+						BindVertexArray(cache, op.params.vertices.layout);
+						BindVertexArrayBuffer(cache, op.params.vertices.buffer, offset, op.params.vertices.size);
+						break;
+					}
+					case BundleOpType::BindIndexBuffer:
+					{
+						BindIndexBuffer(cache, op.params.name);
+						break;
 					}
-					case CGRenderCommandType::SetIndexBuffer:
+					case BundleOpType::Draw:
 					{
-						const CGBuffer& indexBuffer = bufferPool.indexBuffers[cmd.params.setIndexBuffer.buffer];
+						RenderOps::Draw(GetPrimitiveMode(cache.topology), op.params.draw.start, op.params.draw.count);
+						break;
+					}
+					case BundleOpType::BindConstantBuffer:
+					{
+						BindConstantBuffer(cache, op.params.constants.slot, op.params.constants.buffer, op.params.constants.offset, op.params.constants.size);
+						break;
+					}
+					case BundleOpType::BindVertexStorage:
+					{
+						const uint32_t offset = op.params.vertices.segmentSize * context.api.opengl.frame + op.params.vertices.offset;
 
-						continue;
+						BindVertexStorage(context, op.params.vertices.layout, op.params.vertices.buffer, offset, op.params.vertices.size);
+						break;
 					}
-					case CGRenderCommandType::Draw:
+					case BundleOpType::BindTexture:
 					{
-						RenderOps::Draw(cmd.params.draw.start, cmd.params.draw.count);
-						
-						continue;
+						BindTexture(cache, op.params.binding.slot, resourcePool.texturePool.textures[op.params.binding.name].api.opengl.texture);
+						break;
+					}
+					case BundleOpType::BindSampler:
+					{
+						BindSampler(cache, op.params.binding.slot, op.params.binding.name);
+						break;
 					}
 				}
-
-				break;
 			}
 		}
 	}
 
 	namespace RenderOps
 	{
-		void Draw(const uint32_t start, const uint32_t count)
+		void Draw(const GLenum mode, const uint32_t start, const uint32_t count)
+		{
+			glDrawArrays(mode, start, count);
+		}
+
+		void DrawIndexed(const GLenum mode, const uint32_t count, const uint32_t offset, const int32_t baseVertex)
 		{
-			glDrawArrays(GL_TRIANGLES, start, count);
+			// 16-bit indices, same as the other backends
+			glDrawElementsBaseVertex(mode, static_cast<GLsizei>(count), GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(static_cast<uintptr_t>(offset)), baseVertex);
 		}
 	}
 
 	namespace FrameOps
 	{
-		void EndFrame(const CGResourcePool& resourcePool)
+		bool WaitForFrame(CGRenderContext& context, const uint8_t pool, const uint64_t timeout)
+		{
+			GLsync fence = static_cast<GLsync>(context.api.opengl.fences[pool]);
+
+			// Never executed, or already known to be complete
+			if (!fence)
+			{
+				return true;
+			}
+
+			const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+			{
+				return false;
+			}
+
+			glDeleteSync(fence);
+			context.api.opengl.fences[pool] = nullptr;
+
+			return true;
+		}
+
+		void EndFrame(CGRenderContext& context)
 		{
-			//ContextOps::UseProgram(0U);
+			void*& fence = context.api.opengl.fences[context.api.opengl.frame];
+
+			// A pool is only executed again after it was waited for, this only replaces an unobserved fence
+			if (fence)
+			{
+				glDeleteSync(static_cast<GLsync>(fence));
+			}
+
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u);
 		}
 
-		void Present(void* window)
+		void Present(const CGRenderContext& context)
 		{
-			if (!window)
+			// Offscreen frames are never shown, flushing hands the recorded work to the driver
+			if (context.api.opengl.framebuffer)
+			{
+				glFlush();
+				return;
+			}
+
+			if (!context.api.opengl.window)
 			{
 				return;
 			}
 
-			glfwSwapBuffers(static_cast<GLFWwindow*>(window));
+			glfwSwapBuffers(static_cast<GLFWwindow*>(context.api.opengl.window));
 		}
 	}
 }
@@ -0,0 +1,1129 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define CG_SOFTWARE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CG_SOFTWARE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+#include "renderer.h"
+#include "platform/window.h"
+
+// renderer_software.cpp
+namespace cg::renderer::Software
+{
+	/* ----SIMD Lanes---- */
+	// Edge functions are evaluated for a row of LANE_COUNT pixels at once
+
+#if defined(CG_SOFTWARE_AVX2)
+	using Lanes = __m256;
+	constexpr uint32_t LANE_COUNT = 8u;
+
+	static inline Lanes LaneSet(const float value) { return _mm256_set1_ps(value); }
+	static inline Lanes LaneRamp() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+	static inline Lanes LaneAdd(const Lanes a, const Lanes b) { return _mm256_add_ps(a, b); }
+	static inline Lanes LaneMul(const Lanes a, const Lanes b) { return _mm256_mul_ps(a, b); }
+	static inline void LaneStore(float* out, const Lanes a) { _mm256_storeu_ps(out, a); }
+
+	static inline uint32_t LaneInside(const Lanes e, const bool topLeft)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		return static_cast<uint32_t>(_mm256_movemask_ps(topLeft ? _mm256_cmp_ps(e, zero, _CMP_GE_OQ) : _mm256_cmp_ps(e, zero, _CMP_GT_OQ)));
+	}
+#elif defined(CG_SOFTWARE_SSE2)
+	using Lanes = __m128;
+	constexpr uint32_t LANE_COUNT = 4u;
+
+	static inline Lanes LaneSet(const float value) { return _mm_set1_ps(value); }
+	static inline Lanes LaneRamp() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+	static inline Lanes LaneAdd(const Lanes a, const Lanes b) { return _mm_add_ps(a, b); }
+	static inline Lanes LaneMul(const Lanes a, const Lanes b) { return _mm_mul_ps(a, b); }
+	static inline void LaneStore(float* out, const Lanes a) { _mm_storeu_ps(out, a); }
+
+	static inline uint32_t LaneInside(const Lanes e, const bool topLeft)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		return static_cast<uint32_t>(_mm_movemask_ps(topLeft ? _mm_cmpge_ps(e, zero) : _mm_cmpgt_ps(e, zero)));
+	}
+#else
+	// Scalar fallback for targets without SSE2
+	using Lanes = float;
+	constexpr uint32_t LANE_COUNT = 1u;
+
+	static inline Lanes LaneSet(const float value) { return value; }
+	static inline Lanes LaneRamp() { return 0.0f; }
+	static inline Lanes LaneAdd(const Lanes a, const Lanes b) { return a + b; }
+	static inline Lanes LaneMul(const Lanes a, const Lanes b) { return a * b; }
+	static inline void LaneStore(float* out, const Lanes a) { *out = a; }
+
+	static inline uint32_t LaneInside(const Lanes e, const bool topLeft)
+	{
+		return (topLeft ? e >= 0.0f : e > 0.0f) ? 1u : 0u;
+	}
+#endif
+
+	static inline uint32_t LowestLane(const uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0ul;
+		_BitScanForward(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+	}
+
+	/* ----Rasterizer---- */
+
+	// Screen-space triangle, ready for every tile it overlaps
+	struct Triangle
+	{
+		// Edge i is opposite vertex i: E(x, y) = a * x + b * y + c, positive inside
+		float a[3];
+		float b[3];
+		float c[3];
+		bool topLeft[3];
+
+		float invArea;
+		float invW[3];
+		float varyings[3][CG_MAX_SOFTWARE_VARYINGS]; // Premultiplied by 1/w for perspective-correct interpolation
+
+		CGSoftwareFragmentShader fragment;
+		uint8_t varyingCount;
+
+		int32_t minX, minY, maxX, maxY; // Pixel bounds, max is exclusive
+	};
+
+	struct Program
+	{
+		CGSoftwareVertexShader vertex;
+		CGSoftwareFragmentShader fragment;
+		uint8_t varyingCount;
+	};
+
+	struct Rasterizer;
+
+	// Workers and the submitting thread pull tiles from a shared counter until none are left
+	struct WorkerPool
+	{
+		std::thread threads[CG_MAX_SOFTWARE_WORKERS];
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::atomic<uint32_t> nextTile = 0u;
+		uint32_t generation = 0u;
+		uint32_t busy = 0u;
+		uint8_t count = 0u;
+		bool quit = false;
+	};
+
+	struct Rasterizer
+	{
+		std::unique_ptr<uint32_t[]> framebuffer;
+		std::unique_ptr<CGLinearArena[]> bins; // Triangle indices per tile, in submission order
+		CGLinearArena triangles = {};
+
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		uint32_t tilesX = 0u;
+		uint32_t tilesY = 0u;
+		uint32_t triangleCount = 0u;
+
+		Program programs[CG_MAX_SHADER_PROGRAMS] = {};
+		uint32_t programCount = 0u;
+
+		// Bound state, buffers are resolved to their bytes past the bind offset
+		CGViewport viewport = {};
+		const uint8_t* vertices = nullptr;
+		const CGVertexLayout* vertexLayout = nullptr;
+		const uint8_t* indices = nullptr;
+		uint32_t vertexStride = 0u;
+		uint32_t vertexCount = 0u;
+		uint32_t indexSize = 0u; // 2 or 4 bytes
+		uint32_t indexCount = 0u;
+		Program program = {};
+
+		// Transient memory of the executed frame pool
+		const uint8_t* transient = nullptr;
+		uint32_t transientSize = 0u;
+
+		uint32_t clearColor = 0u;
+		bool clearPending = false;
+
+		WorkerPool workers;
+	};
+
+	static Rasterizer* GetRasterizer(const CGRenderContext& context)
+	{
+		return static_cast<Rasterizer*>(context.api.software.rasterizer);
+	}
+
+	static uint32_t PackColor(const float color[4])
+	{
+		uint32_t packed = 0u;
+
+		for (uint8_t i = 0u; i < 4u; ++i)
+		{
+			const float channel = std::min(std::max(color[i], 0.0f), 1.0f);
+			packed = (packed << 8u) | static_cast<uint32_t>(channel * 255.0f + 0.5f);
+		}
+
+		return packed;
+	}
+
+	static void RasterizeTriangle(Rasterizer& rasterizer, const Triangle& tri, const int32_t tileX, const int32_t tileY)
+	{
+		const int32_t minX = std::max(tri.minX, tileX);
+		const int32_t minY = std::max(tri.minY, tileY);
+		const int32_t maxX = std::min(tri.maxX, tileX + static_cast<int32_t>(CG_SOFTWARE_TILE_SIZE));
+		const int32_t maxY = std::min(tri.maxY, tileY + static_cast<int32_t>(CG_SOFTWARE_TILE_SIZE));
+
+		const Lanes ramp = LaneRamp();
+		const Lanes a[3] = { LaneSet(tri.a[0]), LaneSet(tri.a[1]), LaneSet(tri.a[2]) };
+
+		float e[3][LANE_COUNT];
+		float varyings[CG_MAX_SOFTWARE_VARYINGS];
+		float color[4];
+
+		for (int32_t y = minY; y < maxY; ++y)
+		{
+			const float py = static_cast<float>(y) + 0.5f;
+			uint32_t* row = rasterizer.framebuffer.get() + static_cast<size_t>(y) * rasterizer.width;
+
+			for (int32_t x = minX; x < maxX; x += static_cast<int32_t>(LANE_COUNT))
+			{
+				const Lanes px = LaneAdd(LaneSet(static_cast<float>(x) + 0.5f), ramp);
+
+				uint32_t mask = (1u << LANE_COUNT) - 1u;
+
+				for (uint8_t i = 0u; i < 3u; ++i)
+				{
+					const Lanes edge = LaneAdd(LaneMul(a[i], px), LaneSet(tri.b[i] * py + tri.c[i]));
+					LaneStore(e[i], edge);
+					mask &= LaneInside(edge, tri.topLeft[i]);
+				}
+
+				// Lanes past the right edge of the bounds
+				const uint32_t remaining = static_cast<uint32_t>(maxX - x);
+				if (remaining < LANE_COUNT)
+				{
+					mask &= (1u << remaining) - 1u;
+				}
+
+				while (mask)
+				{
+					const uint32_t lane = LowestLane(mask);
+					mask &= mask - 1u;
+
+					const float l0 = e[0][lane] * tri.invArea;
+					const float l1 = e[1][lane] * tri.invArea;
+					const float l2 = e[2][lane] * tri.invArea;
+
+					const float w = 1.0f / (l0 * tri.invW[0] + l1 * tri.invW[1] + l2 * tri.invW[2]);
+
+					for (uint8_t v = 0u; v < tri.varyingCount; ++v)
+					{
+						varyings[v] = (l0 * tri.varyings[0][v] + l1 * tri.varyings[1][v] + l2 * tri.varyings[2][v]) * w;
+					}
+
+					tri.fragment(varyings, color);
+					row[x + static_cast<int32_t>(lane)] = PackColor(color);
+				}
+			}
+		}
+	}
+
+	static void ShadeTile(Rasterizer& rasterizer, const uint32_t tile)
+	{
+		const int32_t tileX = static_cast<int32_t>((tile % rasterizer.tilesX) * CG_SOFTWARE_TILE_SIZE);
+		const int32_t tileY = static_cast<int32_t>((tile / rasterizer.tilesX) * CG_SOFTWARE_TILE_SIZE);
+
+		if (rasterizer.clearPending)
+		{
+			const uint32_t maxX = std::min(static_cast<uint32_t>(tileX) + CG_SOFTWARE_TILE_SIZE, rasterizer.width);
+			const uint32_t maxY = std::min(static_cast<uint32_t>(tileY) + CG_SOFTWARE_TILE_SIZE, rasterizer.height);
+
+			for (uint32_t y = static_cast<uint32_t>(tileY); y < maxY; ++y)
+			{
+				uint32_t* row = rasterizer.framebuffer.get() + static_cast<size_t>(y) * rasterizer.width;
+				std::fill(row + tileX, row + maxX, rasterizer.clearColor);
+			}
+		}
+
+		const CGLinearArena& bin = rasterizer.bins[tile];
+		const uint32_t* indices = ArenaOps::GetData<uint32_t>(bin);
+		const Triangle* triangles = ArenaOps::GetData<Triangle>(rasterizer.triangles);
+
+		for (size_t i = 0u; i < bin.size / sizeof(uint32_t); ++i)
+		{
+			RasterizeTriangle(rasterizer, triangles[indices[i]], tileX, tileY);
+		}
+	}
+
+	static void ShadeTiles(Rasterizer& rasterizer)
+	{
+		const uint32_t tileCount = rasterizer.tilesX * rasterizer.tilesY;
+
+		uint32_t tile = rasterizer.workers.nextTile.fetch_add(1u, std::memory_order_relaxed);
+
+		while (tile < tileCount)
+		{
+			ShadeTile(rasterizer, tile);
+			tile = rasterizer.workers.nextTile.fetch_add(1u, std::memory_order_relaxed);
+		}
+	}
+
+	static void WorkerMain(Rasterizer* rasterizer)
+	{
+		WorkerPool& workers = rasterizer->workers;
+		uint32_t generation = 0u;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(workers.mutex);
+				workers.wake.wait(lock, [&] { return workers.quit || workers.generation != generation; });
+
+				if (workers.quit)
+				{
+					return;
+				}
+
+				generation = workers.generation;
+			}
+
+			ShadeTiles(*rasterizer);
+
+			std::lock_guard<std::mutex> lock(workers.mutex);
+
+			if (--workers.busy == 0u)
+			{
+				workers.done.notify_one();
+			}
+		}
+	}
+
+	// Shades every tile in parallel. Each tile replays its bin in submission order, so the
+	// result does not depend on the number of workers.
+	static void Flush(Rasterizer& rasterizer)
+	{
+		if (rasterizer.triangleCount == 0u && !rasterizer.clearPending)
+		{
+			return;
+		}
+
+		WorkerPool& workers = rasterizer.workers;
+		workers.nextTile.store(0u, std::memory_order_relaxed);
+
+		if (workers.count > 0u)
+		{
+			std::lock_guard<std::mutex> lock(workers.mutex);
+			workers.busy = workers.count;
+			workers.generation++;
+		}
+
+		workers.wake.notify_all();
+
+		ShadeTiles(rasterizer);
+
+		if (workers.count > 0u)
+		{
+			std::unique_lock<std::mutex> lock(workers.mutex);
+			workers.done.wait(lock, [&] { return workers.busy == 0u; });
+		}
+
+		const uint32_t tileCount = rasterizer.tilesX * rasterizer.tilesY;
+		for (uint32_t i = 0u; i < tileCount; ++i)
+		{
+			ArenaOps::Reset(rasterizer.bins[i]);
+		}
+
+		ArenaOps::Reset(rasterizer.triangles);
+		rasterizer.triangleCount = 0u;
+		rasterizer.clearPending = false;
+	}
+
+	static void ToScreen(const CGViewport& viewport, const CGSoftwareVertex& vertex, float& x, float& y)
+	{
+		const float invW = 1.0f / vertex.position[3];
+
+		x = viewport.x + (vertex.position[0] * invW * 0.5f + 0.5f) * viewport.width;
+		y = viewport.y + (0.5f - vertex.position[1] * invW * 0.5f) * viewport.height;
+	}
+
+	// Sets up one triangle and appends it to the bin of every tile its bounds overlap
+	static void BinTriangle(Rasterizer& rasterizer, const CGSoftwareVertex vertices[3])
+	{
+		// No clipping against the near plane, triangles reaching behind the eye are dropped
+		for (uint8_t i = 0u; i < 3u; ++i)
+		{
+			if (vertices[i].position[3] <= 1e-6f)
+			{
+				return;
+			}
+		}
+
+		float x[3], y[3];
+
+		for (uint8_t i = 0u; i < 3u; ++i)
+		{
+			ToScreen(rasterizer.viewport, vertices[i], x[i], y[i]);
+		}
+
+		float area = (x[2] - x[1]) * (y[0] - y[1]) - (y[2] - y[1]) * (x[0] - x[1]);
+
+		if (area == 0.0f)
+		{
+			return;
+		}
+
+		// Both windings are rasterized, the edges are flipped so the inside is always positive
+		const float orientation = area < 0.0f ? -1.0f : 1.0f;
+		area *= orientation;
+
+		const int32_t minX = std::max(static_cast<int32_t>(std::min({ x[0], x[1], x[2] })), 0);
+		const int32_t minY = std::max(static_cast<int32_t>(std::min({ y[0], y[1], y[2] })), 0);
+		const int32_t maxX = std::min(static_cast<int32_t>(std::max({ x[0], x[1], x[2] })) + 1, static_cast<int32_t>(rasterizer.width));
+		const int32_t maxY = std::min(static_cast<int32_t>(std::max({ y[0], y[1], y[2] })) + 1, static_cast<int32_t>(rasterizer.height));
+
+		if (minX >= maxX || minY >= maxY)
+		{
+			return;
+		}
+
+		Triangle* tri = static_cast<Triangle*>(ArenaOps::Allocate(sizeof(Triangle), rasterizer.triangles));
+
+		if (!tri)
+		{
+			return;
+		}
+
+		for (uint8_t i = 0u; i < 3u; ++i)
+		{
+			const uint8_t j = static_cast<uint8_t>((i + 1u) % 3u);
+			const uint8_t k = static_cast<uint8_t>((i + 2u) % 3u);
+
+			tri->a[i] = (y[j] - y[k]) * orientation;
+			tri->b[i] = (x[k] - x[j]) * orientation;
+			tri->c[i] = -(tri->a[i] * x[j] + tri->b[i] * y[j]);
+
+			// Left edges face +x, top edges are horizontal and face down (+y)
+			tri->topLeft[i] = tri->a[i] > 0.0f || (tri->a[i] == 0.0f && tri->b[i] > 0.0f);
+
+			tri->invW[i] = 1.0f / vertices[i].position[3];
+
+			for (uint8_t v = 0u; v < rasterizer.program.varyingCount; ++v)
+			{
+				tri->varyings[i][v] = vertices[i].varyings[v] * tri->invW[i];
+			}
+		}
+
+		tri->invArea = 1.0f / area;
+		tri->fragment = rasterizer.program.fragment;
+		tri->varyingCount = rasterizer.program.varyingCount;
+		tri->minX = minX;
+		tri->minY = minY;
+		tri->maxX = maxX;
+		tri->maxY = maxY;
+
+		const uint32_t index = rasterizer.triangleCount++;
+
+		for (uint32_t ty = static_cast<uint32_t>(minY) / CG_SOFTWARE_TILE_SIZE; ty <= static_cast<uint32_t>(maxY - 1) / CG_SOFTWARE_TILE_SIZE; ++ty)
+		{
+			for (uint32_t tx = static_cast<uint32_t>(minX) / CG_SOFTWARE_TILE_SIZE; tx <= static_cast<uint32_t>(maxX - 1) / CG_SOFTWARE_TILE_SIZE; ++tx)
+			{
+				void* slot = ArenaOps::Allocate(sizeof(uint32_t), rasterizer.bins[ty * rasterizer.tilesX + tx]);
+
+				if (slot)
+				{
+					std::memcpy(slot, &index, sizeof(uint32_t));
+				}
+			}
+		}
+	}
+
+	// Runs the vertex shader over count vertices (optionally indexed, offset by baseVertex) and bins the resulting triangles
+	static void Draw(Rasterizer& rasterizer, const uint32_t start, const uint32_t count, const int32_t baseVertex, const bool indexed)
+	{
+		const Program& program = rasterizer.program;
+
+		if (!program.vertex || !program.fragment || !rasterizer.vertices || !rasterizer.vertexLayout || (indexed && !rasterizer.indices))
+		{
+			return;
+		}
+
+		const uint8_t* vertices = rasterizer.vertices;
+		const uint32_t stride = rasterizer.vertexStride;
+		const uint32_t vertexCount = rasterizer.vertexCount;
+
+		const auto GetIndex = [&rasterizer, baseVertex, indexed](const uint32_t i) -> uint32_t
+		{
+			if (!indexed)
+			{
+				return i;
+			}
+
+			if (i >= rasterizer.indexCount)
+			{
+				return UINT32_MAX;
+			}
+
+			if (rasterizer.indexSize == sizeof(uint16_t))
+			{
+				uint16_t index = 0u;
+				std::memcpy(&index, rasterizer.indices + i * sizeof(uint16_t), sizeof(uint16_t));
+				return index + static_cast<uint32_t>(baseVertex);
+			}
+
+			uint32_t index = 0u;
+			std::memcpy(&index, rasterizer.indices + i * sizeof(uint32_t), sizeof(uint32_t));
+			return index + static_cast<uint32_t>(baseVertex);
+		};
+
+		CGSoftwareVertex triangle[3];
+
+		for (uint32_t i = 0u; i + 3u <= count; i += 3u)
+		{
+			bool valid = true;
+
+			for (uint8_t v = 0u; v < 3u; ++v)
+			{
+				const uint32_t index = GetIndex(start + i + v);
+
+				if (index >= vertexCount)
+				{
+					valid = false;
+					break;
+				}
+
+				triangle[v] = {};
+				program.vertex(vertices + static_cast<size_t>(index) * stride, *rasterizer.vertexLayout, triangle[v]);
+			}
+
+			if (valid)
+			{
+				BinTriangle(rasterizer, triangle);
+			}
+		}
+	}
+
+	// Every command except ExecuteBundle, which is handled by the caller
+	static void ExecuteCommand(Rasterizer& rasterizer, const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandHeader& header)
+	{
+		const CGBufferPool& bufferPool = resourcePool.bufferPool;
+		const CGShaderPool& shaderPool = resourcePool.shaderPool;
+
+		switch (static_cast<CGRenderCommandType>(header.type))
+		{
+			case CGRenderCommandType::None:
+			{
+				break;
+			}
+			case CGRenderCommandType::SetViewClear:
+			{
+				const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+				// Triangles binned so far belong before the clear
+				Flush(rasterizer);
+
+				if (cmd.viewport < context.api.software.viewportCount)
+				{
+					rasterizer.viewport = context.api.software.viewports[cmd.viewport];
+				}
+
+				if (cmd.clearFlags & CG_CLEAR_COLOR)
+				{
+					rasterizer.clearColor = cmd.color;
+					rasterizer.clearPending = true;
+				}
+
+				break;
+			}
+			case CGRenderCommandType::SetPipelineState:
+			{
+				const uint32_t pipeline = GetCommand<CGSetPipelineStateCommand>(header).pipeline;
+
+				if (pipeline >= resourcePool.pipelinePool.count)
+				{
+					break;
+				}
+
+				// Only the program applies, pipelines are triangle lists without blending, depth or culling here.
+				// Program names start at 1, 0 unbinds.
+				const uint32_t program = resourcePool.pipelinePool.pipelines[pipeline].desc.program;
+				rasterizer.program = program > 0u && program <= rasterizer.programCount ? rasterizer.programs[program - 1u] : Program{};
+
+				break;
+			}
+			case CGRenderCommandType::SetVertexShader:
+			{
+				const uint8_t shader = GetCommand<CGSetVertexShaderCommand>(header).shader;
+
+				if (shader < shaderPool.vsCount)
+				{
+					rasterizer.program.vertex = shaderPool.vertexShaders[shader].api.software.vertex;
+					rasterizer.program.varyingCount = shaderPool.vertexShaders[shader].api.software.varyingCount;
+				}
+
+				break;
+			}
+			case CGRenderCommandType::SetFragmentShader:
+			{
+				const uint8_t shader = GetCommand<CGSetFragmentShaderCommand>(header).shader;
+
+				if (shader < shaderPool.fsCount)
+				{
+					rasterizer.program.fragment = shaderPool.fragmentShaders[shader].api.software.fragment;
+				}
+
+				break;
+			}
+			case CGRenderCommandType::SetVertexBuffer:
+			{
+				const CGSetVertexBufferCommand& cmd = GetCommand<CGSetVertexBufferCommand>(header);
+
+				// Transient vertices are read with the layout, and the stride, of another vertex buffer
+				const bool transient = cmd.buffer == CG_TRANSIENT_BUFFER;
+				const uint32_t layout = transient ? cmd.layout : cmd.buffer;
+
+				rasterizer.vertexLayout = layout < bufferPool.vlCount ? &bufferPool.vertexLayouts[layout] : nullptr;
+				rasterizer.vertices = nullptr;
+
+				if (layout >= bufferPool.vbCount)
+				{
+					break;
+				}
+
+				const CGBuffer& vBuffer = bufferPool.vertexBuffers[layout];
+				const uint8_t* data = transient ? rasterizer.transient : static_cast<const uint8_t*>(vBuffer.api.software.data);
+				const uint32_t size = transient ? rasterizer.transientSize : vBuffer.desc.size;
+
+				if (data && vBuffer.desc.stride > 0u && cmd.offset <= size)
+				{
+					rasterizer.vertices = data + cmd.offset;
+					rasterizer.vertexStride = vBuffer.desc.stride;
+					rasterizer.vertexCount = (size - cmd.offset) / vBuffer.desc.stride;
+				}
+
+				break;
+			}
+			case CGRenderCommandType::SetIndexBuffer:
+			{
+				const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+
+				const uint8_t* data = rasterizer.transient;
+				uint32_t size = rasterizer.transientSize;
+
+				// Transient indices are 16-bit, buffers derive their width from the size
+				rasterizer.indexSize = sizeof(uint16_t);
+				rasterizer.indices = nullptr;
+
+				if (cmd.buffer != CG_TRANSIENT_BUFFER)
+				{
+					if (cmd.buffer >= bufferPool.ibCount)
+					{
+						break;
+					}
+
+					const CGBuffer& iBuffer = bufferPool.indexBuffers[cmd.buffer];
+
+					data = static_cast<const uint8_t*>(iBuffer.api.software.data);
+					size = iBuffer.desc.size;
+
+					if (iBuffer.desc.count > 0u && iBuffer.desc.size / iBuffer.desc.count != sizeof(uint16_t))
+					{
+						rasterizer.indexSize = sizeof(uint32_t);
+					}
+				}
+
+				if (data && cmd.offset <= size)
+				{
+					rasterizer.indices = data + cmd.offset;
+					rasterizer.indexCount = (size - cmd.offset) / rasterizer.indexSize;
+				}
+
+				break;
+			}
+			case CGRenderCommandType::Draw:
+			{
+				const CGDrawCommand& cmd = GetCommand<CGDrawCommand>(header);
+
+				Draw(rasterizer, cmd.start, cmd.count, 0, false);
+
+				break;
+			}
+			case CGRenderCommandType::DrawIndexed:
+			{
+				const CGDrawIndexedCommand& cmd = GetCommand<CGDrawIndexedCommand>(header);
+
+				Draw(rasterizer, cmd.start, cmd.count, cmd.baseVertex, true);
+				break;
+			}
+			case CGRenderCommandType::ExecuteBundle:
+			{
+				break;
+			}
+			case CGRenderCommandType::SetConstantBuffer:
+			{
+				// The built-in shaders take no constants
+				break;
+			}
+			case CGRenderCommandType::SetTexture:
+			case CGRenderCommandType::SetSampler:
+			{
+				// Nor do they sample textures
+				break;
+			}
+		}
+	}
+
+	/* ----Built-in Shaders---- */
+
+	// assets/debug_vs: passes the position through and forwards the color
+	static void DebugVS(const uint8_t* vertex, const CGVertexLayout& layout, CGSoftwareVertex& out)
+	{
+		float position[3];
+		std::memcpy(position, vertex + layout.elements[0].offset, sizeof(position));
+		std::memcpy(out.varyings, vertex + layout.elements[1].offset, sizeof(float) * 4u);
+
+		out.position[0] = position[0];
+		out.position[1] = position[1];
+		out.position[2] = position[2];
+		out.position[3] = 1.0f;
+	}
+
+	// assets/debug_ps, assets/debug_fs: outputs the interpolated color
+	static void DebugFS(const float varyings[], float color[4])
+	{
+		color[0] = varyings[0];
+		color[1] = varyings[1];
+		color[2] = varyings[2];
+		color[3] = varyings[3];
+	}
+
+	struct BuiltinShader
+	{
+		const char* name;
+		CGShaderType type;
+		CGSoftwareVertexShader vertex;
+		CGSoftwareFragmentShader fragment;
+		uint8_t varyingCount;
+	};
+
+	static constexpr BuiltinShader BUILTIN_SHADERS[] =
+	{
+		{ "debug_vs", CGShaderType::Vertex, DebugVS, nullptr, 4u },
+		{ "debug_ps", CGShaderType::Fragment, nullptr, DebugFS, 0u },
+		{ "debug_fs", CGShaderType::Fragment, nullptr, DebugFS, 0u },
+	};
+
+	static int InitSoftware()
+	{
+		return 1;
+	}
+
+	static void ShutdownSoftware()
+	{
+	}
+
+	bool Init(CGRenderFunctions& functions)
+	{
+		functions.init = InitSoftware;
+		functions.shutdown = ShutdownSoftware;
+
+		return true;
+	}
+
+	bool CreateDeviceAndContext(const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context)
+	{
+		if (window.width < 1 || window.height < 1)
+		{
+			printf("Software renderer needs a non-empty framebuffer");
+			return false;
+		}
+
+		Rasterizer* rasterizer = new (std::nothrow) Rasterizer();
+
+		if (!rasterizer)
+		{
+			return false;
+		}
+
+		rasterizer->width = static_cast<uint32_t>(window.width);
+		rasterizer->height = static_cast<uint32_t>(window.height);
+		rasterizer->tilesX = (rasterizer->width + CG_SOFTWARE_TILE_SIZE - 1u) / CG_SOFTWARE_TILE_SIZE;
+		rasterizer->tilesY = (rasterizer->height + CG_SOFTWARE_TILE_SIZE - 1u) / CG_SOFTWARE_TILE_SIZE;
+		rasterizer->framebuffer.reset(new (std::nothrow) uint32_t[static_cast<size_t>(rasterizer->width) * rasterizer->height]());
+		rasterizer->bins.reset(new (std::nothrow) CGLinearArena[rasterizer->tilesX * rasterizer->tilesY]);
+
+		if (!rasterizer->framebuffer || !rasterizer->bins)
+		{
+			delete rasterizer;
+			return false;
+		}
+
+		ContextOps::CreateViewport(window.width, window.height, rasterizer->viewport);
+
+		// The submitting thread shades tiles too
+		const uint32_t threads = std::thread::hardware_concurrency();
+		rasterizer->workers.count = static_cast<uint8_t>(std::min(threads > 1u ? threads - 1u : 0u, static_cast<uint32_t>(CG_MAX_SOFTWARE_WORKERS)));
+
+		for (uint8_t i = 0u; i < rasterizer->workers.count; ++i)
+		{
+			rasterizer->workers.threads[i] = std::thread(WorkerMain, rasterizer);
+		}
+
+		device.deviceInfo.adapterName = "Software Rasterizer";
+
+		context.api.software = {};
+		context.api.software.rasterizer = rasterizer;
+		context.device = &device;
+
+		return true;
+	}
+
+	namespace DeviceOps
+	{
+		bool CreateShader(const CGShaderDesc& desc, CGShader& shader)
+		{
+			if (!desc.filename)
+			{
+				return false;
+			}
+
+			for (const BuiltinShader& builtin : BUILTIN_SHADERS)
+			{
+				if (builtin.type != desc.shaderType || !std::strstr(desc.filename, builtin.name))
+				{
+					continue;
+				}
+
+				shader.type = desc.shaderType;
+				shader.api.software.vertex = builtin.vertex;
+				shader.api.software.fragment = builtin.fragment;
+				shader.api.software.varyingCount = builtin.varyingCount;
+
+				return true;
+			}
+
+			printf("No software shader for %s", desc.filename);
+
+			return false;
+		}
+
+		bool CreateShaderProgram(CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program)
+		{
+			Rasterizer* rasterizer = GetRasterizer(context);
+
+			if (!rasterizer || rasterizer->programCount + 1u > CG_MAX_SHADER_PROGRAMS)
+			{
+				return false;
+			}
+
+			Program linked = {};
+
+			for (uint8_t i = 0u; i < shaderCount; ++i)
+			{
+				if (shaders[i].type == CGShaderType::Vertex)
+				{
+					linked.vertex = shaders[i].api.software.vertex;
+					linked.varyingCount = shaders[i].api.software.varyingCount;
+				}
+				else if (shaders[i].type == CGShaderType::Fragment)
+				{
+					linked.fragment = shaders[i].api.software.fragment;
+				}
+			}
+
+			if (!linked.vertex || !linked.fragment)
+			{
+				return false;
+			}
+
+			rasterizer->programs[rasterizer->programCount] = linked;
+			rasterizer->programCount++;
+
+			// Names start at 1 like GL programs, 0 stays "no program"
+			program = rasterizer->programCount;
+
+			return true;
+		}
+
+		static bool CreateBuffer(const CGBufferDesc& desc, CGBuffer& buffer, const void* data)
+		{
+			if (desc.size == 0u)
+			{
+				return false;
+			}
+
+			void* copy = std::calloc(1u, desc.size);
+
+			if (!copy)
+			{
+				return false;
+			}
+
+			if (data)
+			{
+				std::memcpy(copy, data, desc.size);
+			}
+
+			buffer.api.software.data = copy;
+
+			return true;
+		}
+
+		bool CreateVertexBuffer(const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData)
+		{
+			return CreateBuffer(vbDesc, vBuffer, vbData);
+		}
+
+		bool CreateIndexBuffer(const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData)
+		{
+			return CreateBuffer(ibDesc, iBuffer, ibData);
+		}
+
+		bool CreateConstantBuffer(const CGBufferDesc& cbDesc, CGBuffer& cBuffer, const void* cbData)
+		{
+			return CreateBuffer(cbDesc, cBuffer, cbData);
+		}
+
+		void DestroyBuffer(CGBuffer& buffer)
+		{
+			std::free(buffer.api.software.data);
+			buffer.api.software.data = nullptr;
+		}
+
+		void UploadBuffers(const CGBufferPool& bufferPool, const CGLinearArena& uploads, CGUploadStats stats[])
+		{
+			const uint8_t* records = ArenaOps::GetData<uint8_t>(uploads);
+
+			// The workers of the previous frame were flushed, nothing reads the copies right now
+			for (size_t offset = 0ull; offset < uploads.size;)
+			{
+				const CGBufferUpload& upload = *reinterpret_cast<const CGBufferUpload*>(records + offset);
+				offset += upload.stride;
+
+				if (!upload.committed)
+				{
+					continue;
+				}
+
+				const CGBuffer& buffer = *GetBuffer(upload.type, upload.buffer, bufferPool);
+				std::memcpy(static_cast<uint8_t*>(buffer.api.software.data) + upload.offset, &upload + 1, upload.size);
+
+				CGUploadStats& strategyStats = stats[static_cast<uint8_t>(upload.strategy)];
+				strategyStats.uploads++;
+				strategyStats.bytes += upload.size;
+			}
+		}
+
+		void DestroyResources(CGResourcePool& resourcePool)
+		{
+			CGBufferPool& bufferPool = resourcePool.bufferPool;
+
+			for (uint32_t i = 0u; i < bufferPool.vbCount; ++i)
+			{
+				std::free(bufferPool.vertexBuffers[i].api.software.data);
+				bufferPool.vertexBuffers[i].api.software.data = nullptr;
+			}
+
+			for (uint32_t i = 0u; i < bufferPool.ibCount; ++i)
+			{
+				std::free(bufferPool.indexBuffers[i].api.software.data);
+				bufferPool.indexBuffers[i].api.software.data = nullptr;
+			}
+
+			for (uint32_t i = 0u; i < bufferPool.cbCount; ++i)
+			{
+				std::free(bufferPool.constantBuffers[i].api.software.data);
+				bufferPool.constantBuffers[i].api.software.data = nullptr;
+			}
+		}
+	}
+
+	namespace ContextOps
+	{
+		bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport)
+		{
+			viewport.x = 0.0f;
+			viewport.y = 0.0f;
+			viewport.width = static_cast<float>(width);
+			viewport.height = static_cast<float>(height);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+
+			return true;
+		}
+
+		void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool)
+		{
+			Rasterizer* rasterizer = GetRasterizer(context);
+
+			if (!rasterizer)
+			{
+				return;
+			}
+
+			rasterizer->transient = ArenaOps::GetData<uint8_t>(cmdPool.transient);
+			rasterizer->transientSize = cmdPool.transientSize;
+
+			const CGCommandStream& stream = cmdPool.stream;
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			// Pools that were never sorted execute in submission order
+			const uint32_t* order = cmdPool.order.size == stream.packetCount * sizeof(uint32_t) ? ArenaOps::GetData<uint32_t>(cmdPool.order) : nullptr;
+
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const CGRenderPacket& packet = packets[order ? order[p] : p];
+
+				const uint8_t* cursor = commands + packet.offset;
+				const uint8_t* end = cursor + packet.size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					if (static_cast<CGRenderCommandType>(header.type) == CGRenderCommandType::ExecuteBundle)
+					{
+						const CGExecuteBundleCommand& cmd = GetCommand<CGExecuteBundleCommand>(header);
+
+						if (cmd.bundle < resourcePool.bundlePool.count)
+						{
+							ExecuteBundle(context, resourcePool, resourcePool.bundlePool.bundles[cmd.bundle]);
+						}
+
+						continue;
+					}
+
+					ExecuteCommand(*rasterizer, context, resourcePool, header);
+				}
+			}
+
+			// The framebuffer is complete once the frame has been executed
+			Flush(*rasterizer);
+		}
+
+		bool CompileBundle(const CGCommandStream& stream, CGRenderBundle& bundle)
+		{
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			ArenaOps::Reset(bundle.ops);
+			bundle.count = 0u;
+
+			// Commands already are what the rasterizer consumes, packets are only flattened into recorded order
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const uint8_t* cursor = commands + packets[p].offset;
+				const uint8_t* end = cursor + packets[p].size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					// Nested bundles make the whole bundle invalid
+					void* op = static_cast<CGRenderCommandType>(header.type) != CGRenderCommandType::ExecuteBundle ?
+						ArenaOps::Allocate(header.size, bundle.ops) : nullptr;
+
+					if (!op)
+					{
+						ArenaOps::Reset(bundle.ops);
+						bundle.count = 0u;
+
+						return false;
+					}
+
+					std::memcpy(op, &header, header.size);
+					bundle.count++;
+				}
+			}
+
+			return bundle.count > 0u;
+		}
+
+		void ExecuteBundle(CGRenderContext& context, const CGResourcePool& resourcePool, const CGRenderBundle& bundle)
+		{
+			Rasterizer* rasterizer = GetRasterizer(context);
+
+			if (!rasterizer)
+			{
+				return;
+			}
+
+			const uint8_t* cursor = ArenaOps::GetData<uint8_t>(bundle.ops);
+			const uint8_t* end = cursor + bundle.ops.size;
+
+			while (cursor < end)
+			{
+				const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+				cursor += header.size;
+
+				ExecuteCommand(*rasterizer, context, resourcePool, header);
+			}
+		}
+
+		const uint32_t* GetFramebuffer(const CGRenderContext& context, uint32_t& width, uint32_t& height)
+		{
+			const Rasterizer* rasterizer = GetRasterizer(context);
+
+			if (!rasterizer)
+			{
+				width = 0u;
+				height = 0u;
+
+				return nullptr;
+			}
+
+			width = rasterizer->width;
+			height = rasterizer->height;
+
+			return rasterizer->framebuffer.get();
+		}
+
+		void DestroyContext(CGRenderContext& context)
+		{
+			Rasterizer* rasterizer = GetRasterizer(context);
+
+			if (!rasterizer)
+			{
+				return;
+			}
+
+			WorkerPool& workers = rasterizer->workers;
+
+			{
+				std::lock_guard<std::mutex> lock(workers.mutex);
+				workers.quit = true;
+			}
+
+			workers.wake.notify_all();
+
+			for (uint8_t i = 0u; i < workers.count; ++i)
+			{
+				workers.threads[i].join();
+			}
+
+			delete rasterizer;
+			context.api.software.rasterizer = nullptr;
+		}
+	}
+}
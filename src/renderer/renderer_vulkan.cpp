@@ -0,0 +1,1746 @@
+#include <vulkan/vulkan.h>
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "renderer.h"
+#include "platform/window.h"
+#include "io/fileio.h"
+
+// renderer_vulkan.cpp
+namespace cg::renderer::Vulkan
+{
+	constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+	constexpr uint32_t MAX_SWAPCHAIN_IMAGES = 8u;
+	constexpr const char* PIPELINE_CACHE_PATH = "vulkan_pipeline_cache.bin";
+
+	// Non-dispatchable handles are pointers on 64-bit targets and integers on 32-bit ones
+	template <typename T>
+	static T GetVkHandle(const uint64_t handle)
+	{
+		return reinterpret_cast<T>(handle);
+	}
+
+	template <typename T>
+	static uint64_t ToVkHandle(const T handle)
+	{
+		return reinterpret_cast<uint64_t>(handle);
+	}
+
+	struct VulkanDevice
+	{
+		VkInstance instance = VK_NULL_HANDLE;
+		VkDebugUtilsMessengerEXT messenger = VK_NULL_HANDLE;
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties properties = {};
+		VkPhysicalDeviceMemoryProperties memoryProperties = {};
+		VkDevice device = VK_NULL_HANDLE;
+		VkQueue queue = VK_NULL_HANDLE;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE; // Persisted to PIPELINE_CACHE_PATH
+		uint32_t queueFamily = 0u;
+	};
+
+	// Everything one frame in flight owns. The fence guards all of it.
+	struct VulkanFrame
+	{
+		VkImage image = VK_NULL_HANDLE; // Offscreen color target, blitted to the swapchain when there is one
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		VkSemaphore imageAvailable = VK_NULL_HANDLE;
+		VkSemaphore renderFinished = VK_NULL_HANDLE;
+	};
+
+	struct VulkanProgram
+	{
+		VkShaderModule vertex = VK_NULL_HANDLE;
+		VkShaderModule fragment = VK_NULL_HANDLE;
+	};
+
+	struct VulkanContext
+	{
+		const VulkanDevice* device = nullptr;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		VkCommandPool commandPool = VK_NULL_HANDLE;	   // Frame command buffers, only used by the thread executing frames
+		VkCommandPool setupCommandPool = VK_NULL_HANDLE; // Bundles and one-time copies, used by the thread creating resources
+		VulkanFrame frames[CG_MAX_FRAMES_IN_FLIGHT] = {};
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
+		VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+		VkImage swapchainImages[MAX_SWAPCHAIN_IMAGES] = {};
+		uint32_t swapchainImageCount = 0u;
+
+		VulkanProgram programs[CG_MAX_SHADER_PROGRAMS] = {};
+		uint32_t programCount = 0u;
+
+		uint32_t frameIndex = 0u; // Frame in flight being recorded
+		uint32_t lastFrame = 0u;  // Most recently submitted frame
+		uint32_t imageIndex = 0u; // Acquired swapchain image
+		bool recording = false;
+		bool acquired = false;
+		bool submitted = false;
+	};
+
+	// Bound state while translating commands into a command buffer
+	struct Recorder
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+	};
+
+	static VulkanDevice* GetDevice(const CGRenderDevice& device)
+	{
+		return static_cast<VulkanDevice*>(device.api.vulkan.device);
+	}
+
+	static VulkanContext* GetContext(const CGRenderContext& context)
+	{
+		return static_cast<VulkanContext*>(context.api.vulkan.context);
+	}
+
+	static bool Check(const VkResult result, const char* what)
+	{
+		if (result == VK_SUCCESS)
+		{
+			return true;
+		}
+
+		printf("Vulkan Error: %s failed (%d)\n", what, static_cast<int>(result));
+
+		return false;
+	}
+
+	static VKAPI_ATTR VkBool32 VKAPI_CALL DebugMessageCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type,
+		const VkDebugUtilsMessengerCallbackDataEXT* data, void* userData)
+	{
+		(void)type;
+		(void)userData;
+
+		if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+		{
+			printf("Vulkan Validation: %s\n", data->pMessage);
+		}
+
+		return VK_FALSE;
+	}
+
+	static bool FindMemoryType(const VulkanDevice& vk, const uint32_t typeBits, const VkMemoryPropertyFlags flags, uint32_t& type)
+	{
+		for (uint32_t i = 0u; i < vk.memoryProperties.memoryTypeCount; ++i)
+		{
+			if ((typeBits & (1u << i)) && (vk.memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+			{
+				type = i;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static bool CreateBuffer(const VulkanDevice& vk, const VkDeviceSize size, const VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!Check(vkCreateBuffer(vk.device, &bufferInfo, nullptr, &buffer), "vkCreateBuffer"))
+		{
+			return false;
+		}
+
+		VkMemoryRequirements requirements = {};
+		vkGetBufferMemoryRequirements(vk.device, buffer, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+
+		// Host visible so uploads are a plain memcpy, which is also what lavapipe prefers
+		if (!FindMemoryType(vk, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocInfo.memoryTypeIndex) ||
+			!Check(vkAllocateMemory(vk.device, &allocInfo, nullptr, &memory), "vkAllocateMemory"))
+		{
+			vkDestroyBuffer(vk.device, buffer, nullptr);
+			buffer = VK_NULL_HANDLE;
+
+			return false;
+		}
+
+		vkBindBufferMemory(vk.device, buffer, memory, 0u);
+
+		return true;
+	}
+
+	static VkCommandBuffer BeginOneTimeCommands(const VulkanContext& ctx)
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = ctx.setupCommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1u;
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+		if (!Check(vkAllocateCommandBuffers(ctx.device->device, &allocInfo, &commandBuffer), "vkAllocateCommandBuffers"))
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		return commandBuffer;
+	}
+
+	static void EndOneTimeCommands(const VulkanContext& ctx, VkCommandBuffer commandBuffer)
+	{
+		vkEndCommandBuffer(commandBuffer);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1u;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		vkQueueSubmit(ctx.device->queue, 1u, &submitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(ctx.device->queue);
+
+		vkFreeCommandBuffers(ctx.device->device, ctx.setupCommandPool, 1u, &commandBuffer);
+	}
+
+	static void TransitionImage(VkCommandBuffer commandBuffer, VkImage image, const VkImageLayout oldLayout, const VkImageLayout newLayout,
+		const VkAccessFlags srcAccess, const VkAccessFlags dstAccess, const VkPipelineStageFlags srcStage, const VkPipelineStageFlags dstStage)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u };
+
+		vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+	}
+
+	static VkFormat GetVertexFormat(const CGVertexFormat format)
+	{
+		switch (format)
+		{
+			case CGVertexFormat::None:	 break;
+			case CGVertexFormat::Float:  return VK_FORMAT_R32_SFLOAT;
+			case CGVertexFormat::Float2: return VK_FORMAT_R32G32_SFLOAT;
+			case CGVertexFormat::Float3: return VK_FORMAT_R32G32B32_SFLOAT;
+			case CGVertexFormat::Float4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+			case CGVertexFormat::UInt:	 return VK_FORMAT_R32_UINT;
+			case CGVertexFormat::UInt2:	 return VK_FORMAT_R32G32_UINT;
+			case CGVertexFormat::UInt3:	 return VK_FORMAT_R32G32B32_UINT;
+			case CGVertexFormat::UInt4:	 return VK_FORMAT_R32G32B32A32_UINT;
+		}
+
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	static constexpr VkPrimitiveTopology GetPrimitiveTopology(const CGPrimitiveTopology topology)
+	{
+		switch (topology)
+		{
+			case CGPrimitiveTopology::TriangleList:	 return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			case CGPrimitiveTopology::TriangleStrip: return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+			case CGPrimitiveTopology::LineList:		 return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			case CGPrimitiveTopology::LineStrip:	 return VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+			case CGPrimitiveTopology::PointList:	 return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+		}
+
+		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	}
+
+	static VkPipelineColorBlendAttachmentState GetBlendAttachment(const CGBlendState& blend)
+	{
+		VkPipelineColorBlendAttachmentState attachment = {};
+		attachment.blendEnable = blend.mode != CGBlendMode::Opaque ? VK_TRUE : VK_FALSE;
+		attachment.srcColorBlendFactor = blend.mode == CGBlendMode::Premultiplied ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_SRC_ALPHA;
+		attachment.dstColorBlendFactor = blend.mode == CGBlendMode::Additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		attachment.colorBlendOp = VK_BLEND_OP_ADD;
+		attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		attachment.dstAlphaBlendFactor = blend.mode == CGBlendMode::Additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		attachment.colorWriteMask = blend.writeMask; // Same bit order as VkColorComponentFlagBits
+
+		return attachment;
+	}
+
+	// The render pass has no depth attachment yet, so the depth state of the desc has nothing to apply to
+	static VkPipeline CreatePipeline(VulkanContext& ctx, const VulkanProgram& program, const CGVertexLayout& vLayout, const CGPipelineDesc& desc)
+	{
+		VkPipelineShaderStageCreateInfo stages[2] = {};
+		stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		stages[0].module = program.vertex;
+		stages[0].pName = "main";
+		stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		stages[1].module = program.fragment;
+		stages[1].pName = "main";
+
+		VkVertexInputBindingDescription binding = {};
+		binding.binding = 0u;
+		binding.stride = vLayout.size;
+		binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		VkVertexInputAttributeDescription attributes[CG_MAX_VERTEX_ELEMENTS] = {};
+
+		for (uint32_t i = 0u; i < vLayout.count; ++i)
+		{
+			attributes[i].location = i;
+			attributes[i].binding = 0u;
+			attributes[i].format = GetVertexFormat(vLayout.elements[i].format);
+			attributes[i].offset = vLayout.elements[i].offset;
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInput = {};
+		vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInput.vertexBindingDescriptionCount = 1u;
+		vertexInput.pVertexBindingDescriptions = &binding;
+		vertexInput.vertexAttributeDescriptionCount = vLayout.count;
+		vertexInput.pVertexAttributeDescriptions = attributes;
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = GetPrimitiveTopology(desc.topology);
+
+		VkPipelineViewportStateCreateInfo viewportState = {};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1u;
+		viewportState.scissorCount = 1u;
+
+		VkPipelineRasterizationStateCreateInfo rasterization = {};
+		rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterization.polygonMode = desc.raster.fill == CGFillMode::Wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+		rasterization.cullMode = desc.raster.cull == CGCullMode::Front ? VK_CULL_MODE_FRONT_BIT : desc.raster.cull == CGCullMode::Back ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+		rasterization.frontFace = desc.raster.frontClockwise ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterization.lineWidth = 1.0f;
+
+		VkPipelineMultisampleStateCreateInfo multisample = {};
+		multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		const VkPipelineColorBlendAttachmentState blendAttachment = GetBlendAttachment(desc.blend);
+
+		VkPipelineColorBlendStateCreateInfo colorBlend = {};
+		colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlend.attachmentCount = 1u;
+		colorBlend.pAttachments = &blendAttachment;
+
+		const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = sizeof(dynamicStates) / sizeof(dynamicStates[0]);
+		dynamicState.pDynamicStates = dynamicStates;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = 2u;
+		pipelineInfo.pStages = stages;
+		pipelineInfo.pVertexInputState = &vertexInput;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterization;
+		pipelineInfo.pMultisampleState = &multisample;
+		pipelineInfo.pColorBlendState = &colorBlend;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.layout = ctx.pipelineLayout;
+		pipelineInfo.renderPass = ctx.renderPass;
+		pipelineInfo.subpass = 0u;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+
+		// The pipeline cache turns repeated creations, also across runs, into cache hits
+		if (!Check(vkCreateGraphicsPipelines(ctx.device->device, ctx.device->pipelineCache, 1u, &pipelineInfo, nullptr, &pipeline), "vkCreateGraphicsPipelines"))
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		return pipeline;
+	}
+
+	static void SetViewport(const VulkanContext& ctx, VkCommandBuffer commandBuffer, const CGViewport& viewport)
+	{
+		// Negative height flips Y so clip space matches the GL and D3D backends
+		VkViewport vkViewport = {};
+		vkViewport.x = viewport.x;
+		vkViewport.y = viewport.y + viewport.height;
+		vkViewport.width = viewport.width;
+		vkViewport.height = -viewport.height;
+		vkViewport.minDepth = viewport.minDepth;
+		vkViewport.maxDepth = viewport.maxDepth;
+
+		VkRect2D scissor = {};
+		scissor.extent = { ctx.width, ctx.height };
+
+		vkCmdSetViewport(commandBuffer, 0u, 1u, &vkViewport);
+		vkCmdSetScissor(commandBuffer, 0u, 1u, &scissor);
+	}
+
+	// Records every command except ExecuteBundle, which is handled by the caller
+	static bool RecordCommand(VulkanContext& ctx, const CGRenderContext& context, const CGResourcePool& resourcePool, Recorder& recorder, const CGCommandHeader& header)
+	{
+		const CGBufferPool& bufferPool = resourcePool.bufferPool;
+
+		switch (static_cast<CGRenderCommandType>(header.type))
+		{
+			case CGRenderCommandType::None:
+			{
+				return true;
+			}
+			case CGRenderCommandType::SetViewClear:
+			{
+				const CGSetViewClearCommand& cmd = GetCommand<CGSetViewClearCommand>(header);
+
+				if (cmd.viewport < context.api.vulkan.viewportCount)
+				{
+					SetViewport(ctx, recorder.commandBuffer, context.api.vulkan.viewports[cmd.viewport]);
+				}
+
+				if (cmd.clearFlags & CG_CLEAR_COLOR)
+				{
+					VkClearAttachment attachment = {};
+					attachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					attachment.colorAttachment = 0u;
+					attachment.clearValue.color.float32[0] = ((cmd.color >> 24) & 0xFF) * CG_ONE_OVER_255;
+					attachment.clearValue.color.float32[1] = ((cmd.color >> 16) & 0xFF) * CG_ONE_OVER_255;
+					attachment.clearValue.color.float32[2] = ((cmd.color >> 8) & 0xFF) * CG_ONE_OVER_255;
+					attachment.clearValue.color.float32[3] = (cmd.color & 0xFF) * CG_ONE_OVER_255;
+
+					VkClearRect rect = {};
+					rect.rect.extent = { ctx.width, ctx.height };
+					rect.layerCount = 1u;
+
+					vkCmdClearAttachments(recorder.commandBuffer, 1u, &attachment, 1u, &rect);
+				}
+
+				return true;
+			}
+			case CGRenderCommandType::SetPipelineState:
+			{
+				const uint32_t pipeline = GetCommand<CGSetPipelineStateCommand>(header).pipeline;
+
+				if (pipeline >= resourcePool.pipelinePool.count)
+				{
+					return false;
+				}
+
+				// Pipelines are immutable objects in Vulkan, all of it is rebound once anything differs
+				const VkPipeline vkPipeline = GetVkHandle<VkPipeline>(resourcePool.pipelinePool.pipelines[pipeline].api.vulkan.pipeline);
+
+				if (vkPipeline != recorder.pipeline)
+				{
+					vkCmdBindPipeline(recorder.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline);
+					recorder.pipeline = vkPipeline;
+				}
+
+				return true;
+			}
+			case CGRenderCommandType::SetVertexShader:
+			case CGRenderCommandType::SetFragmentShader:
+			{
+				// Shaders are part of the pipeline
+				return true;
+			}
+			case CGRenderCommandType::SetVertexBuffer:
+			{
+				const CGSetVertexBufferCommand& cmd = GetCommand<CGSetVertexBufferCommand>(header);
+				const uint32_t buffer = cmd.buffer;
+
+				// Also rejects CG_TRANSIENT_BUFFER, there is no transient memory in Vulkan yet
+				if (buffer >= bufferPool.vbCount)
+				{
+					return false;
+				}
+
+				const VkBuffer vkBuffer = GetVkHandle<VkBuffer>(bufferPool.vertexBuffers[buffer].api.vulkan.buffer);
+				const VkDeviceSize offset = cmd.offset;
+
+				vkCmdBindVertexBuffers(recorder.commandBuffer, 0u, 1u, &vkBuffer, &offset);
+
+				return true;
+			}
+			case CGRenderCommandType::SetIndexBuffer:
+			{
+				const CGSetIndexBufferCommand& cmd = GetCommand<CGSetIndexBufferCommand>(header);
+				const uint32_t buffer = cmd.buffer;
+
+				if (buffer >= bufferPool.ibCount)
+				{
+					return false;
+				}
+
+				// 16-bit indices, same as the other backends
+				vkCmdBindIndexBuffer(recorder.commandBuffer, GetVkHandle<VkBuffer>(bufferPool.indexBuffers[buffer].api.vulkan.buffer), cmd.offset, VK_INDEX_TYPE_UINT16);
+
+				return true;
+			}
+			case CGRenderCommandType::Draw:
+			{
+				const CGDrawCommand& cmd = GetCommand<CGDrawCommand>(header);
+
+				if (recorder.pipeline == VK_NULL_HANDLE)
+				{
+					return false;
+				}
+
+				vkCmdDraw(recorder.commandBuffer, cmd.count, 1u, cmd.start, 0u);
+
+				return true;
+			}
+			case CGRenderCommandType::DrawIndexed:
+			{
+				if (recorder.pipeline == VK_NULL_HANDLE)
+				{
+					return false;
+				}
+
+				const CGDrawIndexedCommand& cmd = GetCommand<CGDrawIndexedCommand>(header);
+
+				vkCmdDrawIndexed(recorder.commandBuffer, cmd.count, 1u, cmd.start, cmd.baseVertex, 0u);
+
+				return true;
+			}
+			case CGRenderCommandType::ExecuteBundle:
+			{
+				return false;
+			}
+			case CGRenderCommandType::SetConstantBuffer:
+			case CGRenderCommandType::SetTexture:
+			case CGRenderCommandType::SetSampler:
+			{
+				// Needs descriptor sets in the pipeline layouts, not there yet
+				return false;
+			}
+		}
+
+		return false;
+	}
+
+	static void BeginRenderPass(const VulkanContext& ctx, const VulkanFrame& frame, const VkSubpassContents contents)
+	{
+		VkRenderPassBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		beginInfo.renderPass = ctx.renderPass;
+		beginInfo.framebuffer = frame.framebuffer;
+		beginInfo.renderArea.extent = { ctx.width, ctx.height };
+
+		vkCmdBeginRenderPass(frame.commandBuffer, &beginInfo, contents);
+	}
+
+	static bool CreateInstance(const bool debug, const bool headless, VulkanDevice& vk)
+	{
+		const char* extensions[16] = {};
+		uint32_t extensionCount = 0u;
+
+		if (!headless)
+		{
+			uint32_t glfwCount = 0u;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwCount);
+
+			for (uint32_t i = 0u; i < glfwCount && extensionCount < 15u; ++i)
+			{
+				extensions[extensionCount++] = glfwExtensions[i];
+			}
+		}
+
+		const char* validationLayer = "VK_LAYER_KHRONOS_validation";
+		bool validation = false;
+
+		if (debug)
+		{
+			uint32_t layerCount = 0u;
+			vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+			VkLayerProperties layers[64] = {};
+			layerCount = layerCount > 64u ? 64u : layerCount;
+			vkEnumerateInstanceLayerProperties(&layerCount, layers);
+
+			for (uint32_t i = 0u; i < layerCount; ++i)
+			{
+				validation |= std::strcmp(layers[i].layerName, validationLayer) == 0;
+			}
+
+			if (validation)
+			{
+				extensions[extensionCount++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+			}
+		}
+
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "CGEngine";
+		appInfo.pEngineName = "CGEngine";
+		appInfo.apiVersion = VK_API_VERSION_1_1; // Negative viewport heights are core in 1.1
+
+		VkInstanceCreateInfo instanceInfo = {};
+		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instanceInfo.pApplicationInfo = &appInfo;
+		instanceInfo.enabledExtensionCount = extensionCount;
+		instanceInfo.ppEnabledExtensionNames = extensions;
+		instanceInfo.enabledLayerCount = validation ? 1u : 0u;
+		instanceInfo.ppEnabledLayerNames = validation ? &validationLayer : nullptr;
+
+		if (!Check(vkCreateInstance(&instanceInfo, nullptr, &vk.instance), "vkCreateInstance"))
+		{
+			return false;
+		}
+
+		if (validation)
+		{
+			VkDebugUtilsMessengerCreateInfoEXT messengerInfo = {};
+			messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+			messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+			messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+			messengerInfo.pfnUserCallback = DebugMessageCallback;
+
+			const auto createMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(vk.instance, "vkCreateDebugUtilsMessengerEXT"));
+
+			if (createMessenger)
+			{
+				createMessenger(vk.instance, &messengerInfo, nullptr, &vk.messenger);
+			}
+		}
+
+		return true;
+	}
+
+	// Prefers discrete over integrated GPUs, CPU implementations such as lavapipe are accepted last
+	static bool SelectPhysicalDevice(VulkanDevice& vk, VkSurfaceKHR surface)
+	{
+		VkPhysicalDevice devices[16] = {};
+		uint32_t deviceCount = 16u;
+		vkEnumeratePhysicalDevices(vk.instance, &deviceCount, devices);
+
+		int32_t bestScore = -1;
+
+		for (uint32_t i = 0u; i < deviceCount; ++i)
+		{
+			VkQueueFamilyProperties families[16] = {};
+			uint32_t familyCount = 16u;
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, families);
+
+			for (uint32_t f = 0u; f < familyCount; ++f)
+			{
+				if (!(families[f].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				{
+					continue;
+				}
+
+				if (surface != VK_NULL_HANDLE)
+				{
+					VkBool32 present = VK_FALSE;
+					vkGetPhysicalDeviceSurfaceSupportKHR(devices[i], f, surface, &present);
+
+					if (!present)
+					{
+						continue;
+					}
+				}
+
+				VkPhysicalDeviceProperties properties = {};
+				vkGetPhysicalDeviceProperties(devices[i], &properties);
+
+				int32_t score = 0;
+				switch (properties.deviceType)
+				{
+					case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:	 score = 4; break;
+					case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score = 3; break;
+					case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:	 score = 2; break;
+					case VK_PHYSICAL_DEVICE_TYPE_CPU:			 score = 1; break;
+					default:									 score = 0; break;
+				}
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					vk.physicalDevice = devices[i];
+					vk.properties = properties;
+					vk.queueFamily = f;
+				}
+
+				break;
+			}
+		}
+
+		if (vk.physicalDevice == VK_NULL_HANDLE)
+		{
+			printf("Vulkan Error: no device with a graphics queue\n");
+			return false;
+		}
+
+		vkGetPhysicalDeviceMemoryProperties(vk.physicalDevice, &vk.memoryProperties);
+
+		return true;
+	}
+
+	static bool CreateLogicalDevice(const bool headless, VulkanDevice& vk)
+	{
+		const float priority = 1.0f;
+
+		VkDeviceQueueCreateInfo queueInfo = {};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = vk.queueFamily;
+		queueInfo.queueCount = 1u;
+		queueInfo.pQueuePriorities = &priority;
+
+		const char* swapchainExtension = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+
+		VkDeviceCreateInfo deviceInfo = {};
+		deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceInfo.queueCreateInfoCount = 1u;
+		deviceInfo.pQueueCreateInfos = &queueInfo;
+		deviceInfo.enabledExtensionCount = headless ? 0u : 1u;
+		deviceInfo.ppEnabledExtensionNames = headless ? nullptr : &swapchainExtension;
+
+		if (!Check(vkCreateDevice(vk.physicalDevice, &deviceInfo, nullptr, &vk.device), "vkCreateDevice"))
+		{
+			return false;
+		}
+
+		vkGetDeviceQueue(vk.device, vk.queueFamily, 0u, &vk.queue);
+
+		return true;
+	}
+
+	static bool CreatePipelineCache(VulkanDevice& vk)
+	{
+		const io::CGFile file = io::ReadFile(PIPELINE_CACHE_PATH);
+
+		VkPipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		// Only reuse data written by this exact device and driver, the header is defined by the spec
+		const size_t headerSize = 16u + VK_UUID_SIZE;
+
+		if (file.data && file.size > headerSize)
+		{
+			uint32_t vendorId = 0u;
+			uint32_t deviceId = 0u;
+			std::memcpy(&vendorId, file.data.get() + 8u, sizeof(uint32_t));
+			std::memcpy(&deviceId, file.data.get() + 12u, sizeof(uint32_t));
+
+			if (vendorId == vk.properties.vendorID && deviceId == vk.properties.deviceID &&
+				std::memcmp(file.data.get() + 16u, vk.properties.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+			{
+				cacheInfo.initialDataSize = file.size;
+				cacheInfo.pInitialData = file.data.get();
+			}
+		}
+
+		return Check(vkCreatePipelineCache(vk.device, &cacheInfo, nullptr, &vk.pipelineCache), "vkCreatePipelineCache");
+	}
+
+	static bool CreateRenderPass(VulkanContext& ctx)
+	{
+		// Targets stay in COLOR_ATTACHMENT_OPTIMAL between frames and are loaded, clears are explicit commands
+		VkAttachmentDescription attachment = {};
+		attachment.format = COLOR_FORMAT;
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorReference = {};
+		colorReference.attachment = 0u;
+		colorReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1u;
+		subpass.pColorAttachments = &colorReference;
+
+		// Orders each render pass instance after the previous one and after the blit that read the target
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0u;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = 1u;
+		renderPassInfo.pAttachments = &attachment;
+		renderPassInfo.subpassCount = 1u;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 1u;
+		renderPassInfo.pDependencies = &dependency;
+
+		return Check(vkCreateRenderPass(ctx.device->device, &renderPassInfo, nullptr, &ctx.renderPass), "vkCreateRenderPass");
+	}
+
+	static bool CreateFrame(VulkanContext& ctx, VulkanFrame& frame)
+	{
+		const VulkanDevice& vk = *ctx.device;
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = COLOR_FORMAT;
+		imageInfo.extent = { ctx.width, ctx.height, 1u };
+		imageInfo.mipLevels = 1u;
+		imageInfo.arrayLayers = 1u;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (!Check(vkCreateImage(vk.device, &imageInfo, nullptr, &frame.image), "vkCreateImage"))
+		{
+			return false;
+		}
+
+		VkMemoryRequirements requirements = {};
+		vkGetImageMemoryRequirements(vk.device, frame.image, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+
+		if (!FindMemoryType(vk, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocInfo.memoryTypeIndex) ||
+			!Check(vkAllocateMemory(vk.device, &allocInfo, nullptr, &frame.memory), "vkAllocateMemory"))
+		{
+			return false;
+		}
+
+		vkBindImageMemory(vk.device, frame.image, frame.memory, 0u);
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = frame.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = COLOR_FORMAT;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u };
+
+		if (!Check(vkCreateImageView(vk.device, &viewInfo, nullptr, &frame.view), "vkCreateImageView"))
+		{
+			return false;
+		}
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = ctx.renderPass;
+		framebufferInfo.attachmentCount = 1u;
+		framebufferInfo.pAttachments = &frame.view;
+		framebufferInfo.width = ctx.width;
+		framebufferInfo.height = ctx.height;
+		framebufferInfo.layers = 1u;
+
+		if (!Check(vkCreateFramebuffer(vk.device, &framebufferInfo, nullptr, &frame.framebuffer), "vkCreateFramebuffer"))
+		{
+			return false;
+		}
+
+		VkCommandBufferAllocateInfo commandInfo = {};
+		commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandInfo.commandPool = ctx.commandPool;
+		commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandInfo.commandBufferCount = 1u;
+
+		if (!Check(vkAllocateCommandBuffers(vk.device, &commandInfo, &frame.commandBuffer), "vkAllocateCommandBuffers"))
+		{
+			return false;
+		}
+
+		// Signaled so the first wait on every frame slot returns immediately
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		return Check(vkCreateFence(vk.device, &fenceInfo, nullptr, &frame.fence), "vkCreateFence") &&
+			   Check(vkCreateSemaphore(vk.device, &semaphoreInfo, nullptr, &frame.imageAvailable), "vkCreateSemaphore") &&
+			   Check(vkCreateSemaphore(vk.device, &semaphoreInfo, nullptr, &frame.renderFinished), "vkCreateSemaphore");
+	}
+
+	static bool CreateSwapchain(VulkanContext& ctx)
+	{
+		const VulkanDevice& vk = *ctx.device;
+
+		VkSurfaceCapabilitiesKHR capabilities = {};
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vk.physicalDevice, ctx.surface, &capabilities);
+
+		VkSurfaceFormatKHR formats[32] = {};
+		uint32_t formatCount = 32u;
+		vkGetPhysicalDeviceSurfaceFormatsKHR(vk.physicalDevice, ctx.surface, &formatCount, formats);
+
+		if (formatCount == 0u || !(capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+		{
+			printf("Vulkan Error: surface cannot be blitted to\n");
+			return false;
+		}
+
+		// Any format works, the blit from the offscreen target converts
+		VkSurfaceFormatKHR surfaceFormat = formats[0];
+
+		for (uint32_t i = 0u; i < formatCount; ++i)
+		{
+			if (formats[i].format == VK_FORMAT_B8G8R8A8_UNORM || formats[i].format == VK_FORMAT_R8G8B8A8_UNORM)
+			{
+				surfaceFormat = formats[i];
+				break;
+			}
+		}
+
+		uint32_t imageCount = capabilities.minImageCount + 1u;
+
+		if (capabilities.maxImageCount > 0u && imageCount > capabilities.maxImageCount)
+		{
+			imageCount = capabilities.maxImageCount;
+		}
+
+		VkSwapchainCreateInfoKHR swapchainInfo = {};
+		swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		swapchainInfo.surface = ctx.surface;
+		swapchainInfo.minImageCount = imageCount;
+		swapchainInfo.imageFormat = surfaceFormat.format;
+		swapchainInfo.imageColorSpace = surfaceFormat.colorSpace;
+		swapchainInfo.imageExtent = capabilities.currentExtent.width != UINT32_MAX ? capabilities.currentExtent : VkExtent2D{ ctx.width, ctx.height };
+		swapchainInfo.imageArrayLayers = 1u;
+		swapchainInfo.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		swapchainInfo.preTransform = capabilities.currentTransform;
+		swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		swapchainInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		swapchainInfo.clipped = VK_TRUE;
+
+		if (!Check(vkCreateSwapchainKHR(vk.device, &swapchainInfo, nullptr, &ctx.swapchain), "vkCreateSwapchainKHR"))
+		{
+			return false;
+		}
+
+		ctx.swapchainImageCount = MAX_SWAPCHAIN_IMAGES;
+		const VkResult result = vkGetSwapchainImagesKHR(vk.device, ctx.swapchain, &ctx.swapchainImageCount, ctx.swapchainImages);
+
+		return result == VK_SUCCESS || result == VK_INCOMPLETE;
+	}
+
+	static bool CreateContext(const core::CGWindow& window, VulkanContext& ctx)
+	{
+		const VulkanDevice& vk = *ctx.device;
+
+		ctx.width = static_cast<uint32_t>(window.width);
+		ctx.height = static_cast<uint32_t>(window.height);
+
+		if (!CreateRenderPass(ctx))
+		{
+			return false;
+		}
+
+		VkPipelineLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+		if (!Check(vkCreatePipelineLayout(vk.device, &layoutInfo, nullptr, &ctx.pipelineLayout), "vkCreatePipelineLayout"))
+		{
+			return false;
+		}
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = vk.queueFamily;
+
+		if (!Check(vkCreateCommandPool(vk.device, &poolInfo, nullptr, &ctx.commandPool), "vkCreateCommandPool") ||
+			!Check(vkCreateCommandPool(vk.device, &poolInfo, nullptr, &ctx.setupCommandPool), "vkCreateCommandPool"))
+		{
+			return false;
+		}
+
+		for (VulkanFrame& frame : ctx.frames)
+		{
+			if (!CreateFrame(ctx, frame))
+			{
+				return false;
+			}
+		}
+
+		// Move every target into the layout the render pass expects
+		VkCommandBuffer commandBuffer = BeginOneTimeCommands(ctx);
+
+		if (commandBuffer == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		for (const VulkanFrame& frame : ctx.frames)
+		{
+			TransitionImage(commandBuffer, frame.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				0u, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+
+		EndOneTimeCommands(ctx, commandBuffer);
+
+		return ctx.surface == VK_NULL_HANDLE || CreateSwapchain(ctx);
+	}
+
+	static int InitHeadless()
+	{
+		return 1;
+	}
+
+	static void ShutdownHeadless()
+	{
+	}
+
+	bool Init(const bool debug, const bool headless, CGRenderFunctions& functions)
+	{
+		(void)debug;
+
+		// Headless devices never touch the window system, which may not exist at all
+		if (headless)
+		{
+			functions.init = InitHeadless;
+			functions.shutdown = ShutdownHeadless;
+
+			return true;
+		}
+
+		functions.init = glfwInit;
+		functions.shutdown = glfwTerminate;
+
+		if (!functions.init())
+		{
+			return false;
+		}
+
+		if (!glfwVulkanSupported())
+		{
+			printf("GLFW Error: Vulkan loader not found");
+			return false;
+		}
+
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+		return true;
+	}
+
+	bool CreateDeviceAndContext(const bool debug, const bool headless, const core::CGWindow& window, CGRenderDevice& device, CGRenderContext& context)
+	{
+		if (window.width < 1 || window.height < 1)
+		{
+			return false;
+		}
+
+		VulkanDevice* vk = new (std::nothrow) VulkanDevice();
+		VulkanContext* ctx = new (std::nothrow) VulkanContext();
+
+		if (!vk || !ctx)
+		{
+			delete vk;
+			delete ctx;
+
+			return false;
+		}
+
+		device.api.vulkan.device = vk;
+		context.api.vulkan = {};
+		context.api.vulkan.context = ctx;
+		context.device = &device;
+		ctx->device = vk;
+
+		if (!CreateInstance(debug, headless, *vk))
+		{
+			return false;
+		}
+
+		if (!headless && !Check(glfwCreateWindowSurface(vk->instance, static_cast<GLFWwindow*>(window.winptr), nullptr, &ctx->surface), "glfwCreateWindowSurface"))
+		{
+			return false;
+		}
+
+		if (!SelectPhysicalDevice(*vk, ctx->surface) || !CreateLogicalDevice(headless, *vk) || !CreatePipelineCache(*vk))
+		{
+			return false;
+		}
+
+		if (!CreateContext(window, *ctx))
+		{
+			return false;
+		}
+
+		device.deviceInfo.adapterName = vk->properties.deviceName;
+		device.deviceInfo.vendorId = vk->properties.vendorID;
+		device.deviceInfo.isDiscrete = vk->properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+
+		printf("Vulkan Context Info:\n\n");
+		printf("  Debug: %s\n", debug ? "True" : "False");
+		printf("  Physical Adapter: %s\n", device.deviceInfo.adapterName);
+		printf("  API Version: %u.%u.%u\n", VK_VERSION_MAJOR(vk->properties.apiVersion), VK_VERSION_MINOR(vk->properties.apiVersion), VK_VERSION_PATCH(vk->properties.apiVersion));
+		printf("  Headless: %s\n", headless ? "True" : "False");
+
+		return true;
+	}
+
+	void DestroyDevice(CGRenderDevice& device)
+	{
+		VulkanDevice* vk = GetDevice(device);
+
+		if (!vk)
+		{
+			return;
+		}
+
+		if (vk->pipelineCache != VK_NULL_HANDLE)
+		{
+			size_t size = 0u;
+			vkGetPipelineCacheData(vk->device, vk->pipelineCache, &size, nullptr);
+
+			std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[size]);
+
+			if (data && vkGetPipelineCacheData(vk->device, vk->pipelineCache, &size, data.get()) == VK_SUCCESS)
+			{
+				io::WriteFile(PIPELINE_CACHE_PATH, data.get(), size);
+			}
+
+			vkDestroyPipelineCache(vk->device, vk->pipelineCache, nullptr);
+		}
+
+		if (vk->device != VK_NULL_HANDLE)
+		{
+			vkDestroyDevice(vk->device, nullptr);
+		}
+
+		if (vk->messenger != VK_NULL_HANDLE)
+		{
+			const auto destroyMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(vk->instance, "vkDestroyDebugUtilsMessengerEXT"));
+
+			if (destroyMessenger)
+			{
+				destroyMessenger(vk->instance, vk->messenger, nullptr);
+			}
+		}
+
+		if (vk->instance != VK_NULL_HANDLE)
+		{
+			vkDestroyInstance(vk->instance, nullptr);
+		}
+
+		delete vk;
+		device.api.vulkan.device = nullptr;
+	}
+
+	namespace DeviceOps
+	{
+		bool CreateShader(const CGRenderDevice& device, const CGShaderDesc& desc, CGShader& shader)
+		{
+			const VulkanDevice* vk = GetDevice(device);
+
+			if (!vk || !desc.filename)
+			{
+				return false;
+			}
+
+			const io::CGFile file = io::ReadFile(desc.filename);
+
+			if (!file.data || file.size == 0u || file.size % sizeof(uint32_t) != 0u)
+			{
+				printf("Vulkan Error: %s is not SPIR-V\n", desc.filename);
+				return false;
+			}
+
+			VkShaderModuleCreateInfo moduleInfo = {};
+			moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			moduleInfo.codeSize = file.size;
+			moduleInfo.pCode = reinterpret_cast<const uint32_t*>(file.data.get());
+
+			VkShaderModule module = VK_NULL_HANDLE;
+
+			if (!Check(vkCreateShaderModule(vk->device, &moduleInfo, nullptr, &module), "vkCreateShaderModule"))
+			{
+				return false;
+			}
+
+			shader.type = desc.shaderType;
+			shader.api.vulkan.module = ToVkHandle(module);
+
+			return true;
+		}
+
+		bool CreateShaderProgram(CGRenderContext& context, const uint8_t shaderCount, const CGShader shaders[], uint32_t& program)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx || ctx->programCount + 1u > CG_MAX_SHADER_PROGRAMS)
+			{
+				return false;
+			}
+
+			VulkanProgram linked = {};
+
+			for (uint8_t i = 0u; i < shaderCount; ++i)
+			{
+				if (shaders[i].type == CGShaderType::Vertex)
+				{
+					linked.vertex = GetVkHandle<VkShaderModule>(shaders[i].api.vulkan.module);
+				}
+				else if (shaders[i].type == CGShaderType::Fragment)
+				{
+					linked.fragment = GetVkHandle<VkShaderModule>(shaders[i].api.vulkan.module);
+				}
+			}
+
+			if (linked.vertex == VK_NULL_HANDLE || linked.fragment == VK_NULL_HANDLE)
+			{
+				return false;
+			}
+
+			// Pipelines are built by CreatePipelineState, which also knows the vertex layout
+			ctx->programs[ctx->programCount] = linked;
+			ctx->programCount++;
+
+			// Names start at 1 like GL programs, 0 stays "no program"
+			program = ctx->programCount;
+
+			return true;
+		}
+
+		bool CreatePipelineState(CGRenderContext& context, const CGBufferPool& bufferPool, CGPipelineState& pipeline)
+		{
+			VulkanContext* ctx = GetContext(context);
+			const CGPipelineDesc& desc = pipeline.desc;
+
+			if (!ctx || desc.program == 0u || desc.program > ctx->programCount || desc.vertexLayout >= bufferPool.vlCount)
+			{
+				return false;
+			}
+
+			VkPipeline vkPipeline = CreatePipeline(*ctx, ctx->programs[desc.program - 1u], bufferPool.vertexLayouts[desc.vertexLayout], desc);
+
+			if (vkPipeline == VK_NULL_HANDLE)
+			{
+				return false;
+			}
+
+			pipeline.api.vulkan.pipeline = ToVkHandle(vkPipeline);
+
+			return true;
+		}
+
+		static bool CreateBuffer(const CGRenderDevice& device, const CGBufferDesc& desc, const VkBufferUsageFlags usage, CGBuffer& buffer, const void* data)
+		{
+			const VulkanDevice* vk = GetDevice(device);
+
+			if (!vk || desc.size == 0u)
+			{
+				return false;
+			}
+
+			VkBuffer vkBuffer = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+
+			if (!Vulkan::CreateBuffer(*vk, desc.size, usage, vkBuffer, memory))
+			{
+				return false;
+			}
+
+			if (data)
+			{
+				void* mapped = nullptr;
+
+				if (Check(vkMapMemory(vk->device, memory, 0u, desc.size, 0u, &mapped), "vkMapMemory"))
+				{
+					std::memcpy(mapped, data, desc.size);
+					vkUnmapMemory(vk->device, memory);
+				}
+			}
+
+			buffer.api.vulkan.buffer = ToVkHandle(vkBuffer);
+			buffer.api.vulkan.memory = ToVkHandle(memory);
+
+			return true;
+		}
+
+		bool CreateVertexBuffer(const CGRenderDevice& device, const CGBufferDesc& vbDesc, CGBuffer& vBuffer, const void* vbData)
+		{
+			return CreateBuffer(device, vbDesc, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vBuffer, vbData);
+		}
+
+		bool CreateIndexBuffer(const CGRenderDevice& device, const CGBufferDesc& ibDesc, CGBuffer& iBuffer, const void* ibData)
+		{
+			return CreateBuffer(device, ibDesc, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, iBuffer, ibData);
+		}
+
+		void DestroyBuffer(const CGRenderDevice& device, CGBuffer& buffer)
+		{
+			const VulkanDevice* vk = GetDevice(device);
+
+			if (vk && vk->device != VK_NULL_HANDLE)
+			{
+				vkDestroyBuffer(vk->device, GetVkHandle<VkBuffer>(buffer.api.vulkan.buffer), nullptr);
+				vkFreeMemory(vk->device, GetVkHandle<VkDeviceMemory>(buffer.api.vulkan.memory), nullptr);
+			}
+
+			buffer.api.vulkan = {};
+		}
+
+		void DestroyResources(const CGRenderDevice& device, CGResourcePool& resourcePool)
+		{
+			const VulkanDevice* vk = GetDevice(device);
+
+			if (!vk || vk->device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+
+			vkDeviceWaitIdle(vk->device);
+
+			CGBufferPool& bufferPool = resourcePool.bufferPool;
+			CGShaderPool& shaderPool = resourcePool.shaderPool;
+
+			for (uint32_t i = 0u; i < bufferPool.vbCount; ++i)
+			{
+				DestroyBuffer(device, bufferPool.vertexBuffers[i]);
+			}
+
+			for (uint32_t i = 0u; i < bufferPool.ibCount; ++i)
+			{
+				DestroyBuffer(device, bufferPool.indexBuffers[i]);
+			}
+
+			for (uint8_t i = 0u; i < shaderPool.vsCount; ++i)
+			{
+				vkDestroyShaderModule(vk->device, GetVkHandle<VkShaderModule>(shaderPool.vertexShaders[i].api.vulkan.module), nullptr);
+			}
+
+			for (uint8_t i = 0u; i < shaderPool.fsCount; ++i)
+			{
+				vkDestroyShaderModule(vk->device, GetVkHandle<VkShaderModule>(shaderPool.fragmentShaders[i].api.vulkan.module), nullptr);
+			}
+
+			for (uint32_t i = 0u; i < resourcePool.pipelinePool.count; ++i)
+			{
+				CGPipelineState& pipeline = resourcePool.pipelinePool.pipelines[i];
+
+				vkDestroyPipeline(vk->device, GetVkHandle<VkPipeline>(pipeline.api.vulkan.pipeline), nullptr);
+				pipeline.api.vulkan = {};
+			}
+		}
+	}
+
+	namespace ContextOps
+	{
+		bool CreateViewport(const int32_t width, const int32_t height, CGViewport& viewport)
+		{
+			viewport.x = 0.0f;
+			viewport.y = 0.0f;
+			viewport.width = static_cast<float>(width);
+			viewport.height = static_cast<float>(height);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+
+			return true;
+		}
+
+		void ExecuteRenderCommands(CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandPool& cmdPool)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx || ctx->recording)
+			{
+				return;
+			}
+
+			const VulkanDevice& vk = *ctx->device;
+			VulkanFrame& frame = ctx->frames[ctx->frameIndex];
+
+			// The slot is free again once the GPU retired the frame that last used it
+			vkWaitForFences(vk.device, 1u, &frame.fence, VK_TRUE, UINT64_MAX);
+
+			vkResetCommandBuffer(frame.commandBuffer, 0u);
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
+			BeginRenderPass(*ctx, frame, VK_SUBPASS_CONTENTS_INLINE);
+
+			Recorder recorder = {};
+			recorder.commandBuffer = frame.commandBuffer;
+
+			if (context.api.vulkan.viewportCount > 0u)
+			{
+				SetViewport(*ctx, frame.commandBuffer, context.api.vulkan.viewports[0]);
+			}
+
+			const CGCommandStream& stream = cmdPool.stream;
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			// Pools that were never sorted execute in submission order
+			const uint32_t* order = cmdPool.order.size == stream.packetCount * sizeof(uint32_t) ? ArenaOps::GetData<uint32_t>(cmdPool.order) : nullptr;
+
+			for (uint32_t p = 0u; p < stream.packetCount; ++p)
+			{
+				const CGRenderPacket& packet = packets[order ? order[p] : p];
+
+				const uint8_t* cursor = commands + packet.offset;
+				const uint8_t* end = cursor + packet.size;
+
+				while (cursor < end)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					if (static_cast<CGRenderCommandType>(header.type) != CGRenderCommandType::ExecuteBundle)
+					{
+						RecordCommand(*ctx, context, resourcePool, recorder, header);
+						continue;
+					}
+
+					const CGExecuteBundleCommand& cmd = GetCommand<CGExecuteBundleCommand>(header);
+
+					if (cmd.bundle >= resourcePool.bundlePool.count || resourcePool.bundlePool.bundles[cmd.bundle].count < 1u)
+					{
+						continue;
+					}
+
+					// A render pass instance takes either inline or secondary commands, so the
+					// bundle gets one of its own. The targets are loaded, nothing is lost.
+					VkCommandBuffer secondary = *ArenaOps::GetData<VkCommandBuffer>(resourcePool.bundlePool.bundles[cmd.bundle].ops);
+
+					vkCmdEndRenderPass(frame.commandBuffer);
+					BeginRenderPass(*ctx, frame, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					vkCmdExecuteCommands(frame.commandBuffer, 1u, &secondary);
+					vkCmdEndRenderPass(frame.commandBuffer);
+					BeginRenderPass(*ctx, frame, VK_SUBPASS_CONTENTS_INLINE);
+
+					// Dynamic state and bindings do not carry over from the bundle
+					recorder.pipeline = VK_NULL_HANDLE;
+
+					if (context.api.vulkan.viewportCount > 0u)
+					{
+						SetViewport(*ctx, frame.commandBuffer, context.api.vulkan.viewports[0]);
+					}
+				}
+			}
+
+			vkCmdEndRenderPass(frame.commandBuffer);
+
+			ctx->recording = true;
+		}
+
+		bool CompileBundle(const CGRenderContext& context, const CGResourcePool& resourcePool, const CGCommandStream& stream, CGRenderBundle& bundle)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx)
+			{
+				return false;
+			}
+
+			const VulkanDevice& vk = *ctx->device;
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = ctx->setupCommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1u;
+
+			VkCommandBuffer secondary = VK_NULL_HANDLE;
+
+			if (!Check(vkAllocateCommandBuffers(vk.device, &allocInfo, &secondary), "vkAllocateCommandBuffers"))
+			{
+				return false;
+			}
+
+			// Valid inside any render pass instance of the context, whichever frame it targets
+			VkCommandBufferInheritanceInfo inheritance = {};
+			inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritance.renderPass = ctx->renderPass;
+			inheritance.subpass = 0u;
+			inheritance.framebuffer = VK_NULL_HANDLE;
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+			beginInfo.pInheritanceInfo = &inheritance;
+
+			vkBeginCommandBuffer(secondary, &beginInfo);
+
+			Recorder recorder = {};
+			recorder.commandBuffer = secondary;
+
+			if (context.api.vulkan.viewportCount > 0u)
+			{
+				SetViewport(*ctx, secondary, context.api.vulkan.viewports[0]);
+			}
+
+			const CGRenderPacket* packets = ArenaOps::GetData<CGRenderPacket>(stream.packets);
+			const uint8_t* commands = ArenaOps::GetData<uint8_t>(stream.commands);
+
+			bool valid = true;
+			uint32_t count = 0u;
+
+			// Bundles replay in recorded order, packets are not sorted
+			for (uint32_t p = 0u; p < stream.packetCount && valid; ++p)
+			{
+				const uint8_t* cursor = commands + packets[p].offset;
+				const uint8_t* end = cursor + packets[p].size;
+
+				while (cursor < end && valid)
+				{
+					const CGCommandHeader& header = *reinterpret_cast<const CGCommandHeader*>(cursor);
+					cursor += header.size;
+
+					// Unsupported or nested commands make the whole bundle invalid
+					valid = RecordCommand(*ctx, context, resourcePool, recorder, header);
+					count++;
+				}
+			}
+
+			vkEndCommandBuffer(secondary);
+
+			if (!valid)
+			{
+				vkFreeCommandBuffers(vk.device, ctx->setupCommandPool, 1u, &secondary);
+				return false;
+			}
+
+			ArenaOps::Reset(bundle.ops);
+
+			void* op = ArenaOps::Allocate(sizeof(VkCommandBuffer), bundle.ops);
+
+			if (!op)
+			{
+				vkFreeCommandBuffers(vk.device, ctx->setupCommandPool, 1u, &secondary);
+				return false;
+			}
+
+			std::memcpy(op, &secondary, sizeof(VkCommandBuffer));
+			bundle.count = count;
+
+			return true;
+		}
+
+		bool ReadFramebuffer(const CGRenderContext& context, void* pixels)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx || !pixels || !ctx->submitted)
+			{
+				return false;
+			}
+
+			const VulkanDevice& vk = *ctx->device;
+			const VulkanFrame& frame = ctx->frames[ctx->lastFrame];
+			const VkDeviceSize size = static_cast<VkDeviceSize>(ctx->width) * ctx->height * 4u;
+
+			VkBuffer staging = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+
+			if (!CreateBuffer(vk, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, staging, memory))
+			{
+				return false;
+			}
+
+			vkWaitForFences(vk.device, 1u, &frame.fence, VK_TRUE, UINT64_MAX);
+
+			VkCommandBuffer commandBuffer = BeginOneTimeCommands(*ctx);
+
+			if (commandBuffer != VK_NULL_HANDLE)
+			{
+				TransitionImage(commandBuffer, frame.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+				VkBufferImageCopy region = {};
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u };
+				region.imageExtent = { ctx->width, ctx->height, 1u };
+
+				vkCmdCopyImageToBuffer(commandBuffer, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging, 1u, &region);
+
+				TransitionImage(commandBuffer, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+					VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+				EndOneTimeCommands(*ctx, commandBuffer);
+			}
+
+			void* mapped = nullptr;
+			const bool read = commandBuffer != VK_NULL_HANDLE && Check(vkMapMemory(vk.device, memory, 0u, size, 0u, &mapped), "vkMapMemory");
+
+			if (read)
+			{
+				std::memcpy(pixels, mapped, static_cast<size_t>(size));
+				vkUnmapMemory(vk.device, memory);
+			}
+
+			vkDestroyBuffer(vk.device, staging, nullptr);
+			vkFreeMemory(vk.device, memory, nullptr);
+
+			return read;
+		}
+
+		void DestroyContext(CGRenderContext& context)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx)
+			{
+				return;
+			}
+
+			const VulkanDevice& vk = *ctx->device;
+
+			if (vk.device != VK_NULL_HANDLE)
+			{
+				vkDeviceWaitIdle(vk.device);
+
+				for (VulkanFrame& frame : ctx->frames)
+				{
+					vkDestroySemaphore(vk.device, frame.renderFinished, nullptr);
+					vkDestroySemaphore(vk.device, frame.imageAvailable, nullptr);
+					vkDestroyFence(vk.device, frame.fence, nullptr);
+					vkDestroyFramebuffer(vk.device, frame.framebuffer, nullptr);
+					vkDestroyImageView(vk.device, frame.view, nullptr);
+					vkDestroyImage(vk.device, frame.image, nullptr);
+					vkFreeMemory(vk.device, frame.memory, nullptr);
+				}
+
+				// Also frees every frame and bundle command buffer
+				vkDestroyCommandPool(vk.device, ctx->setupCommandPool, nullptr);
+				vkDestroyCommandPool(vk.device, ctx->commandPool, nullptr);
+				vkDestroyPipelineLayout(vk.device, ctx->pipelineLayout, nullptr);
+				vkDestroyRenderPass(vk.device, ctx->renderPass, nullptr);
+
+				if (ctx->swapchain != VK_NULL_HANDLE)
+				{
+					vkDestroySwapchainKHR(vk.device, ctx->swapchain, nullptr);
+				}
+			}
+
+			if (ctx->surface != VK_NULL_HANDLE)
+			{
+				vkDestroySurfaceKHR(vk.instance, ctx->surface, nullptr);
+			}
+
+			delete ctx;
+			context.api.vulkan.context = nullptr;
+		}
+	}
+
+	namespace FrameOps
+	{
+		void EndFrame(const CGRenderContext& context)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx || !ctx->recording)
+			{
+				return;
+			}
+
+			const VulkanDevice& vk = *ctx->device;
+			VulkanFrame& frame = ctx->frames[ctx->frameIndex];
+
+			ctx->acquired = false;
+
+			if (ctx->swapchain != VK_NULL_HANDLE)
+			{
+				const VkResult result = vkAcquireNextImageKHR(vk.device, ctx->swapchain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &ctx->imageIndex);
+				ctx->acquired = result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+			}
+
+			if (ctx->acquired)
+			{
+				VkImage target = ctx->swapchainImages[ctx->imageIndex];
+
+				TransitionImage(frame.commandBuffer, frame.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+				TransitionImage(frame.commandBuffer, target, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					0u, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+				VkImageBlit blit = {};
+				blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u };
+				blit.srcOffsets[1] = { static_cast<int32_t>(ctx->width), static_cast<int32_t>(ctx->height), 1 };
+				blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u };
+				blit.dstOffsets[1] = { static_cast<int32_t>(ctx->width), static_cast<int32_t>(ctx->height), 1 };
+
+				vkCmdBlitImage(frame.commandBuffer, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &blit, VK_FILTER_NEAREST);
+
+				TransitionImage(frame.commandBuffer, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+					VK_ACCESS_TRANSFER_WRITE_BIT, 0u, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+				TransitionImage(frame.commandBuffer, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+					VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+			}
+
+			vkEndCommandBuffer(frame.commandBuffer);
+
+			const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.waitSemaphoreCount = ctx->acquired ? 1u : 0u;
+			submitInfo.pWaitSemaphores = &frame.imageAvailable;
+			submitInfo.pWaitDstStageMask = &waitStage;
+			submitInfo.commandBufferCount = 1u;
+			submitInfo.pCommandBuffers = &frame.commandBuffer;
+			submitInfo.signalSemaphoreCount = ctx->acquired ? 1u : 0u;
+			submitInfo.pSignalSemaphores = &frame.renderFinished;
+
+			vkResetFences(vk.device, 1u, &frame.fence);
+			Check(vkQueueSubmit(vk.queue, 1u, &submitInfo, frame.fence), "vkQueueSubmit");
+
+			ctx->recording = false;
+			ctx->submitted = true;
+			ctx->lastFrame = ctx->frameIndex;
+		}
+
+		void Present(const CGRenderContext& context)
+		{
+			VulkanContext* ctx = GetContext(context);
+
+			if (!ctx || !ctx->submitted)
+			{
+				return;
+			}
+
+			if (ctx->acquired)
+			{
+				VkPresentInfoKHR presentInfo = {};
+				presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+				presentInfo.waitSemaphoreCount = 1u;
+				presentInfo.pWaitSemaphores = &ctx->frames[ctx->lastFrame].renderFinished;
+				presentInfo.swapchainCount = 1u;
+				presentInfo.pSwapchains = &ctx->swapchain;
+				presentInfo.pImageIndices = &ctx->imageIndex;
+
+				vkQueuePresentKHR(ctx->device->queue, &presentInfo);
+
+				ctx->acquired = false;
+			}
+
+			// The next frame records into the next slot while this one may still be in flight
+			ctx->frameIndex = (ctx->lastFrame + 1u) % CG_MAX_FRAMES_IN_FLIGHT;
+		}
+	}
+}